@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_CHECKPOINT_CHECKPOINT_HPP__
+#define __VP_CHECKPOINT_CHECKPOINT_HPP__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+namespace vp {
+
+  #define CHECKPOINT_MAGIC "GVSNAP01"
+  #define CHECKPOINT_PAGE_BITS 12
+  #define CHECKPOINT_PAGE_SIZE (1<<CHECKPOINT_PAGE_BITS)
+
+  // Binary snapshot of the simulator state.
+  // The file starts with a header giving the path of the parent snapshot in
+  // case this one is incremental, followed by one section per component,
+  // named after the component path and containing its registers, its pending
+  // events and the state saved by the component itself.
+  // Memories save their data as pages, which in an incremental snapshot are
+  // only the ones modified since the parent snapshot.
+  class checkpoint
+  {
+  public:
+
+    int open_write(std::string path, std::string parent);
+    int open_read(std::string path);
+    void close();
+
+    std::string get_parent() { return parent; }
+    bool is_incremental() { return parent != ""; }
+
+    inline bool has_error() { return this->error != ""; }
+    inline std::string get_error() { return this->error; }
+    void set_error(std::string error);
+
+    void begin_section(std::string name);
+    void end_section();
+
+    int enter_section(std::string name);
+    int leave_section();
+
+    inline void write(const void *data, size_t size);
+    inline void read(void *data, size_t size);
+
+    template<class T> inline void write(T value) { this->write(&value, sizeof(T)); }
+    template<class T> inline T read() { T value = 0; this->read(&value, sizeof(T)); return value; }
+
+    void write_str(std::string str);
+    std::string read_str();
+
+    // Save the pages of the specified area whose bit is set in the bitmap
+    void write_pages(uint8_t *data, uint64_t size, uint64_t *pages);
+
+    // Restore the saved pages and set their bit in the bitmap
+    void read_pages(uint8_t *data, uint64_t size, uint64_t *pages);
+
+    // Mark the pages covering the specified area in the bitmap
+    static inline void mark_pages(uint64_t *pages, uint64_t offset, uint64_t size);
+
+    static inline uint64_t *new_pages(uint64_t size);
+
+    static inline void clear_pages(uint64_t *pages, uint64_t size);
+
+  private:
+    FILE *file = NULL;
+    std::string path;
+    std::string parent;
+    std::string error;
+    long section_start;
+    uint64_t section_size;
+  };
+
+};
+
+inline void vp::checkpoint::write(const void *data, size_t size)
+{
+  if (fwrite(data, 1, size, this->file) != size)
+    this->set_error("failed to write to " + this->path);
+}
+
+inline void vp::checkpoint::read(void *data, size_t size)
+{
+  if (fread(data, 1, size, this->file) != size)
+    this->set_error("unexpected end of " + this->path);
+}
+
+inline void vp::checkpoint::mark_pages(uint64_t *pages, uint64_t offset, uint64_t size)
+{
+  uint64_t last_page = (offset + size - 1) >> CHECKPOINT_PAGE_BITS;
+  for (uint64_t page = offset >> CHECKPOINT_PAGE_BITS; page <= last_page; page++)
+  {
+    pages[page / 64] |= 1ULL << (page % 64);
+  }
+}
+
+inline uint64_t *vp::checkpoint::new_pages(uint64_t size)
+{
+  uint64_t nb_pages = (size + CHECKPOINT_PAGE_SIZE - 1) >> CHECKPOINT_PAGE_BITS;
+  return new uint64_t[(nb_pages + 63) / 64]();
+}
+
+inline void vp::checkpoint::clear_pages(uint64_t *pages, uint64_t size)
+{
+  uint64_t nb_pages = (size + CHECKPOINT_PAGE_SIZE - 1) >> CHECKPOINT_PAGE_BITS;
+  memset(pages, 0, (nb_pages + 63) / 64 * sizeof(uint64_t));
+}
+
+#endif
@@ -24,6 +24,7 @@
 #include "vp/vp_data.hpp"
 #include "vp/component.hpp"
 #include "vp/time/time_engine.hpp"
+#include "vp/profile/profiler.hpp"
 
 namespace vp {
 
@@ -69,15 +70,28 @@ namespace vp {
     clock_event *event_new(component_clock *comp, clock_event_meth_t *meth)
     {
       clock_event *event = new clock_event(comp, meth);
+      this->profile_event(event);
       return event;
     }
 
     clock_event *event_new(component_clock *comp, void *_this, clock_event_meth_t *meth)
     {
       clock_event *event = new clock_event(comp, _this, meth);
+      this->profile_event(event);
       return event;
     }
 
+    // The callback is replaced by the profiler stub when the profiler is
+    // enabled, so that the event execution is not slowed down otherwise
+    inline void profile_event(clock_event *event)
+    {
+      if (unlikely(profiler::is_enabled()))
+      {
+        event->profile_meth = event->meth;
+        event->meth = &clock_event::profile_stub;
+      }
+    }
+
     inline void retain() { engine->retain(); }
     inline void release() { engine->release(); }
 
@@ -94,7 +108,20 @@ namespace vp {
 
     void update();
 
-    void set_time_engine(vp::time_engine *engine) { this->engine = engine; }
+    void save(vp::checkpoint *checkpoint);
+
+    void restore(vp::checkpoint *checkpoint);
+
+    // Cycle count corresponding to the current time of the time engine, used
+    // to save pending events relative to the checkpoint time
+    int64_t get_checkpoint_cycles();
+
+    // Enqueue an event restored from a checkpoint. It always goes through
+    // the delayed queue so that the cycle count is resynchronized when the
+    // engine is executed.
+    clock_event *enqueue_restored(clock_event *event, int64_t cycles);
+
+    void set_time_engine(vp::time_engine *engine) { this->engine = engine; engine->reg_client(this); }
 
     vp::time_engine *get_engine() { return engine; }
 
@@ -125,6 +152,8 @@ namespace vp {
 
     clock_event *enqueue_other(clock_event *event, int64_t cycles);
 
+    void enqueue_to_delayed(clock_event *event, int64_t cycles);
+
     clock_event *event_queue[CLOCK_EVENT_QUEUE_SIZE];
     clock_event *delayed_queue = NULL;
     int current_cycle = 0;
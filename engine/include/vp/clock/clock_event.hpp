@@ -59,11 +59,16 @@ namespace vp {
     int64_t get_cycle() { return cycle; }
 
   private:
+    // Stub setup by the clock engine when the host-time profiler is enabled
+    static void profile_stub(void *_this, clock_event *event);
+
     uint8_t payload[CLOCK_EVENT_PAYLOAD_SIZE];
     void *args[CLOCK_EVENT_NB_ARGS];
     component_clock *comp;
     void *_this;
     clock_event_meth_t *meth;
+    // meth when the host-time profiler is enabled as a stub is setup instead
+    clock_event_meth_t *profile_meth;
     clock_event *next;
     bool enqueued;
     int64_t cycle;
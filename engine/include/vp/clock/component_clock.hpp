@@ -25,6 +25,7 @@
 #include "vp/itf/clk.hpp"
 #include "vp/clock/clock_event.hpp"
 #include "vp/itf/implem/wire_class.hpp"
+#include <vector>
 
 using namespace std;
 
@@ -79,6 +80,17 @@ namespace vp {
   protected:
     clock_engine *clock = NULL;
 
+    // Events created by the component, used for checkpointing. They are only
+    // tracked when a checkpoint is saved or restored, as some components
+    // allocate and free events for each request.
+    inline bool is_tracking_events();
+    int tracking_events = -1;
+    std::vector<clock_event *> events;
+
+    // Events to be enqueued once all components are restored from a
+    // checkpoint, with their remaining number of cycles
+    std::vector<std::pair<clock_event *, int64_t>> restored_events;
+
     clk_slave            clock_port;
     vp::wire_slave<bool> reset_port;
 
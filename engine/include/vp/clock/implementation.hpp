@@ -54,18 +54,47 @@ inline void vp::component_clock::event_reenqueue(vp::clock_event *event, int64_t
   clock->reenqueue(event, cycles);
 }
 
+inline bool vp::component_clock::is_tracking_events()
+{
+  if (unlikely(this->tracking_events == -1))
+  {
+    vp::time_engine *engine = clock->get_engine();
+    this->tracking_events = engine == NULL || engine->is_checkpoint_used();
+  }
+  return this->tracking_events;
+}
+
 inline vp::clock_event *vp::component_clock::event_new(vp::clock_event_meth_t *meth)
 {
-  return clock->event_new(this, meth);
+  vp::clock_event *event = clock->event_new(this, meth);
+  if (unlikely(this->is_tracking_events()))
+    this->events.push_back(event);
+  return event;
 }
 
 inline vp::clock_event *vp::component_clock::event_new(void *_this, vp::clock_event_meth_t *meth)
 {
-  return clock->event_new(this, _this, meth);
+  vp::clock_event *event = clock->event_new(this, _this, meth);
+  if (unlikely(this->is_tracking_events()))
+    this->events.push_back(event);
+  return event;
 }
 
 inline void vp::component_clock::event_del(vp::clock_event *event)
 {
+  // Events allocated dynamically are usually the last ones and are freed
+  // soon after their allocation, so look from the end
+  if (unlikely(this->is_tracking_events()))
+  {
+    for (int i=this->events.size()-1; i>=0; i--)
+    {
+      if (this->events[i] == event)
+      {
+        this->events.erase(this->events.begin() + i);
+        break;
+      }
+    }
+  }
   clock->event_del(this, event);
 }
 
@@ -34,6 +34,8 @@
 #include "vp/clock/component_clock.hpp"
 #include "vp/trace/component_trace.hpp"
 #include "vp/power/component_power.hpp"
+#include "vp/stats/component_stats.hpp"
+#include "vp/checkpoint/checkpoint.hpp"
 #include "json.hpp"
 #include <functional>
 
@@ -296,11 +298,30 @@ namespace vp {
     virtual string run() { return "error"; }
     virtual int run_status() { return 0; }
 
+    // Checkpointing. Registers and pending events are saved for all
+    // components, components with more state can save and restore it here.
+    // Post restore is called once the whole platform is restored, for state
+    // depending on other components.
+    virtual void save(vp::checkpoint *checkpoint) {}
+    virtual void restore(vp::checkpoint *checkpoint) {}
+    virtual void post_restore() {}
+
 
     void set_config(const char *config);
 
+    // The whole configuration can be parsed once and shared by all the
+    // components, which then get a read-only node of it instead of parsing
+    // their own copy. The node of the next component to be constructed
+    // is selected by path, a NULL configuration string then refers to it.
+    static int load_config_tree(const char *config);
+    static int select_config(const char *path);
+
     inline js::config *get_js_config() { return comp_js_config; }
 
+    // Same as get_js_config()->get(path), except that the result is
+    // memoized, as glob paths walk the whole configuration of the component
+    js::config *get_js_config(std::string path);
+
     inline config *get_config(std::string name);
 
 
@@ -333,6 +354,12 @@ namespace vp {
 
     void reset_all(bool active, bool from_itf=false);
 
+    void save_all(vp::checkpoint *checkpoint);
+
+    int restore_all(vp::checkpoint *checkpoint);
+
+    void post_restore_all();
+
     void new_master_port(std::string name, master_port *port);
 
     void new_master_port(void *comp, std::string name, master_port *port);
@@ -365,6 +392,7 @@ namespace vp {
 
     component_trace traces;
     component_power power;
+    component_stats stats;
 
     trace warning;
 
@@ -382,6 +410,7 @@ namespace vp {
   private:
 
     js::config *comp_js_config;
+    std::map<std::string, js::config *> js_config_lookups;
     trace root_trace;
 
 
@@ -24,6 +24,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "vp/jsmn.h"
 
@@ -45,11 +47,17 @@ namespace vp {
     virtual std::map<std::string, config *> get_childs() {
       return std::map<std::string, config *>();
     }
-    virtual vp::config *get_from_list(std::vector<std::string> name_list) {
+    // Resolve the path made of the names of name_list starting at index
+    virtual vp::config *get_from_list(const std::vector<std::string> &name_list, unsigned int index=0) {
       return NULL;
     }
     config *create_config(jsmntok_t *tokens, int *_size);
 
+    // Keys are interned so that they are compared and hashed as pointers.
+    // find_key returns NULL if no configuration has this key.
+    static const std::string *intern_key(const std::string &name);
+    static const std::string *find_key(const std::string &name);
+
   };
 
   class config_object : public config
@@ -59,12 +67,21 @@ namespace vp {
     config_object(jsmntok_t *tokens, int *size=NULL);
 
     config *get(std::string name);
-    vp::config *get_from_list(std::vector<std::string> name_list);
+    vp::config *get_from_list(const std::vector<std::string> &name_list, unsigned int index=0);
     std::map<std::string, config *> get_childs() { return childs; }
 
   private:
     std::map<std::string, config *> childs;
 
+    // Children in key order with their interned key, for glob lookups, and
+    // indexed by interned key for the other ones
+    std::vector<std::pair<const std::string *, config *>> ordered_childs;
+    std::unordered_map<const std::string *, config *> indexed_childs;
+
+    // Configurations are read-only, so the node found for each path can be
+    // kept, including for glob paths
+    std::unordered_map<std::string, config *> paths;
+
   };
 
   class config_array : public config
@@ -72,7 +89,7 @@ namespace vp {
 
   public:
     config_array(jsmntok_t *tokens, int *size=NULL);
-    vp::config *get_from_list(std::vector<std::string> name_list);
+    vp::config *get_from_list(const std::vector<std::string> &name_list, unsigned int index=0);
 
     int get_nb_elem() { return elems.size(); }
     config *get_elem(int index) {
@@ -88,7 +105,7 @@ namespace vp {
 
   public:
     config_string(jsmntok_t *tokens);
-    vp::config *get_from_list(std::vector<std::string> name_list);
+    vp::config *get_from_list(const std::vector<std::string> &name_list, unsigned int index=0);
     std::string get_str() { return value; }
     long long int get_int() { return strtoll(value.c_str(), NULL, 0); }
 
@@ -103,7 +120,7 @@ namespace vp {
   public:
     config_number(jsmntok_t *tokens);
     long long int get_int() { return (int)value; }
-    vp::config *get_from_list(std::vector<std::string> name_list);
+    vp::config *get_from_list(const std::vector<std::string> &name_list, unsigned int index=0);
 
   private:
     double value;
@@ -115,7 +132,7 @@ namespace vp {
 
   public:
     config_bool(jsmntok_t *tokens);
-    vp::config *get_from_list(std::vector<std::string> name_list);
+    vp::config *get_from_list(const std::vector<std::string> &name_list, unsigned int index=0);
     bool get_bool() { return (bool)value; }
 
   private:
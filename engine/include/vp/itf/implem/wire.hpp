@@ -84,8 +84,22 @@ namespace vp {
     // request. 
     // First synchronize the target engine in case it was left behind,
     // and then generate the normal call with the mux ID using the saved handler
-    if ( _this->remote_port->get_owner()->get_clock())
-      _this->remote_port->get_owner()->get_clock()->sync();
+    clock_engine *clock = _this->remote_port->get_owner()->get_clock();
+
+    // In parallel mode, the slave may be executed by another thread, the
+    // value is then delivered at the next quantum boundary.
+    if (clock && _this->get_owner()->get_clock() &&
+      unlikely(clock->get_engine() != _this->get_owner()->get_clock()->get_engine()))
+    {
+      clock->get_engine()->post([_this, value]() {
+        _this->remote_port->get_owner()->get_clock()->sync();
+        _this->sync_meth_freq_cross((component *)_this->slave_context_for_freq_cross, value);
+      });
+      return;
+    }
+
+    if (clock)
+      clock->sync();
     return _this->sync_meth_freq_cross((component *)_this->slave_context_for_freq_cross, value);
   }
 
@@ -95,7 +109,9 @@ namespace vp {
     // The normal callback was tweaked in order to get there when the master is sending a
     // request. 
     // First synchronize the target engine in case it was left behind,
-    // and then generate the normal call with the mux ID using the saved handler
+    // and then generate the normal call with the mux ID using the saved handler.
+    // In parallel mode, this synchronous call is not buffered as the value is
+    // needed immediately, so it should only be used inside a group.
     _this->remote_port->get_owner()->get_clock()->sync();
     return _this->sync_back_meth_freq_cross((component *)_this->slave_context_for_freq_cross, value);
   }
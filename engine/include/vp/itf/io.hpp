@@ -22,6 +22,8 @@
 #define __VP_ITF_IO_HPP__
 
 #include "vp/vp.hpp"
+#include "vp/profile/profiler.hpp"
+#include <string.h>
 
 namespace vp {
 
@@ -45,6 +47,9 @@ namespace vp {
   typedef void (io_resp_meth_t)(void *, io_req *);
   typedef void (io_grant_meth_t)(void *, io_req *);
 
+  typedef uint8_t *(io_backdoor_meth_t)(void *, uint64_t addr, uint64_t size, bool is_write);
+  typedef io_req_status_e (io_debug_meth_t)(void *, uint64_t addr, uint64_t size, bool is_write, uint8_t *data);
+
   class io_req
   {
     friend class io_master;
@@ -127,6 +132,9 @@ namespace vp {
     uint8_t payload[IO_REQ_PAYLOAD_SIZE];
     void *args[IO_REQ_NB_ARGS];
     int current_arg = 0;
+    // Set when a request crossing groups of clock domains in parallel mode
+    // was denied by the slave, while the master was told it is pending
+    bool cross_denied = false;
   };
 
 
@@ -153,6 +161,10 @@ namespace vp {
     bool is_bound();
 
     // Can be called by master component to send an IO request.  
+    // In parallel mode, a request crossing groups of clock domains is always
+    // answered with IO_REQ_PENDING, even if the slave handles it
+    // synchronously, as the slave is only called at the next quantum
+    // boundary. The response then comes through the response callback.
     inline io_req_status_e req(io_req *req);
 
     // Can be called by master component to forward an IO request.
@@ -166,6 +178,30 @@ namespace vp {
     // on which port the response will be sent back by the slave.
     inline io_req_status_e req(io_req *req, io_slave *slave_port);
 
+    // Can be called to get a direct pointer to the storage of the slave for
+    // the specified area, outside of any timing modeling, for example to
+    // load binaries. Returns NULL if the slave does not give access to its
+    // storage or if the area is not contiguous, in which case the normal
+    // requests must be used instead. is_write tells the slave that the area
+    // is about to be modified.
+    inline uint8_t *backdoor(uint64_t addr, uint64_t size, bool is_write);
+
+    // Same as above but on the specified slave port.
+    static inline uint8_t *backdoor(io_slave *port, uint64_t addr, uint64_t size, bool is_write);
+
+    // Can be called to read or write the slave storage in zero time, without
+    // modeling any timing nor updating any statistics, for example for
+    // debuggers or loaders. The access is synchronous and can cross
+    // interconnects, including interleaved ones. If the slave does not
+    // handle debug accesses, its backdoor is used instead, and if it does not
+    // have any, IO_REQ_INVALID is returned.
+    inline io_req_status_e debug_read(uint64_t addr, uint64_t size, uint8_t *data);
+    inline io_req_status_e debug_write(uint64_t addr, uint64_t size, uint8_t *data);
+    inline io_req_status_e debug(uint64_t addr, uint64_t size, bool is_write, uint8_t *data);
+
+    // Same as above but on the specified slave port.
+    static inline io_req_status_e debug(io_slave *port, uint64_t addr, uint64_t size, bool is_write, uint8_t *data);
+
 
 
     /*
@@ -235,6 +271,16 @@ namespace vp {
     // setup instead
     io_req_status_e (*req_meth_freq_cross)(void *, io_req *);
 
+    // req_meth when the host-time profiler is enabled as a stub is setup
+    // instead
+    io_req_status_e (*req_meth_profile)(void *, io_req *);
+
+    // Backdoor and debug callbacks of the slave and their context, kept
+    // apart from the request ones as they are never tweaked by the stubs
+    io_backdoor_meth_t *backdoor_meth = NULL;
+    void *backdoor_context = NULL;
+    io_debug_meth_t *debug_meth = NULL;
+
 
     /*
      * Stubs
@@ -250,6 +296,10 @@ namespace vp {
     // domain before we call it.
     static inline io_req_status_e req_freq_cross_stub(io_master *_this, io_req *req);
 
+    // This is a stub setup when the host-time profiler is enabled so that
+    // the time spent in the slave is accounted to it.
+    static inline io_req_status_e req_profile_stub(io_master *_this, io_req *req);
+
 
     /*
      * Internal data
@@ -268,6 +318,10 @@ namespace vp {
     // so that the stub is working well.
     void *slave_context_for_freq_cross = NULL;
 
+    // Slave context when the host-time profiler is enabled, for the same
+    // reason as above.
+    void *slave_context_for_profile = NULL;
+
     // This data is the multiplex ID that we need to send to the slave when the slave port
     // is multiplexed.
     int slave_req_mux_id = -1;
@@ -324,6 +378,15 @@ namespace vp {
     // when calling the callback, and can be used to multiplex a slave port
     inline void set_req_meth_muxed(io_req_meth_muxed_t *meth, int id);
 
+    // Set the callback on slave side called when the master is asking for
+    // a direct access to the slave storage. Before being set, the slave
+    // does not give any access.
+    inline void set_backdoor_meth(io_backdoor_meth_t *meth);
+
+    // Set the callback on slave side called when the master is doing a debug
+    // access. Before being set, debug accesses go through the backdoor.
+    inline void set_debug_meth(io_debug_meth_t *meth);
+
 
 
     /*
@@ -354,6 +417,10 @@ namespace vp {
     // Default request callback, just do nothing.
     static inline io_req_status_e req_default(io_slave *, io_req *);
 
+    // Backdoor and debug callbacks set by the user.
+    io_backdoor_meth_t *backdoor_meth = NULL;
+    io_debug_meth_t *debug_meth = NULL;
+
     // Multiplexed request callback set by the user.
     // Similar to the req callback but with an associated data.
     // This one gets called instead of the normal once in case it is not NULL
@@ -454,6 +521,72 @@ namespace vp {
 
 
 
+  inline uint8_t *io_master::backdoor(uint64_t addr, uint64_t size, bool is_write)
+  {
+    if (this->backdoor_meth == NULL) return NULL;
+    return this->backdoor_meth(this->backdoor_context, addr, size, is_write);
+  }
+
+
+
+  inline uint8_t *io_master::backdoor(io_slave *port, uint64_t addr, uint64_t size, bool is_write)
+  {
+    if (port->backdoor_meth == NULL) return NULL;
+    return port->backdoor_meth(port->get_context(), addr, size, is_write);
+  }
+
+
+
+  inline io_req_status_e io_master::debug(uint64_t addr, uint64_t size, bool is_write, uint8_t *data)
+  {
+    if (this->debug_meth)
+      return this->debug_meth(this->backdoor_context, addr, size, is_write, data);
+
+    uint8_t *storage = this->backdoor(addr, size, is_write);
+    if (storage == NULL) return IO_REQ_INVALID;
+
+    if (is_write)
+      memcpy(storage, data, size);
+    else
+      memcpy(data, storage, size);
+
+    return IO_REQ_OK;
+  }
+
+
+
+  inline io_req_status_e io_master::debug_read(uint64_t addr, uint64_t size, uint8_t *data)
+  {
+    return this->debug(addr, size, false, data);
+  }
+
+
+
+  inline io_req_status_e io_master::debug_write(uint64_t addr, uint64_t size, uint8_t *data)
+  {
+    return this->debug(addr, size, true, data);
+  }
+
+
+
+  inline io_req_status_e io_master::debug(io_slave *port, uint64_t addr, uint64_t size, bool is_write, uint8_t *data)
+  {
+    if (port->debug_meth)
+      return port->debug_meth(port->get_context(), addr, size, is_write, data);
+
+    uint8_t *storage = io_master::backdoor(port, addr, size, is_write);
+    if (storage == NULL) return IO_REQ_INVALID;
+
+    if (is_write)
+      memcpy(storage, data, size);
+    else
+      memcpy(data, storage, size);
+
+    return IO_REQ_OK;
+  }
+
+
+
   inline io_req *io_master::req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
   {
     // For now we allocate new requests but this would be better to manage a pool of requests
@@ -505,6 +638,10 @@ namespace vp {
     vp_assert(port != NULL, this->get_owner()->get_trace(),
       "Binding to NULL slave port\n");
 
+    this->backdoor_meth = port->backdoor_meth;
+    this->debug_meth = port->debug_meth;
+    this->backdoor_context = port->get_context();
+
     if (port->req_meth_mux == NULL)
     {
       // Normal binding, just register the method and context into the master
@@ -547,12 +684,49 @@ namespace vp {
     // request. 
     // First synchronize the target engine in case it was left behind,
     // and then generate the normal call with the mux ID using the saved handler
-    _this->remote_port->get_owner()->get_clock()->sync();
+    clock_engine *clock = _this->remote_port->get_owner()->get_clock();
+
+    // In parallel mode, the target may be executed by another thread. The
+    // request is then delivered at the next quantum boundary and the master
+    // gets the response asynchronously.
+    if (unlikely(clock->get_engine() != _this->get_owner()->get_clock()->get_engine()))
+    {
+      clock->get_engine()->post([_this, req]() {
+        _this->remote_port->get_owner()->get_clock()->sync();
+        io_req_status_e status = _this->req_meth_freq_cross((component *)_this->slave_context_for_freq_cross, req);
+        if (status == IO_REQ_OK || status == IO_REQ_INVALID)
+        {
+          req->status = status;
+          req->get_resp_port()->resp(req);
+        }
+        else if (status == IO_REQ_DENIED)
+        {
+          // The slave keeps the request until it grants it. As the master
+          // already considers it pending, the grant is not forwarded to it
+          // and it only gets the response.
+          req->cross_denied = true;
+        }
+      });
+      return IO_REQ_PENDING;
+    }
+
+    clock->sync();
     return _this->req_meth_freq_cross((component *)_this->slave_context_for_freq_cross, req);
   }
 
 
 
+  inline io_req_status_e io_master::req_profile_stub(io_master *_this, io_req *req)
+  {
+    profile_frame frame;
+    profiler::enter(&frame, _this->remote_port->get_owner(), PROFILE_REQ);
+    io_req_status_e status = _this->req_meth_profile((component *)_this->slave_context_for_profile, req);
+    profiler::leave(&frame);
+    return status;
+  }
+
+
+
   inline void io_master::finalize()
   {
     vp_assert(this->get_owner() != NULL, NULL,
@@ -579,6 +753,16 @@ namespace vp {
       this->slave_context_for_freq_cross = this->get_remote_context();
       this->set_remote_context(this);
     }
+
+    // Same for the profiler, which is then the first stub entered so that
+    // the synchronization of the slave domain is accounted to the slave
+    if (unlikely(profiler::is_enabled()))
+    {
+      this->req_meth_profile = this->req_meth;
+      this->req_meth = (io_req_meth_t *)&io_master::req_profile_stub;
+      this->slave_context_for_profile = this->get_remote_context();
+      this->set_remote_context(this);
+    }
   }
 
 
@@ -620,6 +804,20 @@ namespace vp {
 
 
 
+  inline void io_slave::set_backdoor_meth(io_backdoor_meth_t *meth)
+  {
+    this->backdoor_meth = meth;
+  }
+
+
+
+  inline void io_slave::set_debug_meth(io_debug_meth_t *meth)
+  {
+    this->debug_meth = meth;
+  }
+
+
+
   inline io_req_status_e io_slave::req_default(io_slave *, io_req *)
   {
     return IO_REQ_OK;
@@ -633,7 +831,25 @@ namespace vp {
     // request. 
     // First synchronize the target engine in case it was left behind,
     // and then generate the normal call with the mux ID using the saved handler
-    _this->remote_port->get_owner()->get_clock()->sync();
+    clock_engine *clock = _this->remote_port->get_owner()->get_clock();
+
+    // In parallel mode, the master may be executed by another thread, the
+    // call is then delivered at the next quantum boundary.
+    if (unlikely(clock->get_engine() != _this->get_owner()->get_clock()->get_engine()))
+    {
+      clock->get_engine()->post([_this, req]() {
+        if (req->cross_denied)
+        {
+          req->cross_denied = false;
+          return;
+        }
+        _this->remote_port->get_owner()->get_clock()->sync();
+        _this->master_grant_meth_freq_cross((component *)_this->master_context_for_freq_cross, req);
+      });
+      return;
+    }
+
+    clock->sync();
     _this->master_grant_meth_freq_cross((component *)_this->master_context_for_freq_cross, req);
   }
 
@@ -645,7 +861,20 @@ namespace vp {
     // request. 
     // First synchronize the target engine in case it was left behind,
     // and then generate the normal call with the mux ID using the saved handler
-    _this->remote_port->get_owner()->get_clock()->sync();
+    clock_engine *clock = _this->remote_port->get_owner()->get_clock();
+
+    // In parallel mode, the master may be executed by another thread, the
+    // call is then delivered at the next quantum boundary.
+    if (unlikely(clock->get_engine() != _this->get_owner()->get_clock()->get_engine()))
+    {
+      clock->get_engine()->post([_this, req]() {
+        _this->remote_port->get_owner()->get_clock()->sync();
+        _this->master_resp_meth_freq_cross((component *)_this->master_context_for_freq_cross, req);
+      });
+      return;
+    }
+
+    clock->sync();
     _this->master_resp_meth_freq_cross((component *)_this->master_context_for_freq_cross, req);
   }
 
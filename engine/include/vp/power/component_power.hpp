@@ -53,6 +53,10 @@ namespace vp {
 
     void reg_top_trace(vp::power_trace *trace);
 
+    // Set the temperature, voltage and frequency of all the power sources of
+    // the component
+    void set_operating_point(double temp, double volt, double freq);
+
   protected:
 
   private:
@@ -60,6 +64,8 @@ namespace vp {
 
     std::vector<power_trace *> traces;
 
+    std::vector<power_source *> sources;
+
     power_engine *power_manager = NULL;
   };
 
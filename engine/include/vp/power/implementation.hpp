@@ -33,6 +33,24 @@ inline void vp::power_trace::account_quantum(double quantum)
   this->trace.event_real_pulse(this->top->get_period(), quantum, 0);
 }
 
+inline void vp::power_source::account_event()
+{
+  if (!this->batched)
+  {
+    this->trace->account_quantum(this->quantum);
+    return;
+  }
+
+  int64_t time = this->top->get_time();
+  if (time != this->cycle_timestamp)
+  {
+    this->nb_events += this->cycle_events;
+    this->cycle_events = 0;
+    this->cycle_timestamp = time;
+  }
+  this->cycle_events++;
+}
+
 inline double vp::power_trace::get_value()
 {
   if (this->timestamp < this->top->get_time())
@@ -45,6 +63,7 @@ inline double vp::power_trace::get_value()
 
 inline double vp::power_trace::get_total()
 {
+  this->fold();
   this->account_power();
   return this->total;
 }
@@ -57,10 +76,26 @@ inline double vp::power_trace::get_total_leakage()
 
 inline void vp::power_trace::flush()
 {
+  this->fold();
   this->account_power();
   this->account_leakage_power();
 }
 
+inline void vp::power_trace::incr_top(double quantum, bool is_leakage)
+{
+  if (unlikely(this->deferred))
+  {
+    if (is_leakage)
+      this->deferred_leakage += quantum;
+    else
+      this->deferred_energy += quantum;
+  }
+  else
+  {
+    this->top_trace->incr(quantum, is_leakage);
+  }
+}
+
 inline void vp::power_trace::incr(double quantum, bool is_leakage)
 {
   this->get_value();
@@ -76,7 +111,7 @@ inline void vp::power_trace::incr(double quantum, bool is_leakage)
   }
 
   if (this->top_trace)
-    this->top_trace->incr(quantum, is_leakage);
+    this->incr_top(quantum, is_leakage);
 
   if (!is_leakage)
     this->trace.event_real_pulse(this->top->get_period(), this->value, 0);
@@ -23,6 +23,7 @@
 
 #include "json.hpp"
 #include "vp/vp_data.hpp"
+#include <tuple>
 
 namespace vp {
 
@@ -34,6 +35,8 @@ namespace vp {
 
   class power_engine;
 
+  class power_source;
+
   class power_trace
   {
   public:
@@ -70,11 +73,36 @@ namespace vp {
 
     void get(double *dynamic, double *leakage);
 
+    // Flush all the traces below this one, as they account their energy to
+    // their top trace
+    void flush_child_traces();
+
+    // Convert the events counted by the sources of this trace to energy.
+    // The events of the current cycle can be kept for the next capture.
+    void fold(bool current_cycle=true);
+
+    void reg_source(power_source *source) { this->sources.push_back(source); }
+
+    // Energy of folded events, which only goes to the totals
+    void account_energy(double energy);
+
+    // In parallel mode, the top trace may belong to another group of clock
+    // domains. The energy going to the top traces is then accumulated here,
+    // by the group executing this trace, and only folded into them when all
+    // groups are stopped. Their value of the current cycle is not updated.
+    void set_deferred(bool deferred) { this->deferred = deferred; }
+
+    // Fold the accumulated energy into all the top traces
+    void fold_deferred();
+
     vp::trace     trace;
 
   private:
     void account_power();
     void account_leakage_power();
+    inline void incr_top(double quantum, bool is_leakage);
+
+    std::vector<power_source *> sources;
 
     component *top;
     power_trace *top_trace = NULL;
@@ -92,6 +120,10 @@ namespace vp {
     int64_t current_leakage_power_timestamp;
 
     bool dumped;
+
+    bool deferred = false;
+    double deferred_energy = 0;
+    double deferred_leakage = 0;
   };
 
   class power_source
@@ -99,24 +131,45 @@ namespace vp {
     friend class component_power;
 
   public:
-    inline void account_event() { this->trace->account_quantum(this->quantum); }
+    inline void account_event();
     inline void power_on() { if (!this->is_on) this->trace->set_power(this->quantum, this->is_leakage); this->is_on = true; }
     inline void power_off() { if (this->is_on) this->trace->set_power(-this->quantum, this->is_leakage); this->is_on = false; }
 
     inline double get_quantum() { return this->quantum; }
 
+    // Account the energy of the events counted so far to the trace
+    void fold(bool current_cycle=true);
+
+    // Change the operating point, the events already accounted being folded
+    // with the previous quantum
+    void setup(double temp, double volt, double freq);
 
   protected:
     int init(component *top, std::string name, js::config *config, power_trace *trace, bool is_leakage);
-    void setup(double temp, double volt, double freq);
 
   private:
     Linear_table *table = NULL;
-    double quantum;
+    double quantum = 0;
     component *top;
     power_trace *trace;
     bool is_on = false;
     bool is_leakage;
+
+    // In batched mode, events are only counted and their energy is accounted
+    // when they are folded, and the value of the cycle is not updated for the
+    // waveforms. The events of the current cycle are kept apart so that they
+    // can go to the next capture, like the value of the cycle does in the
+    // default mode. As the energy is accounted as the number of events times
+    // the quantum, and not as one addition per event in the order of the
+    // events, the totals may differ from the default mode by rounding.
+    bool batched = false;
+    int64_t nb_events = 0;
+    int64_t cycle_events = 0;
+    int64_t cycle_timestamp = -1;
+
+    // Quantum of each operating point already used, to avoid interpolating
+    // the table again when going back to it
+    std::vector<std::tuple<double, double, double, double>> points;
   };
 
 };
@@ -29,6 +29,8 @@
 
 namespace vp {
 
+  class time_engine;
+
   class power_engine : public component
   {
   public:
@@ -39,6 +41,33 @@ namespace vp {
     virtual void stop_capture() {}
 
     virtual void reg_trace(vp::power_trace *trace) {}
+
+    // In batched mode, the power sources only count their events, which are
+    // converted to energy when the power is read
+    virtual bool is_batched() { return false; }
+
+    // Duration in picoseconds of the windows of the power profile, or 0 if
+    // it is disabled
+    virtual int64_t get_window() { return 0; }
+
+    // Close the current window of the power profile
+    virtual void window(int64_t time) {}
+
+    // Called by the time engine when groups of clock domains start running
+    // in parallel. The traces then accumulate the energy of their top traces
+    // and capture requests are delayed until the next synchronization.
+    virtual void start_parallel() {}
+
+    // Called by the time engine in parallel mode at each quantum boundary,
+    // when all groups are stopped
+    virtual void sync() {}
+
+    // Called by the time engine when it starts, so that the last window
+    // gets the simulated time
+    void set_time_engine(vp::time_engine *engine) { this->engine = engine; }
+
+  protected:
+    vp::time_engine *engine = NULL;
   };
 
 };
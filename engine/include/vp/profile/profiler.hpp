@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_PROFILE_PROFILER_HPP__
+#define __VP_PROFILE_PROFILER_HPP__
+
+#include <stdint.h>
+#include <string>
+
+namespace vp {
+
+  class component;
+  class profile_node;
+
+  #define PROFILE_EVENT 0
+  #define PROFILE_REQ   1
+
+  // Saved on the stack of the profiled call, between enter and leave
+  class profile_frame
+  {
+  public:
+    profile_node *parent;
+    uint64_t start;
+  };
+
+  // Host-time profiler.
+  // When enabled, which must be done before the components are built, clock
+  // events and io requests get their callback replaced by a stub entering
+  // the profiler, in the same way as for the stubs crossing frequency
+  // domains. Nothing is executed for the profiler when it is disabled.
+  // Each thread records a tree of calls, so that the time spent in a
+  // component can be reported both per component and per call stack.
+  class profiler
+  {
+  public:
+
+    static inline bool is_enabled() { return enabled; }
+
+    static void enable();
+
+    static void enter(profile_frame *frame, component *comp, int kind);
+
+    static void leave(profile_frame *frame);
+
+    // Dump the per-component report, sorted by self time, to the specified
+    // file or stdout if empty, and the stacks in the folded format used by
+    // flamegraph.pl if the path is not empty
+    static void dump(std::string report_path, std::string folded_path);
+
+  private:
+    static bool enabled;
+  };
+
+};
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_STATS_COMPONENT_STATS_HPP__
+#define __VP_STATS_COMPONENT_STATS_HPP__
+
+#include "vp/stats/stats.hpp"
+#include <vector>
+
+namespace vp {
+
+  class component;
+  class stats_engine;
+
+  class component_stats
+  {
+
+  public:
+
+    component_stats(component &top);
+
+    void post_post_build();
+
+    void new_stat(std::string name, stat_scalar *stat);
+
+    void new_stat(std::string name, stat_rate *stat);
+
+    // Histogram with nb_buckets buckets of bucket_width values, or of powers
+    // of 2 if bucket_width is 0
+    void new_stat(std::string name, stat_histogram *stat, int nb_buckets, int64_t bucket_width=0);
+
+    stats_engine *get_engine() { return stats_manager; }
+
+  protected:
+
+    std::vector<stat *> stats;
+    stats_engine *stats_manager = NULL;
+
+  private:
+    void init_stat(stat *stat, std::string name, stat_type_e type);
+
+    component &top;
+
+  };
+
+};
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_STATS_STATS_HPP__
+#define __VP_STATS_STATS_HPP__
+
+#include <stdint.h>
+#include <string>
+#include <functional>
+
+namespace vp {
+
+  class component;
+
+  typedef enum {
+    STAT_SCALAR,
+    STAT_RATE,
+    STAT_HISTOGRAM
+  } stat_type_e;
+
+  // Statistics are plain counters owned by the models and registered to the
+  // stats engine, which reads them when it dumps them. Updating them is just
+  // an addition, there is no virtual call and no check.
+  // They are named after the component path, e.g.
+  // /sys/board/chip/soc/l2/nb_read.
+  class stat
+  {
+
+    friend class component_stats;
+
+  public:
+
+    inline stat_type_e get_type() { return this->type; }
+
+    inline std::string get_name() { return this->name; }
+
+    inline component *get_comp() { return this->comp; }
+
+  protected:
+    stat_type_e type;
+    std::string name;
+    component *comp = NULL;
+  };
+
+
+  // Counter dumped with its current value.
+  class stat_scalar : public stat
+  {
+  public:
+
+    inline void inc(int64_t incr=1) { this->value += incr; }
+
+    inline void set(int64_t value) { this->value = value; }
+
+    inline int64_t get() { return this->sampler ? this->sampler() : this->value; }
+
+    // For counters already maintained by the model, the value is read from
+    // the callback when the stat is dumped instead of being incremented
+    void set_sampler(std::function<int64_t()> sampler) { this->sampler = sampler; }
+
+  protected:
+    int64_t value = 0;
+    std::function<int64_t()> sampler = NULL;
+  };
+
+
+  // Counter dumped as the number of increments per second of simulated time
+  // since the previous dump.
+  class stat_rate : public stat_scalar
+  {
+
+    friend class component_stats;
+
+  public:
+
+    // Return the rate since the previous call and start a new period
+    inline double sample(int64_t time);
+
+  private:
+    int64_t last_value = 0;
+    int64_t last_time = 0;
+  };
+
+
+  // Distribution of values, either in buckets of the same width, or in
+  // power-of-2 buckets when the width is 0. Values beyond the last bucket
+  // are accounted in the last bucket.
+  class stat_histogram : public stat
+  {
+
+    friend class component_stats;
+
+  public:
+
+    inline void add(int64_t value);
+
+    inline int get_nb_buckets() { return this->nb_buckets; }
+
+    inline int64_t get_bucket(int index) { return this->buckets[index]; }
+
+    // Lower bound of the values of a bucket
+    inline int64_t get_bucket_base(int index);
+
+    inline int64_t get_count() { return this->count; }
+
+    inline int64_t get_sum() { return this->sum; }
+
+  private:
+    int nb_buckets;
+    int64_t bucket_width;
+    int64_t *buckets;
+    int64_t count = 0;
+    int64_t sum = 0;
+  };
+
+
+  inline double stat_rate::sample(int64_t time)
+  {
+    int64_t value = this->get();
+    double rate = time > this->last_time ?
+      (value - this->last_value) * 1e12 / (time - this->last_time) : 0;
+    this->last_value = value;
+    this->last_time = time;
+    return rate;
+  }
+
+
+  inline void stat_histogram::add(int64_t value)
+  {
+    int index;
+
+    if (this->bucket_width)
+      index = value <= 0 ? 0 : value / this->bucket_width;
+    else
+      index = value <= 0 ? 0 : 64 - __builtin_clzll(value);
+
+    if (index >= this->nb_buckets)
+      index = this->nb_buckets - 1;
+
+    this->buckets[index]++;
+    this->count++;
+    this->sum += value;
+  }
+
+
+  inline int64_t stat_histogram::get_bucket_base(int index)
+  {
+    if (this->bucket_width)
+      return index * this->bucket_width;
+    else
+      return index == 0 ? 0 : 1LL << (index - 1);
+  }
+
+};
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_STATS_ENGINE_HPP__
+#define __VP_STATS_ENGINE_HPP__
+
+#include "vp/vp_data.hpp"
+#include "vp/component.hpp"
+#include "vp/stats/stats.hpp"
+
+namespace vp {
+
+  class time_engine;
+
+  class stats_engine : public component
+  {
+  public:
+    stats_engine(const char *config);
+
+    virtual void reg_stat(vp::stat *stat) {}
+
+    // Period in picoseconds of the periodic dumps, or 0 if the stats are
+    // only dumped at the end of the simulation
+    virtual int64_t get_period() { return 0; }
+
+    // Dump all the stats, the time being the current simulated time
+    virtual void dump(int64_t time) {}
+
+    // Called by the time engine when it starts, so that the final dump
+    // gets the simulated time
+    void set_time_engine(vp::time_engine *engine) { this->engine = engine; }
+
+  protected:
+    vp::time_engine *engine = NULL;
+  };
+
+};
+
+#endif
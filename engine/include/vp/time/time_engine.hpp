@@ -23,6 +23,8 @@
 
 #include "vp/vp_data.hpp"
 #include "vp/component.hpp"
+#include <functional>
+#include <vector>
 
 #ifdef __VP_USE_SYSTEMC
 #include <systemc.h>
@@ -33,13 +35,21 @@
 namespace vp {
 
   class time_engine_client;
+  class power_engine;
 
   class time_engine : public component {
   public:
     time_engine(const char *config);
 
+    // Constructor for the engines of the groups of clock domains in
+    // parallel mode
+    time_engine(time_engine *parent, int id);
+
     void start();
 
+    // Terminates the threads of the groups of clock domains in parallel mode
+    void stop();
+
     void run_loop();
 
     string run();
@@ -66,16 +76,65 @@ namespace vp {
 
     int64_t get_time() { return time; }
 
-    inline void retain() { retain_count++; }
-    inline void release() { retain_count--; }
+    inline void retain();
+    inline void release();
 
     inline void fatal(const char *fmt, ...);
 
+    // The time engine has no clock, so its warnings cannot go through the
+    // component warning trace
+    inline void engine_warning(const char *fmt, ...);
+
     inline void update(int64_t time);
 
     void wait_ready();
-    
+
+    // Called by clock engines when they are attached to this engine, so that
+    // they can be dispatched to groups in parallel mode
+    void reg_client(time_engine_client *client);
+
+    // Called on the engine of the component which must execute the callback,
+    // when a call between 2 components is crossing groups of clock domains in
+    // parallel mode. The call is buffered by the calling group and executed at
+    // the next quantum boundary, when all groups are stopped.
+    inline void post(std::function<void()> callback);
+
+    void save(vp::checkpoint *checkpoint);
+
+    void restore(vp::checkpoint *checkpoint);
+
+    // Save the state of the whole platform. The checkpoint is incremental
+    // if a parent checkpoint is given, and then only contains the memory
+    // pages modified since the parent was saved or restored.
+    int save_checkpoint(std::string path, std::string parent="");
+
+    // Restore the state of the whole platform, including the parent
+    // checkpoints in case it is incremental
+    int restore_checkpoint(std::string path);
+
+    // Tell if a checkpoint is to be saved, so that memories only track the
+    // pages they modify when needed
+    bool is_checkpoint_enabled();
+
+    // Tell if a checkpoint is to be saved or restored, so that components
+    // only track their events when needed
+    bool is_checkpoint_used();
+
+    // Tell if some clients have events pending, apart from the one being
+    // executed and from the passive ones
+    bool has_clients();
+
   private:
+    static void *group_routine(void *arg);
+    void parallel_init();
+    void run_parallel();
+    void run_group(int64_t end_time);
+    void checkpoint_init();
+    void stats_init();
+    void power_init();
+    int load_checkpoint(std::string path);
+    static bool has_active_clients(time_engine_client *client);
+
     time_engine_client *first_client = NULL;
     bool locked = false;
     bool locked_run_req;
@@ -98,6 +157,36 @@ namespace vp {
     int retain_count = 0;
     bool no_exit;
 
+    // Parallel mode. Clock domains are dispatched to groups, each one
+    // having its own engine executed by its own thread. Groups are executed
+    // in lock-step quanta and cross-group calls are delivered at quantum
+    // boundaries in a fixed order, so that the execution is deterministic
+    // for a given quantum.
+    bool parallel = false;
+    int64_t quantum;
+    time_engine *parent = NULL;
+    int group_id = 0;
+    std::vector<time_engine *> groups;
+    std::vector<time_engine_client *> clients;
+    // Calls posted to this engine, one list per calling group, so that each
+    // list is only written by one thread
+    std::vector<std::vector<std::function<void()>>> posted_calls;
+    std::vector<pthread_t> group_threads;
+    bool groups_exit = false;
+    bool killed = false;
+    // Group executed by the current thread, if any
+    static thread_local time_engine *current_group;
+    bool delivering = false;
+    bool parallel_started = false;
+    int64_t window_end;
+    power_engine *power = NULL;
+    pthread_barrier_t window_start_barrier;
+    pthread_barrier_t window_end_barrier;
+
+    std::string checkpoint_restore;
+    int checkpoint_enabled = -1;
+    int checkpoint_used = -1;
+
 #ifdef __VP_USE_SYSTEMC
     sc_event sync_event;
     bool started = false;
@@ -137,6 +226,10 @@ namespace vp {
     vp::time_engine *engine;
     bool running = false;
     bool is_enqueued = false;
+
+    // Passive clients, like the periodic services, do not keep the
+    // simulation alive and are ignored by has_clients
+    bool passive = false;
   };
 
 
@@ -144,6 +237,12 @@ namespace vp {
   // to the main python thread which will take care of stopping the engine.
   inline void vp::time_engine::stop_engine(bool force)
   {
+    if (this->parent)
+    {
+      this->parent->stop_engine(force);
+      return;
+    }
+
     if (force || !this->no_exit)
     {
       // In case the vp is connected to an external bridge, prevent the platform
@@ -157,6 +256,12 @@ namespace vp {
 
   inline void vp::time_engine::stop_engine(int status)
   {
+    if (this->parent)
+    {
+      this->parent->stop_engine(status);
+      return;
+    }
+
     stop_status = status;
 #ifdef __VP_USE_SYSTEMC
     sync_event.notify();
@@ -166,6 +271,12 @@ namespace vp {
 
   inline void vp::time_engine::wait_running()
   {
+    if (this->parent)
+    {
+      this->parent->wait_running();
+      return;
+    }
+
     pthread_mutex_lock(&mutex);
     while (!init) pthread_cond_wait(&cond, &mutex);
     pthread_mutex_unlock(&mutex);
@@ -173,6 +284,12 @@ namespace vp {
 
   inline void vp::time_engine::lock_step()
   {
+    if (this->parent)
+    {
+      this->parent->lock_step();
+      return;
+    }
+
     if (!locked)
     {
       locked = true;
@@ -183,6 +300,12 @@ namespace vp {
 
   inline void vp::time_engine::lock_step_cancel()
   {
+    if (this->parent)
+    {
+      this->parent->lock_step_cancel();
+      return;
+    }
+
     pthread_mutex_lock(&mutex);
     if (locked)
     {
@@ -195,6 +318,12 @@ namespace vp {
 
   inline void vp::time_engine::lock()
   {
+    if (this->parent)
+    {
+      this->parent->lock();
+      return;
+    }
+
     pthread_mutex_lock(&mutex);
     if (!locked)
     {
@@ -209,6 +338,12 @@ namespace vp {
 
   inline void vp::time_engine::unlock()
   {
+    if (this->parent)
+    {
+      this->parent->unlock();
+      return;
+    }
+
     pthread_mutex_lock(&mutex);
     run_req = locked_run_req;
     locked = false;
@@ -226,6 +361,43 @@ namespace vp {
     stop_engine(-1);
   }
 
+  inline void vp::time_engine::engine_warning(const char *fmt, ...)
+  {
+    fprintf(stdout, "[\033[31mWARNING\033[0m] ");
+    va_list ap;
+    va_start(ap, fmt);
+    if (vfprintf(stdout, fmt, ap) < 0) {}
+    va_end(ap);
+  }
+
+
+  inline void vp::time_engine::retain()
+  {
+    // Groups may retain the engine concurrently in parallel mode
+    if (this->parent)
+      this->parent->retain();
+    else
+      __atomic_add_fetch(&retain_count, 1, __ATOMIC_SEQ_CST);
+  }
+
+  inline void vp::time_engine::release()
+  {
+    if (this->parent)
+      this->parent->release();
+    else
+      __atomic_sub_fetch(&retain_count, 1, __ATOMIC_SEQ_CST);
+  }
+
+  inline void vp::time_engine::post(std::function<void()> callback)
+  {
+    // Calls posted while the coordinator is delivering buffered calls or
+    // while no group is running are executed immediately as all groups are
+    // stopped, as well as calls posted by the group executing this engine.
+    if (this->parent == NULL || this->parent->delivering || current_group == NULL || current_group == this)
+      callback();
+    else
+      this->posted_calls[current_group->group_id].push_back(callback);
+  }
 
   inline void vp::time_engine::update(int64_t time)
   {
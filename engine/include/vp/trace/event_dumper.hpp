@@ -22,6 +22,7 @@
 #define __VP_TRACE_EVENT_DUMPER_HPP__
 
 #include <stdio.h>
+#include <vector>
 
 namespace vp {
 
@@ -117,6 +118,58 @@ namespace vp {
     std::vector<uint32_t> vars;
   };
 
+
+  // Compact binary format for offline analysis. Traces are described by
+  // schema records, value changes are stored as varints in chunks which can
+  // be decoded independently, and an index of the chunks at the end of the
+  // file allows seeking to a given time. See engine/python/gvt.py for the
+  // reader and the layout.
+  class Gvt_file : public Event_file
+  {
+  public:
+    Gvt_file(Event_dumper *dumper, string path);
+    void close();
+    void add_trace(string name, int id, int width, bool is_real, bool is_string);
+    void dump(int64_t timestamp, int id, uint8_t *event, int width, bool is_real, bool is_string);
+
+  private:
+    void put_varint(std::vector<uint8_t> &buffer, uint64_t value);
+    void put_schema(std::vector<uint8_t> &buffer, int index);
+    void flush_chunk();
+    void write(std::vector<uint8_t> &buffer);
+
+    struct gvt_trace
+    {
+      std::string path;
+      int id;
+      int type;
+      int width;
+    };
+
+    struct gvt_chunk
+    {
+      int64_t offset;
+      int64_t start;
+      int64_t end;
+      int64_t nb_events;
+    };
+
+    std::vector<gvt_trace> traces;
+    std::vector<gvt_chunk> chunks;
+    // Indexed by trace id, last value of each trace in the current chunk,
+    // and chunk where it was set, as deltas restart from 0 in each chunk
+    std::vector<uint64_t> last_values;
+    std::vector<int64_t> last_values_chunk;
+    std::vector<int> trace_types;
+
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> block;
+    int64_t chunk_size;
+    int64_t chunk_start;
+    int64_t chunk_nb_events;
+    int64_t offset;
+  };
+
 };
 
 #endif
@@ -30,7 +30,7 @@ namespace vp {
   inline void vp::trace::event(uint8_t *value)
   {
   #ifdef VP_TRACE_ACTIVE
-    if (is_event_active)
+    if (__builtin_expect(is_event_active, 0))
     {
       trace_manager->dump_event(this, comp->get_clock()->get_time(), value, bytes);
     }
@@ -40,7 +40,7 @@ namespace vp {
   inline void vp::trace::event_pulse(int64_t duration, uint8_t *pulse_value, uint8_t *background_value)
   {
   #ifdef VP_TRACE_ACTIVE
-    if (is_event_active)
+    if (__builtin_expect(is_event_active, 0))
     {
       trace_manager->dump_event_pulse(this, comp->get_clock()->get_time(), comp->get_clock()->get_time() + duration, pulse_value, background_value, bytes);
     }   
@@ -50,7 +50,7 @@ namespace vp {
   inline void vp::trace::event_string(std::string value, int size)
   {
   #ifdef VP_TRACE_ACTIVE
-    if (is_event_active)
+    if (__builtin_expect(is_event_active, 0))
     {
       trace_manager->dump_event_string(this, comp->get_clock()->get_time(), (uint8_t *)value.c_str(), size);
     }   
@@ -60,7 +60,7 @@ namespace vp {
   inline void vp::trace::event_real(double value)
   {
   #ifdef VP_TRACE_ACTIVE
-    if (is_event_active)
+    if (__builtin_expect(is_event_active, 0))
     {
       trace_manager->dump_event(this, comp->get_clock()->get_time(), (uint8_t *)&value, 8);
     }  	
@@ -70,7 +70,7 @@ namespace vp {
   inline void vp::trace::event_real_pulse(int64_t duration, double pulse_value, double background_value)
   {
   #ifdef VP_TRACE_ACTIVE
-    if (is_event_active)
+    if (__builtin_expect(is_event_active, 0))
     {
       trace_manager->dump_event_pulse(this, comp->get_clock()->get_time(), comp->get_clock()->get_time() + duration, (uint8_t *)&pulse_value, (uint8_t *)&background_value, 8);
     }   
@@ -80,7 +80,7 @@ namespace vp {
   inline void vp::trace::event_real_delayed(double value)
   {
   #ifdef VP_TRACE_ACTIVE
-    if (is_event_active)
+    if (__builtin_expect(is_event_active, 0))
     {
       trace_manager->dump_event_delayed(this, comp->get_clock()->get_time(), (uint8_t *)&value, 8);
     }   
@@ -100,6 +100,12 @@ namespace vp {
 
   inline void vp::trace::fatal(const char *fmt, ...)
   {
+    // Messages still queued to the trace engine must appear before the
+    // fatal one
+    trace_engine *engine = comp->traces.get_trace_manager();
+    if (engine && engine->is_text_async())
+      engine->flush();
+
     dump_fatal_header();
     va_list ap;
     va_start(ap, fmt);
@@ -110,10 +116,18 @@ namespace vp {
 
   inline void vp::trace::force_warning(const char *fmt, ...)
   {
-    dump_warning_header();
     va_list ap;
     va_start(ap, fmt);
-    if (vfprintf(stdout, fmt, ap) < 0) {}
+    trace_engine *engine = comp->traces.get_trace_manager();
+    if (engine && engine->is_text_async())
+    {
+      engine->dump_msg(this, true, fmt, ap);
+    }
+    else
+    {
+      dump_warning_header();
+      if (vfprintf(stdout, fmt, ap) < 0) {}
+    }
     va_end(ap);
     #if 0
     printf("%ld: %ld: [\033[31m%-*.*s\033[0m] ", comp->get_clock()->get_time(), comp->get_clock()->get_cycles(), max_trace_len, max_trace_len, comp->get_path());
@@ -127,10 +141,18 @@ namespace vp {
 
   inline void vp::trace::warning(const char *fmt, ...) {
   #ifdef VP_TRACE_ACTIVE
-    dump_warning_header();
     va_list ap;
     va_start(ap, fmt);
-    if (vfprintf(stdout, fmt, ap) < 0) {}
+    trace_engine *engine = comp->traces.get_trace_manager();
+    if (engine && engine->is_text_async())
+    {
+      engine->dump_msg(this, true, fmt, ap);
+    }
+    else
+    {
+      dump_warning_header();
+      if (vfprintf(stdout, fmt, ap) < 0) {}
+    }
     va_end(ap);
   #else
   #endif
@@ -144,18 +166,33 @@ namespace vp {
     #endif
   }
 
-  inline void vp::trace::msg(const char *fmt, ...) 
+  template<typename... Args> inline void vp::trace::msg(const char *fmt, Args... args)
   {
   #ifdef VP_TRACE_ACTIVE
-  	if (is_active && comp->traces.get_trace_manager()->get_trace_level() >= this->level)
+    if (__builtin_expect(is_active, 0))
+    {
+      this->dump_msg(fmt, args...);
+    }
+  #endif
+  }
+
+  inline void vp::trace::dump_msg(const char *fmt, ...)
+  {
+  	if (comp->traces.get_trace_manager()->get_trace_level() >= this->level)
     {
-      dump_header();
       va_list ap;
       va_start(ap, fmt);
-      if (vfprintf(stdout, fmt, ap) < 0) {}
+      if (comp->traces.get_trace_manager()->is_text_async())
+      {
+        comp->traces.get_trace_manager()->dump_msg(this, false, fmt, ap);
+      }
+      else
+      {
+        dump_header();
+        if (vfprintf(stdout, fmt, ap) < 0) {}
+      }
       va_end(ap);  
     }
-  #endif
   }
 
 
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_TRACE_TEXT_SINK_HPP__
+#define __VP_TRACE_TEXT_SINK_HPP__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <zlib.h>
+
+namespace vp {
+
+  // Output of the text traces when they are dumped asynchronously by the
+  // trace engine thread. Writes to stdout or to a file, optionally gzip
+  // compressed, and can rotate the file when it reaches a given size.
+  // Only used from the trace engine thread.
+  class trace_text_sink
+  {
+  public:
+    // An empty path means stdout. With rotate_size not 0, the file is
+    // continued in path.1, path.2 and so on each time it reaches this size.
+    void open(std::string path, int64_t rotate_size, bool gzip);
+    void close();
+    void flush();
+
+    void write(const char *str, int len);
+
+    // Called after each message, so that rotation never splits a message
+    void message_done();
+
+    // Colors are only used on stdout
+    bool use_colors() { return this->path == ""; }
+
+  private:
+    void open_file();
+    void close_file();
+
+    std::string path;
+    int64_t rotate_size = 0;
+    bool gzip = false;
+    int index = 0;
+    int64_t size = 0;
+    FILE *file = NULL;
+    gzFile gz_file = NULL;
+  };
+
+};
+
+#endif
@@ -39,7 +39,9 @@ namespace vp {
 
   public:
 
-    inline void msg(const char *fmt, ...);
+    // Trace points are inlined down to a single branch on the trace state,
+    // the message is only formatted by dump_msg once the trace is enabled
+    template<typename... Args> inline void msg(const char *fmt, Args... args);
     inline void user_msg(const char *fmt, ...);
     inline void warning(const char *fmt, ...);
     inline void force_warning(const char *fmt, ...);
@@ -54,6 +56,7 @@ namespace vp {
 
     inline string get_name() { return this->name; }
 
+    void dump_msg(const char *fmt, ...);
     void dump_header();
     void dump_warning_header();
     void dump_fatal_header();
@@ -65,8 +68,8 @@ namespace vp {
     inline bool get_active() { return false; }
     inline bool get_event_active() { return false; }
   #else
-    inline bool get_active() { return is_active; }
-    inline bool get_event_active() { return is_event_active; }
+    inline bool get_active() { return __builtin_expect(is_active, 0); }
+    inline bool get_event_active() { return __builtin_expect(is_event_active, 0); }
   #endif
     bool is_active = false;
 
@@ -85,8 +88,8 @@ namespace vp {
     string name;
     uint8_t *buffer = NULL;
     uint8_t *buffer2 = NULL;
-    trace *next;
-    trace *prev;
+    // Position in the pending pulse heap of the trace engine
+    int pending_index;
     int64_t pending_timestamp;
   };    
 
@@ -112,7 +115,9 @@ namespace vp {
       abort();                                     \
     }
 
-#ifndef VP_TRACE_ACTIVE
+// Assertions are only checked in debug builds, not in builds with traces
+// enabled at runtime
+#if !defined(VP_TRACE_ACTIVE) || defined(VP_TRACE_RUNTIME)
 #define vp_assert(cond, trace, msg...)
 #else
 #define vp_assert(cond, trace_ptr, msg...) vp_assert_always(cond, trace_ptr, msg)
@@ -24,16 +24,85 @@
 #include "vp/vp_data.hpp"
 #include "vp/component.hpp"
 #include "vp/trace/trace.hpp"
+#include "vp/trace/text_sink.hpp"
 #include <pthread.h>
+#include <stdarg.h>
 #include <thread>
+#include <atomic>
 
 namespace vp {
 
-  #define TRACE_EVENT_BUFFER_SIZE (1<<16)
-  #define TRACE_EVENT_NB_BUFFER   4
+  // Default size in bytes of the ring of each producer thread
+  #define TRACE_RING_SIZE (1<<20)
+
+  // Maximum number of threads dumping events
+  #define TRACE_MAX_RINGS 64
+
+  // Records are made of a header with the trace, the timestamp and the size
+  // of the value, followed by the value, and are aligned on 8 bytes.
+  #define TRACE_RECORD_HEADER_SIZE 20
+  #define TRACE_RECORD_SIZE(bytes) ((TRACE_RECORD_HEADER_SIZE + (bytes) + 7) & ~7)
+
+  // Flags in the size field of records holding text messages instead of
+  // event values
+  #define TRACE_RECORD_TEXT       0x80000000
+  #define TRACE_RECORD_WARNING    0x40000000
+  #define TRACE_RECORD_SIZE_MASK  0x3fffffff
+
+  // Text messages of up to this size are formatted only once, directly in
+  // the ring
+  #define TRACE_TEXT_INLINE_SIZE 256
+
+  class trace_engine;
+
+  // Lock-free single-producer single-consumer ring of event records. Each
+  // thread dumping events has its own ring, which is drained by the event
+  // dumper thread.
+  // Head and tail are byte counters which are never wrapped, the position
+  // in the buffer is obtained with the mask. A record which does not fit
+  // before the end of the buffer is preceded by a wrap record with a NULL
+  // trace.
+  class trace_ring
+  {
+    friend class trace_engine;
+
+  public:
+    trace_ring(trace_engine *engine, int size);
+
+    inline char *reserve(int bytes);
+    inline void commit(int bytes);
+
+  private:
+    void wait_space(uint64_t needed);
+
+    trace_engine *engine;
+    char *buffer;
+    uint64_t size;
+    uint64_t mask;
+
+    // Producer and consumer fields are kept on separate cache lines
+    char pad0[64];
+
+    // Only written by the producer, with the backpressure statistics
+    std::atomic<uint64_t> head;
+    uint64_t cached_tail = 0;
+    uint64_t nb_records = 0;
+    uint64_t nb_bytes = 0;
+    uint64_t max_fill = 0;
+    uint64_t nb_full = 0;
+    int64_t full_time = 0;
+
+    char pad1[64];
+
+    // Only written by the consumer
+    std::atomic<uint64_t> tail;
+    uint64_t nb_drained = 0;
+  };
 
   class trace_engine : public component
   {
+    friend class trace_ring;
+
   public:
     trace_engine(const char *config);
 
@@ -52,30 +121,124 @@ namespace vp {
 
     void dump_event_delayed(vp::trace *trace, int64_t timestamp, uint8_t *event, int width);
 
+    // Text messages are formatted by the caller and go through the trace
+    // rings, the header is formatted and the message written by the
+    // trace engine thread
+    inline bool is_text_async() { return this->text_async; }
+    void dump_msg(vp::trace *trace, bool warning, const char *fmt, va_list ap);
+
+    // Waits until the trace engine thread has written all pending messages
+    void flush();
+
     Event_dumper event_dumper;
 
   private:
     void enqueue_pending(vp::trace *trace, int64_t timestamp, uint8_t *event);
-    char *get_event_buffer(int bytes);
+    void pending_sift_up(int index);
+    void pending_sift_down(int index);
+    void pending_remove(vp::trace *trace);
+    inline trace_ring *get_ring();
+    trace_ring *new_ring();
+    void wakeup_consumer();
     void vcd_routine();
-    void flush();
+    bool drain_rings(int64_t *last_timestamp);
+    void dump_record(char *record, int64_t *last_timestamp);
+    void dump_text_record(char *record, uint32_t flags);
+    void dump_ring_stats();
     void check_pending_events(int64_t timestamp);
-    void dump_event_to_buffer(vp::trace *trace, int64_t timestamp, uint8_t *event, int bytes, bool include_size=false);
+    void dump_event_to_buffer(vp::trace *trace, int64_t timestamp, uint8_t *event, int bytes);
     void flush_Event_traces(int64_t timestamp);
 
-    vector<char *> event_buffers;
-    vector<char *> ready_event_buffers;
-    char *current_buffer;
-    int current_buffer_size;
+    trace_ring *rings[TRACE_MAX_RINGS];
+    std::atomic<int> nb_rings;
+    int ring_size;
+    bool ring_stats;
+
+    // Output files of the host-time profiler, which is reported when the
+    // engine is stopped
+    std::string profile_report;
+    std::string profile_folded;
+
+    // Set by the consumer when it is about to sleep, so that producers only
+    // wake it up when it is needed
+    std::atomic<bool> consumer_waiting;
+
+    bool text_async;
+    trace_text_sink text_sink;
+    std::atomic<bool> flush_requested;
+
     pthread_mutex_t mutex;
     pthread_cond_t cond;
-    int end = 0;
+    std::atomic<int> end;
     std::thread *thread;
-    trace *first_pending_event;
+    // Min-heap of the traces with a pending pulse end, ordered by timestamp
+    std::vector<trace *> pending_heap;
+    // Timestamp of the first pending pulse end, so that checking pending
+    // pulses on each event is a single comparison
+    int64_t next_pending_timestamp;
 
     Event_trace *first_trace_to_dump;
   };
 
 };
 
+// Each thread dumping events gets its own ring. There is only one trace
+// engine per simulation so the ring can be cached in a thread-local variable.
+extern thread_local vp::trace_ring *vp_thread_trace_ring;
+
+inline vp::trace_ring *vp::trace_engine::get_ring()
+{
+  vp::trace_ring *ring = vp_thread_trace_ring;
+  if (unlikely(ring == NULL))
+    ring = this->new_ring();
+  return ring;
+}
+
+inline char *vp::trace_ring::reserve(int bytes)
+{
+  uint64_t head = this->head.load(std::memory_order_relaxed);
+  uint64_t contiguous = this->size - (head & this->mask);
+  uint64_t needed = bytes > (int)contiguous ? contiguous + bytes : bytes;
+
+  if (unlikely(head + needed - this->cached_tail > this->size))
+  {
+    this->cached_tail = this->tail.load(std::memory_order_acquire);
+    if (head + needed - this->cached_tail > this->size)
+      this->wait_space(needed);
+  }
+
+  if (unlikely(bytes > (int)contiguous))
+  {
+    // Not enough space before the end of the buffer, the consumer will skip
+    // the end when it sees the wrap record
+    *(vp::trace **)(this->buffer + (head & this->mask)) = NULL;
+    head += contiguous;
+    this->head.store(head, std::memory_order_release);
+  }
+
+  return this->buffer + (head & this->mask);
+}
+
+inline void vp::trace_ring::commit(int bytes)
+{
+  uint64_t head = this->head.load(std::memory_order_relaxed) + bytes;
+  this->head.store(head, std::memory_order_release);
+
+  this->nb_records++;
+  this->nb_bytes += bytes;
+
+  // The consumer is only woken up once a quarter of the ring is filled, so
+  // that it drains records in batches
+  uint64_t fill = head - this->cached_tail;
+  if (unlikely(fill >= this->size / 4))
+  {
+    this->cached_tail = this->tail.load(std::memory_order_acquire);
+    fill = head - this->cached_tail;
+    if (fill > this->max_fill)
+      this->max_fill = fill;
+    if (fill >= this->size / 4 && this->engine->consumer_waiting.load(std::memory_order_relaxed))
+      this->engine->wakeup_consumer();
+  }
+}
+
 #endif
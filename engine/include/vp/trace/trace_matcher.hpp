@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_TRACE_TRACE_MATCHER_HPP__
+#define __VP_TRACE_TRACE_MATCHER_HPP__
+
+#include <regex.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vp {
+
+  class trace_matcher_node
+  {
+  public:
+    std::map<char, trace_matcher_node *> childs;
+    // Wildcard child, coming from a .* in the pattern
+    trace_matcher_node *any = NULL;
+    bool is_any = false;
+    // Patterns ending on this node
+    std::vector<int> ids;
+    unsigned int stamp = 0;
+  };
+
+  // Matches trace paths against the POSIX basic regular expressions given
+  // with --trace and --event, with the same result as regexec.
+  // Patterns made of literal characters, .* and ^/$ anchors, which are the
+  // common forms, are compiled into a trie with wildcard nodes which is
+  // walked once for all patterns. The state reached after the component
+  // path is cached, so that only the trace name is walked for each trace.
+  // Other patterns fall back to regexec.
+  class trace_matcher
+  {
+  public:
+    trace_matcher();
+
+    // Adds a pattern, the id is returned by match when it matches
+    void add(const char *pattern, int id);
+
+    // Returns in ids, sorted, the ids of the patterns matching path/name
+    void match(std::string &path, std::string &name, std::vector<int> &ids);
+
+    // Compiles all patterns as regular expressions, for comparison
+    void set_regex_only(bool regex_only) { this->regex_only = regex_only; }
+
+  private:
+    bool parse_glob(const char *pattern, std::vector<int> &tokens);
+    void add_active(std::vector<trace_matcher_node *> &active, trace_matcher_node *node);
+    void walk(std::vector<trace_matcher_node *> &active, const char *str);
+
+    trace_matcher_node *root;
+    unsigned int stamp = 0;
+    bool regex_only = false;
+    std::vector<regex_t *> regexs;
+    std::vector<int> regex_ids;
+    std::unordered_map<std::string, std::vector<trace_matcher_node *>> path_cache;
+  };
+
+};
+
+#endif
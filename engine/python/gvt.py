@@ -0,0 +1,246 @@
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+
+#
+# Reader for the GVT event trace format (--event-format=gvt).
+#
+# File layout, all integers being LEB128 varints unless specified:
+#
+#   header:  "GVTRACE\0", version (u8), timescale exponent (u8, 12 for ps)
+#   blocks:  tag (u8) followed by the block body
+#     'S'    schema: id, type (u8, 0: bits, 1: real, 2: string), width,
+#            path length, path
+#     'C'    chunk: start time, end time - start time, number of events,
+#            payload size, payload
+#     'I'    index: number of traces, schemas, number of chunks, then
+#            for each chunk its file offset, start time, end - start time
+#            and number of events
+#   trailer: index offset (u64 little-endian), "GVTINDEX"
+#
+# Each chunk payload is a sequence of events: time delta with the previous
+# event of the chunk (0 for the first one), (id << 1) | undefined, then if
+# defined the value: the zigzag delta with the previous value of the same
+# trace in the chunk for bits traces up to 64 bits, the raw little-endian
+# bytes for wider ones, 8 bytes for reals, a length and the bytes for
+# strings.
+#
+
+import struct
+
+TYPE_BITS = 0
+TYPE_REAL = 1
+TYPE_STRING = 2
+
+
+class Trace(object):
+
+    def __init__(self, id, type, width, path):
+        self.id = id
+        self.type = type
+        self.width = width
+        self.path = path
+
+
+class Chunk(object):
+
+    def __init__(self, offset, start, end, nb_events):
+        self.offset = offset
+        self.start = start
+        self.end = end
+        self.nb_events = nb_events
+
+
+class Reader(object):
+
+    def __init__(self, path):
+        with open(path, 'rb') as file:
+            self.data = file.read()
+
+        if self.data[0:8] != b'GVTRACE\0':
+            raise Exception('Not a GVT file (path: %s)' % path)
+
+        self.version = self.data[8]
+        self.timescale = self.data[9]
+        self.traces = {}
+        self.chunks = []
+
+        # Files which were not closed have no index and are scanned
+        if len(self.data) >= 26 and self.data[-8:] == b'GVTINDEX':
+            self.__read_index(struct.unpack('<Q', self.data[-16:-8])[0])
+        else:
+            self.__scan()
+
+    def __varint(self, pos):
+        result = 0
+        shift = 0
+        while True:
+            byte = self.data[pos]
+            pos += 1
+            result |= (byte & 0x7f) << shift
+            if byte < 0x80:
+                return result, pos
+            shift += 7
+
+    def __schema(self, pos):
+        id, pos = self.__varint(pos)
+        type = self.data[pos]
+        width, pos = self.__varint(pos + 1)
+        size, pos = self.__varint(pos)
+        path = self.data[pos:pos+size].decode('utf-8')
+        self.traces[id] = Trace(id, type, width, path)
+        return pos + size
+
+    def __read_index(self, pos):
+        if self.data[pos] != ord('I'):
+            raise Exception('Corrupted GVT index')
+
+        nb_traces, pos = self.__varint(pos + 1)
+        for i in range(0, nb_traces):
+            pos = self.__schema(pos)
+
+        nb_chunks, pos = self.__varint(pos)
+        for i in range(0, nb_chunks):
+            offset, pos = self.__varint(pos)
+            start, pos = self.__varint(pos)
+            duration, pos = self.__varint(pos)
+            nb_events, pos = self.__varint(pos)
+            self.chunks.append(Chunk(offset, start, start + duration, nb_events))
+
+    def __scan(self):
+        pos = 10
+        while pos < len(self.data):
+            tag = self.data[pos]
+            if tag == ord('S'):
+                pos = self.__schema(pos + 1)
+            elif tag == ord('C'):
+                offset = pos
+                start, pos = self.__varint(pos + 1)
+                duration, pos = self.__varint(pos)
+                nb_events, pos = self.__varint(pos)
+                size, pos = self.__varint(pos)
+                if pos + size > len(self.data):
+                    break
+                self.chunks.append(Chunk(offset, start, start + duration, nb_events))
+                pos += size
+            else:
+                break
+
+    def __chunk_events(self, chunk):
+        start, pos = self.__varint(chunk.offset + 1)
+        duration, pos = self.__varint(pos)
+        nb_events, pos = self.__varint(pos)
+        size, pos = self.__varint(pos)
+
+        timestamp = start
+        last_values = {}
+
+        for i in range(0, nb_events):
+            delta, pos = self.__varint(pos)
+            timestamp += delta
+            id, pos = self.__varint(pos)
+            undefined = id & 1
+            trace = self.traces[id >> 1]
+
+            if undefined:
+                value = None
+            elif trace.type == TYPE_REAL:
+                value = struct.unpack('<d', self.data[pos:pos+8])[0]
+                pos += 8
+            elif trace.type == TYPE_STRING:
+                size, pos = self.__varint(pos)
+                value = self.data[pos:pos+size].split(b'\0')[0].decode('utf-8', 'replace')
+                pos += size
+            elif trace.width <= 64:
+                zigzag, pos = self.__varint(pos)
+                delta = (zigzag >> 1) ^ -(zigzag & 1)
+                value = (last_values.get(trace.id, 0) + delta) & ((1 << trace.width) - 1)
+                last_values[trace.id] = value
+            else:
+                size = (trace.width + 7) // 8
+                value = int.from_bytes(self.data[pos:pos+size], 'little')
+                pos += size
+
+            yield timestamp, trace, value
+
+    def events(self, start=None, end=None):
+        """Yield (timestamp, trace, value) for each event between start and
+        end included. Value is None when undefined. Only the chunks covering
+        the time window are decoded."""
+        for chunk in self.chunks:
+            if start is not None and chunk.end < start:
+                continue
+            if end is not None and chunk.start > end:
+                break
+            for event in self.__chunk_events(chunk):
+                if start is not None and event[0] < start:
+                    continue
+                if end is not None and event[0] > end:
+                    return
+                yield event
+
+
+def dump_vcd(reader, file, start=None, end=None):
+    """Write the events as VCD, with the same layout as --event-format=vcd."""
+    file.write('\n$timescale 1ps $end\n')
+
+    for trace in reader.traces.values():
+        scopes = [scope for scope in trace.path.split('/')[:-1] if scope != '']
+        for scope in scopes:
+            file.write('$scope module %s $end\n' % scope)
+        if trace.type == TYPE_REAL:
+            file.write('$var real 64 %d %s $end\n' % (trace.id, trace.path.split('/')[-1]))
+        else:
+            file.write('$var wire %d %d %s $end\n' % (trace.width, trace.id, trace.path.split('/')[-1]))
+        for scope in scopes:
+            file.write('$upscope $end\n')
+
+    file.write('\n$enddefinitions $end\n$dumpvars\n$end\n')
+
+    last_timestamp = None
+    for timestamp, trace, value in reader.events(start, end):
+        if timestamp != last_timestamp:
+            last_timestamp = timestamp
+            file.write('#%d\n' % timestamp)
+
+        if trace.type == TYPE_REAL:
+            if value is None:
+                file.write('rx %d\n' % trace.id)
+            else:
+                file.write('r%f %d\n' % (value, trace.id))
+        elif trace.type == TYPE_STRING:
+            file.write('s%s %d\n' % (value, trace.id))
+        elif trace.width > 1:
+            if value is None:
+                file.write('b%s %d\n' % ('x' * trace.width, trace.id))
+            else:
+                file.write('b%s %d\n' % (format(value, '0%db' % trace.width), trace.id))
+        else:
+            file.write('%s%d\n' % ('x' if value is None else value, trace.id))
+
+
+def dump_csv(reader, file, start=None, end=None):
+    """Write the events as CSV, one line per event."""
+    file.write('timestamp,path,value\n')
+    for timestamp, trace, value in reader.events(start, end):
+        if value is None:
+            value = 'x'
+        elif trace.type == TYPE_BITS:
+            value = '0x%x' % value
+        elif trace.type == TYPE_STRING:
+            value = '"%s"' % value.replace('"', '""')
+        file.write('%d,%s,%s\n' % (timestamp, trace.path, value))
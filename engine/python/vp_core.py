@@ -22,6 +22,40 @@ import ctypes.util
 import json_tools as js
 
 
+# Full configuration, parsed once by the C++ side the first time a component
+# implementation is loaded. Components whose configuration is a node of it
+# get the node by path instead of parsing their own copy.
+config_tree = None
+config_tree_loaded = False
+
+def set_config_tree(config_string):
+    global config_tree
+    config_tree = config_string
+
+
+class config_view(object):
+    """Configuration of a component.
+
+    The node of the configuration tree is used as long as the component
+    does not modify it, and is copied on the first call to set, so that the
+    parent configuration is not modified. Only modifications done through
+    the set method of this view are detected.
+    """
+
+    def __init__(self, config):
+        self.config = config
+        self.modified = False
+
+    def set(self, *args, **kwargs):
+        if not self.modified:
+            self.config = js.import_config(self.config.get_dict())
+            self.modified = True
+        return self.config.set(*args, **kwargs)
+
+    def __getattr__(self, name):
+        return getattr(self.config, name)
+
+
 class bcolors:
     HEADER = '\033[95m'
     OKBLUE = '\033[94m'
@@ -210,7 +244,16 @@ class default_implementation_class(object):
                 ctypes.c_void_p]
         self.module.vp_comp_get_services.restype = ctypes.c_int
 
-        if config is not None:
+        self.module.vp_config_tree_load.argtypes = [ctypes.c_char_p]
+        self.module.vp_config_tree_select.argtypes = [ctypes.c_char_p]
+
+        # A NULL configuration makes the constructor take the node selected
+        # in the configuration tree
+        self.shared_config = self.select_config()
+
+        if self.shared_config:
+            config_str = None
+        elif config is not None:
             config_str = config.get_string().encode('utf-8')
         else:
             config_str = None
@@ -223,6 +266,20 @@ class default_implementation_class(object):
     def get_path(self):
         return self.parent.get_path()
 
+    def select_config(self):
+        global config_tree_loaded
+
+        config_path = self.parent.get_config_path()
+        if config_path is None or config_tree is None:
+            return False
+
+        if not config_tree_loaded:
+            if self.module.vp_config_tree_load(config_tree.encode('utf-8')) != 0:
+                return False
+            config_tree_loaded = True
+
+        return self.module.vp_config_tree_select(config_path.encode('utf-8')) == 0
+
     def pre_start(self):
         return self.implem_pre_start(self.instance)
 
@@ -324,7 +381,10 @@ class default_implementation_class(object):
     def build(self):
         self.parent.trace.msg('Building implementation')
 
-        self.module.vp_comp_set_config(self.instance, self.parent.json_config.dump_to_string().encode('utf-8'))
+        # Components using the configuration tree already have their
+        # configuration, unless they modified it from python
+        if not self.shared_config or self.parent.json_config.modified:
+            self.module.vp_comp_set_config(self.instance, self.parent.json_config.dump_to_string().encode('utf-8'))
 
         # First execute the C build method, this will mainly declare ports
         retval = self.implem_build(self.instance)
@@ -427,7 +487,10 @@ class component(component_trace):
                 else:
                     self.path = parent.get_path() + '/' + name
 
-        self.json_config = self.get_json_config(config)
+        self.config_path = getattr(parent, 'new_config_path', None)
+        self.new_config_path = None
+
+        self.json_config = config_view(config)
 
         if hasattr(self, 'implementation'):
             self.impl = self.implementation_class(getattr(self, 'implementation'), config, parent=self, debug=debug)
@@ -472,6 +535,13 @@ class component(component_trace):
     def get_json(self):
         return self.json_config
 
+    def get_config_path(self):
+        # The path in the configuration tree is lost once the configuration
+        # is modified from python
+        if self.json_config.modified:
+            return None
+        return self.config_path
+
     def get_module(self, name, path=None):
         for x in name.split('.'):
             if path is not None:
@@ -500,11 +570,16 @@ class component(component_trace):
         else:
             return comp.get_comp_from_list(name_list[1:])
 
-    def new(self, name, component, config=None):
+    def new(self, name, component, config=None, config_path=None):
 
         self.trace.msg('New component (name: %s, class: %s)' % (name, component))
 
+        # config_path is the path of config in the configuration tree, if it
+        # is a node of it. It is given to the new component through this
+        # attribute as component constructors do not take it.
+        self.new_config_path = config_path
         comp = self.get_component(component)(name, config, parent=self, debug=self.debug)
+        self.new_config_path = None
         self.sub_comps.append(comp)
         self.sub_comps_dict[name] = comp
 
@@ -726,7 +801,11 @@ class component(component_trace):
                 if component is None:
                     component = default_class_name
 
-                self.new(comp_name, component=component, config=comp_config)
+                config_path = self.get_config_path()
+                if config_path is not None:
+                    config_path = comp_name if config_path == '' else config_path + '/' + comp_name
+
+                self.new(comp_name, component=component, config=comp_config, config_path=config_path)
 
 
     def create_ports(self, port_tag):
@@ -19,11 +19,13 @@
 import vp.time_domain
 import vp.trace_engine
 import vp.power_engine
+import vp.stats_engine
 import vp_core
 import runner.stim_utils
 from os import listdir
 from os.path import isfile, join, isdir
 import os.path
+import sys
 
 from plp_platform import *
 import plp_flash_stimuli
@@ -34,6 +36,14 @@ from prettytable import PrettyTable
 
 import vcd.gtkw
 
+# Generated by the engine build, tells whether traces are enabled at runtime
+# in the default implementations
+try:
+    import vp_build
+    trace_runtime = vp_build.trace_runtime
+except ImportError:
+    trace_runtime = False
+
 def gen_gtkw_core_traces(gtkw, path):
     gtkw.trace(path + '.pc[31:0]', 'pc')
     gtkw.trace(path + '.asm', 'asm')
@@ -117,10 +127,34 @@ class Runner(Platform):
 
         parser.add_argument("--event", dest="events", default=[], action="append", help="Specify gvsoc event (for VCD traces)")
 
-        parser.add_argument("--event-format", dest="format", default=None, help="Specify events format (vcd or fst)")
+        parser.add_argument("--event-format", dest="format", default=None, help="Specify events format (vcd, fst or gvt)")
 
         parser.add_argument("--gtkw", dest="gtkw", action="store_true", help="Dump events to pipe and open gtkwave in interactive mode")
 
+        parser.add_argument("--parallel", dest="parallel", action="store_true", help="Execute the groups of clock domains specified in gvsoc/parallel/groups on several threads. IO requests crossing groups are then always answered asynchronously")
+
+        parser.add_argument("--quantum", dest="quantum", default=None, type=int, help="Specify the quantum in picoseconds used to synchronize clock domain groups in parallel mode")
+
+        parser.add_argument("--profile", dest="profile", action="store_true", help="Report the host time spent in each component, and dump the call stacks to profile.folded for flamegraph.pl")
+
+        parser.add_argument("--no-config-tree", dest="config_tree", action="store_false", help="Give each component its own copy of its configuration instead of a node of the configuration parsed once")
+
+        parser.add_argument("--native", dest="native", action="store_true", help="Build and run the platform with the native launcher instead of python, to reduce the startup time")
+
+        parser.add_argument("--static", dest="static", default=None, help="Build and run the platform with the specified static launcher, built with make static")
+
+        parser.add_argument("--build-only", dest="build_only", action="store_true", help="Exit once the platform is built, to measure the startup time")
+
+        parser.add_argument("--checkpoint-save", dest="checkpoint_save", default=None, help="Save a checkpoint of the platform state to the specified file")
+
+        parser.add_argument("--checkpoint-time", dest="checkpoint_time", default=None, type=int, help="Specify the time in picoseconds at which the checkpoint is saved")
+
+        parser.add_argument("--checkpoint-parent", dest="checkpoint_parent", default=None, help="Save an incremental checkpoint on top of the specified one")
+
+        parser.add_argument("--checkpoint-exit", dest="checkpoint_exit", action="store_true", help="Stop the simulation once the checkpoint is saved")
+
+        parser.add_argument("--checkpoint-restore", dest="checkpoint_restore", default=None, help="Restore the platform state from the specified checkpoint before running")
+
         [args, otherArgs] = parser.parse_known_args()
 
         if 'devices' in args.command:
@@ -149,6 +183,38 @@ class Runner(Platform):
         if args.gtkw:
             self.get_json().set('gvsoc/vcd/gtkw', True)
 
+        if args.parallel:
+            self.get_json().set('gvsoc/parallel/enabled', True)
+
+        if args.quantum is not None:
+            self.get_json().set('gvsoc/parallel/quantum', args.quantum)
+
+        if args.profile:
+            self.get_json().set('gvsoc/profile/enabled', True)
+
+        if not args.config_tree:
+            self.get_json().set('gvsoc/no_config_tree', True)
+
+        if args.build_only:
+            self.get_json().set('gvsoc/build_only', True)
+
+        if args.checkpoint_save is not None:
+            self.get_json().set('gvsoc/checkpoint/save', os.path.abspath(args.checkpoint_save))
+
+        # The time is passed as a string as it may not fit the integer type
+        # used by the configuration
+        if args.checkpoint_time is not None:
+            self.get_json().set('gvsoc/checkpoint/save_time', str(args.checkpoint_time))
+
+        if args.checkpoint_parent is not None:
+            self.get_json().set('gvsoc/checkpoint/parent', os.path.abspath(args.checkpoint_parent))
+
+        if args.checkpoint_exit:
+            self.get_json().set('gvsoc/checkpoint/save_exit', True)
+
+        if args.checkpoint_restore is not None:
+            self.get_json().set('gvsoc/checkpoint/restore', os.path.abspath(args.checkpoint_restore))
+
 
     def devices(self):
         devices = []
@@ -355,28 +421,52 @@ class Runner(Platform):
                             " top component")
 
         gvsoc_config = self.get_json().get('gvsoc')
-        debug_mode = len(gvsoc_config.get('trace').get()) != 0 or len(gvsoc_config.get('event').get()) != 0
+        debug_mode = not trace_runtime and (len(gvsoc_config.get('trace').get()) != 0 or len(gvsoc_config.get('event').get()) != 0)
 
         gen_gtkw_files(self.get_json(), gvsoc_config)
 
+        # The native launcher does the same as below from plt_config.json
+        if self.args.native or self.args.static is not None:
+            launcher = 'gvsoc-launcher'
+            if self.args.static is not None:
+                launcher += '-' + self.args.static
+            cmd = [launcher, '--config=%s' % os.environ['PULP_CONFIG_FILE']]
+            sys.stdout.flush()
+            os.execvp(cmd[0], cmd)
+
+        # The whole configuration is parsed once on the C++ side and the
+        # components get their node from their path in it
+        if not self.get_json().get_child_bool('**/gvsoc/no_config_tree'):
+            vp_core.set_config_tree(self.get_json().dump_to_string())
+
         trace_engine = vp.trace_engine.component(name=None, config=gvsoc_config, debug=debug_mode)
 
         power_engine = trace_engine.new(
             name=None,
             component='vp.power_engine',
-            config=gvsoc_config
+            config=gvsoc_config,
+            config_path='gvsoc'
         )
 
-        time_engine = power_engine.new(
+        stats_engine = power_engine.new(
+            name=None,
+            component='vp.stats_engine',
+            config=gvsoc_config,
+            config_path='gvsoc'
+        )
+
+        time_engine = stats_engine.new(
             name=None,
             component='vp.time_domain',
-            config=self.get_json()
+            config=self.get_json(),
+            config_path=''
         )
 
         top_comp = time_engine.new(
             name='sys',
             component=top,
-            config=self.get_json().get('system_tree')
+            config=self.get_json().get('system_tree'),
+            config_path='system_tree'
         )
 
         trace_engine.get_port('out').bind_to(top_comp.get_port('trace'))
@@ -400,6 +490,9 @@ class Runner(Platform):
 
         trace_engine.load_all()
 
+        if self.get_json().get_child_bool('**/gvsoc/build_only'):
+            return 0
+
         status = time_engine.run()
 
         trace_engine.stop_all()
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "vp/vp.hpp"
+#include "vp/checkpoint/checkpoint.hpp"
+#include <string.h>
+#include <errno.h>
+
+int vp::checkpoint::open_write(std::string path, std::string parent)
+{
+  this->path = path;
+  this->parent = parent;
+
+  this->file = fopen(path.c_str(), "wb");
+  if (this->file == NULL)
+  {
+    this->set_error("unable to open " + path + ": " + strerror(errno));
+    return -1;
+  }
+
+  this->write(CHECKPOINT_MAGIC, 8);
+  this->write_str(parent);
+
+  return this->has_error() ? -1 : 0;
+}
+
+int vp::checkpoint::open_read(std::string path)
+{
+  char magic[8];
+
+  this->path = path;
+
+  this->file = fopen(path.c_str(), "rb");
+  if (this->file == NULL)
+  {
+    this->set_error("unable to open " + path + ": " + strerror(errno));
+    return -1;
+  }
+
+  this->read(magic, 8);
+  if (!this->has_error() && memcmp(magic, CHECKPOINT_MAGIC, 8) != 0)
+  {
+    this->set_error(path + " is not a checkpoint or has an unsupported version");
+  }
+
+  if (!this->has_error())
+    this->parent = this->read_str();
+
+  return this->has_error() ? -1 : 0;
+}
+
+void vp::checkpoint::close()
+{
+  if (this->file)
+  {
+    fclose(this->file);
+    this->file = NULL;
+  }
+}
+
+void vp::checkpoint::set_error(std::string error)
+{
+  // Only keep the first error as the next ones are usually a consequence
+  if (this->error == "")
+    this->error = error;
+}
+
+void vp::checkpoint::write_str(std::string str)
+{
+  this->write<uint32_t>(str.size());
+  this->write(str.c_str(), str.size());
+}
+
+std::string vp::checkpoint::read_str()
+{
+  uint32_t size = this->read<uint32_t>();
+  if (this->has_error())
+    return "";
+
+  std::string str(size, 0);
+  this->read(&str[0], size);
+  return str;
+}
+
+void vp::checkpoint::begin_section(std::string name)
+{
+  this->write_str(name);
+
+  // The section size is patched once the section is closed so that the
+  // reader can check that components consumed exactly what was saved
+  this->write<uint64_t>(0);
+  this->section_start = ftell(this->file);
+}
+
+void vp::checkpoint::end_section()
+{
+  long end = ftell(this->file);
+  uint64_t size = end - this->section_start;
+
+  fseek(this->file, this->section_start - sizeof(uint64_t), SEEK_SET);
+  this->write<uint64_t>(size);
+  fseek(this->file, end, SEEK_SET);
+}
+
+int vp::checkpoint::enter_section(std::string name)
+{
+  std::string section_name = this->read_str();
+  this->section_size = this->read<uint64_t>();
+  this->section_start = ftell(this->file);
+
+  if (!this->has_error() && section_name != name)
+  {
+    this->set_error("found section " + section_name + " while expecting " + name +
+      ", the checkpoint was probably saved with a different platform");
+  }
+
+  return this->has_error() ? -1 : 0;
+}
+
+int vp::checkpoint::leave_section()
+{
+  if (!this->has_error() && ftell(this->file) - this->section_start != (long)this->section_size)
+  {
+    this->set_error("size mismatch in section of " + this->path);
+  }
+
+  return this->has_error() ? -1 : 0;
+}
+
+void vp::checkpoint::write_pages(uint8_t *data, uint64_t size, uint64_t *pages)
+{
+  uint64_t nb_pages = (size + CHECKPOINT_PAGE_SIZE - 1) >> CHECKPOINT_PAGE_BITS;
+  uint64_t nb_saved_pages = 0;
+
+  for (uint64_t page = 0; page < nb_pages; page++)
+  {
+    if ((pages[page / 64] >> (page % 64)) & 1)
+      nb_saved_pages++;
+  }
+
+  this->write<uint64_t>(nb_saved_pages);
+
+  for (uint64_t page = 0; page < nb_pages; page++)
+  {
+    if ((pages[page / 64] >> (page % 64)) & 1)
+    {
+      uint64_t offset = page << CHECKPOINT_PAGE_BITS;
+      uint64_t page_size = size - offset < CHECKPOINT_PAGE_SIZE ? size - offset : CHECKPOINT_PAGE_SIZE;
+
+      this->write<uint64_t>(page);
+      this->write(&data[offset], page_size);
+    }
+  }
+}
+
+void vp::checkpoint::read_pages(uint8_t *data, uint64_t size, uint64_t *pages)
+{
+  uint64_t nb_pages = (size + CHECKPOINT_PAGE_SIZE - 1) >> CHECKPOINT_PAGE_BITS;
+  uint64_t nb_saved_pages = this->read<uint64_t>();
+
+  for (uint64_t i = 0; i < nb_saved_pages && !this->has_error(); i++)
+  {
+    uint64_t page = this->read<uint64_t>();
+    if (page >= nb_pages)
+    {
+      this->set_error("page out of memory in " + this->path);
+      return;
+    }
+
+    uint64_t offset = page << CHECKPOINT_PAGE_BITS;
+    uint64_t page_size = size - offset < CHECKPOINT_PAGE_SIZE ? size - offset : CHECKPOINT_PAGE_SIZE;
+
+    this->read(&data[offset], page_size);
+    pages[page / 64] |= 1ULL << (page % 64);
+  }
+}
@@ -0,0 +1,928 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "launcher/launcher.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+
+bool launcher::debug_mode = false;
+int launcher::max_path_len = 32;
+
+static std::string root_config;
+static bool config_tree_loaded = false;
+static std::vector<std::string> module_paths;
+static std::map<std::string, launcher::module *> modules;
+
+// Services declared by all the implementations, which all get all of them
+static std::vector<const char *> service_names;
+static std::vector<void *> services;
+
+
+void launcher::error(const char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  fprintf(stderr, "GVSOC launcher error: ");
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+}
+
+
+bool launcher::get_config_int(js::config *config, std::string name, int64_t *value)
+{
+  js::config *conf = config->get(name);
+  if (conf == NULL)
+    return false;
+
+  std::string str = conf->get_str();
+  *value = str != "" ? strtoll(str.c_str(), NULL, 0) : conf->get_int();
+  return true;
+}
+
+
+#ifdef LAUNCHER_STATIC
+
+// Engine functions, which implementations get from libpulpvp when they are
+// loaded dynamically
+extern "C" {
+  int vp_comp_get_ports(void *comp, bool master, int size, const char *names[], void *ports[]);
+  char *vp_get_error();
+  int vp_comp_get_services(void *comp, int size, const char *names[], void *services[]);
+  void vp_comp_set_services(void *comp, int nb_services, const char *names[], void *services[]);
+  void vp_port_bind_to(void *_master, void *_slave, const char *config_str);
+  void vp_port_finalize(void *_master);
+  void vp_comp_set_config(void *comp, const char *config);
+  int vp_config_tree_load(const char *config);
+  int vp_config_tree_select(const char *path);
+  void vp_comp_conf(void *comp, const char *path, void *parent);
+  void vp_pre_start(void *comp);
+  void vp_load(void *comp);
+  void vp_start(void *comp);
+  void vp_reset(void *comp, int active);
+  void vp_stop(void *comp);
+  const char *vp_run(void *comp);
+  int vp_run_status(void *comp);
+  void vp_post_post_build(void *comp);
+  int vp_build(void *comp);
+}
+
+static const launcher::static_symbol_t engine_symbols[] = {
+  { "vp_comp_get_ports", (void *)vp_comp_get_ports },
+  { "vp_get_error", (void *)vp_get_error },
+  { "vp_comp_get_services", (void *)vp_comp_get_services },
+  { "vp_comp_set_services", (void *)vp_comp_set_services },
+  { "vp_port_bind_to", (void *)vp_port_bind_to },
+  { "vp_port_finalize", (void *)vp_port_finalize },
+  { "vp_comp_set_config", (void *)vp_comp_set_config },
+  { "vp_config_tree_load", (void *)vp_config_tree_load },
+  { "vp_config_tree_select", (void *)vp_config_tree_select },
+  { "vp_comp_conf", (void *)vp_comp_conf },
+  { "vp_pre_start", (void *)vp_pre_start },
+  { "vp_load", (void *)vp_load },
+  { "vp_start", (void *)vp_start },
+  { "vp_reset", (void *)vp_reset },
+  { "vp_stop", (void *)vp_stop },
+  { "vp_run", (void *)vp_run },
+  { "vp_run_status", (void *)vp_run_status },
+  { "vp_post_post_build", (void *)vp_post_post_build },
+  { "vp_build", (void *)vp_build },
+  { NULL, NULL }
+};
+
+static void *find_symbol(const launcher::static_symbol_t *symbols, const char *name)
+{
+  for (const launcher::static_symbol_t *symbol=symbols; symbol->name; symbol++)
+  {
+    if (strcmp(symbol->name, name) == 0)
+      return symbol->address;
+  }
+  return NULL;
+}
+
+#endif
+
+
+#define LAUNCHER_SYMBOL(field, name) this->field = (decltype(this->field))this->get_symbol(name)
+
+launcher::module::module(void *handle, std::string path, const static_symbol_t *symbols)
+: handle(handle), path(path), symbols(symbols)
+{
+  LAUNCHER_SYMBOL(constructor, "vp_constructor");
+  LAUNCHER_SYMBOL(comp_conf, "vp_comp_conf");
+  LAUNCHER_SYMBOL(build, "vp_build");
+  LAUNCHER_SYMBOL(get_error, "vp_get_error");
+  LAUNCHER_SYMBOL(get_ports, "vp_comp_get_ports");
+  LAUNCHER_SYMBOL(get_services, "vp_comp_get_services");
+  LAUNCHER_SYMBOL(set_services, "vp_comp_set_services");
+  LAUNCHER_SYMBOL(port_bind_to, "vp_port_bind_to");
+  LAUNCHER_SYMBOL(port_finalize, "vp_port_finalize");
+  LAUNCHER_SYMBOL(post_post_build, "vp_post_post_build");
+  LAUNCHER_SYMBOL(pre_start, "vp_pre_start");
+  LAUNCHER_SYMBOL(start, "vp_start");
+  LAUNCHER_SYMBOL(reset, "vp_reset");
+  LAUNCHER_SYMBOL(load, "vp_load");
+  LAUNCHER_SYMBOL(stop, "vp_stop");
+  LAUNCHER_SYMBOL(run, "vp_run");
+  LAUNCHER_SYMBOL(run_status, "vp_run_status");
+  LAUNCHER_SYMBOL(config_tree_load, "vp_config_tree_load");
+  LAUNCHER_SYMBOL(config_tree_select, "vp_config_tree_select");
+}
+
+void *launcher::module::get_symbol(const char *name)
+{
+#ifdef LAUNCHER_STATIC
+  void *symbol = find_symbol(this->symbols, name);
+  return symbol ? symbol : find_symbol(engine_symbols, name);
+#else
+  return dlsym(this->handle, name);
+#endif
+}
+
+
+std::string launcher::get_module_name(std::string implementation)
+{
+  // Same module path as the one imp.find_module gets from the python name
+  std::string name = implementation;
+  std::replace(name.begin(), name.end(), '.', '/');
+  return name;
+}
+
+launcher::module *launcher::get_module(std::string implementation)
+{
+  std::string name = get_module_name(implementation);
+
+#ifdef LAUNCHER_STATIC
+
+  // Only the optimized implementations are linked, traces are compiled out
+  auto it = modules.find(name);
+  if (it != modules.end())
+    return it->second;
+
+  for (const static_module_t *static_module=static_modules; static_module->name; static_module++)
+  {
+    if (name == static_module->name)
+    {
+      module *mod = new module(NULL, name, static_module->symbols);
+      modules[name] = mod;
+      return mod;
+    }
+  }
+
+  error("Implementation not linked in this launcher (name: %s)\n", name.c_str());
+  return NULL;
+
+#else
+
+  if (debug_mode)
+    name = "debug/" + name;
+
+  auto it = modules.find(name);
+  if (it != modules.end())
+    return it->second;
+
+  for (auto &dir: module_paths)
+  {
+    std::string path = dir + "/" + name + ".so";
+    if (access(path.c_str(), R_OK) != 0)
+      continue;
+
+    // Each implementation has its own vp_constructor, so their symbols must
+    // not be global
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL)
+    {
+      error("Failed to load implementation (path: %s, error: %s)\n", path.c_str(), dlerror());
+      return NULL;
+    }
+
+    module *mod = new module(handle, path);
+    if (mod->constructor == NULL || mod->build == NULL || mod->config_tree_select == NULL)
+    {
+      error("Implementation is not a component (path: %s)\n", path.c_str());
+      return NULL;
+    }
+
+    modules[name] = mod;
+    return mod;
+  }
+
+  error("Implementation not found in python path (name: %s)\n", implementation.c_str());
+  return NULL;
+
+#endif
+}
+
+
+launcher::port::port(component *comp, std::string name, port_type_e type, void *ref)
+: comp(comp), name(name), type(type), ref(ref)
+{
+}
+
+void launcher::port::bind_to(port *slave)
+{
+  this->slaves.push_back(slave);
+  slave->is_bound = true;
+  if (this->type == MASTER)
+    this->is_bound = true;
+}
+
+void launcher::port::get_ports(std::vector<port *> &ports)
+{
+  if (this->type == SLAVE)
+  {
+    ports.push_back(this);
+  }
+  else if (this->type == COMPOSITE)
+  {
+    for (auto slave: this->slaves)
+    {
+      slave->get_ports(ports);
+    }
+  }
+}
+
+void launcher::port::bind()
+{
+  for (auto slave: this->slaves)
+  {
+    std::vector<port *> ports;
+    slave->get_ports(ports);
+
+    for (auto port: ports)
+    {
+      this->is_bound_to_port = true;
+      this->comp->impl->port_bind_to(this->ref, port->ref, NULL);
+    }
+  }
+}
+
+void launcher::port::final_bind()
+{
+  if (this->type == MASTER && this->slaves.size() != 0 && this->is_bound_to_port)
+    this->comp->impl->port_finalize(this->ref);
+  else if (this->type == SLAVE && this->is_bound)
+    this->comp->impl->port_finalize(this->ref);
+}
+
+
+launcher::component::component(std::string name, std::string cls, js::config *config, std::string config_path, component *parent)
+: name(name), cls_name(cls), config(config), config_path(config_path), parent(parent)
+{
+  if (name == "")
+    this->path = "";
+  else if (parent == NULL || parent->path == "")
+    this->path = "/" + name;
+  else
+    this->path = parent->path + "/" + name;
+
+  std::replace(this->cls_name.begin(), this->cls_name.end(), '.', '/');
+  this->cls = get_class(this->cls_name);
+
+  // Python registers a trace for each component below the trace engine,
+  // which sets the width of the path column of the traces
+  if (parent != NULL)
+    max_path_len = std::max(max_path_len, (int)(this->path + "/py_comp").size());
+}
+
+int launcher::component::create()
+{
+  if (this->config == NULL)
+  {
+    error("Component has no configuration (path: %s)\n", this->path.c_str());
+    return -1;
+  }
+
+  if (this->cls && (this->cls->flags & LAUNCHER_CLASS_PYTHON_ONLY))
+  {
+    error("Component is only implemented in python, the platform must be launched from python (path: %s, class: %s)\n",
+      this->path.c_str(), this->cls_name.c_str());
+    return -1;
+  }
+
+  std::string implementation;
+  if (this->get_implementation(implementation))
+    return -1;
+
+  if (implementation != "")
+  {
+    this->impl = get_module(implementation);
+    if (this->impl == NULL)
+      return -1;
+
+    // The whole configuration is parsed once and each implementation gets
+    // its node, as when it is launched from python
+    if (!config_tree_loaded)
+    {
+      if (this->impl->config_tree_load(root_config.c_str()))
+      {
+        error("Failed to parse configuration\n");
+        return -1;
+      }
+      config_tree_loaded = true;
+    }
+
+    if (this->impl->config_tree_select(this->config_path.c_str()))
+    {
+      error("Configuration not found (path: %s)\n", this->config_path.c_str());
+      return -1;
+    }
+
+    this->instance = this->impl->constructor(NULL);
+
+    this->impl->comp_conf(this->instance, this->path.c_str(),
+      this->parent ? this->parent->instance : NULL);
+  }
+
+  return this->build_all();
+}
+
+int launcher::component::get_implementation(std::string &implementation)
+{
+  implementation = "";
+
+  if (this->cls == NULL)
+  {
+    implementation = this->cls_name + "_impl";
+  }
+  else if (this->cls->get_implementation)
+  {
+    implementation = this->cls->get_implementation(this);
+    if (implementation == "")
+      return -1;
+  }
+  else if (this->cls->implementation)
+  {
+    implementation = this->cls->implementation;
+  }
+
+  return 0;
+}
+
+int launcher::component::list_implementations(std::vector<std::string> &implementations)
+{
+  if (this->config == NULL)
+  {
+    error("Component has no configuration (path: %s)\n", this->path.c_str());
+    return -1;
+  }
+
+  std::string implementation;
+  if (this->get_implementation(implementation))
+    return -1;
+
+  if (implementation != "")
+  {
+    std::string name = get_module_name(implementation);
+    if (std::find(implementations.begin(), implementations.end(), name) == implementations.end())
+      implementations.push_back(name);
+  }
+
+  // Only composites have sub-components described in their configuration
+  js::config *comps = this->config->get("vp_comps");
+  if (comps != NULL)
+  {
+    for (auto comp_name_config: comps->get_elems())
+    {
+      std::string comp_name = comp_name_config->get_str();
+      js::config *comp_config = this->config->get(comp_name);
+      js::config *class_config = comp_config ? comp_config->get("vp_class") : NULL;
+      std::string cls = class_config ? class_config->get_str() : "utils/composite";
+
+      component comp(comp_name, cls, comp_config, "", this);
+      if (comp.list_implementations(implementations))
+        return -1;
+    }
+  }
+
+  return 0;
+}
+
+int launcher::component::get_impl_ports(bool master)
+{
+  std::map<std::string, port *> &ports_map = master ? this->master_ports : this->slave_ports;
+
+  int size = this->impl->get_ports(this->instance, master, 0, NULL, NULL);
+  if (size == 0)
+    return 0;
+
+  std::vector<const char *> names(size);
+  std::vector<void *> refs(size);
+  size = this->impl->get_ports(this->instance, master, size, names.data(), refs.data());
+
+  for (int i=0; i<size; i++)
+  {
+    ports_map[names[i]] = new port(this, names[i], master ? port::MASTER : port::SLAVE, refs[i]);
+  }
+
+  return 0;
+}
+
+int launcher::component::build_all()
+{
+  if (this->cls && this->cls->build && this->cls->build(this))
+    return -1;
+
+  if (this->impl)
+  {
+    if (this->impl->build(this->instance))
+    {
+      const char *msg = this->impl->get_error();
+      error("Caught error while building component (path: %s): %s\n", this->path.c_str(), msg ? msg : "");
+      return -1;
+    }
+
+    this->get_impl_ports(true);
+    this->get_impl_ports(false);
+
+    int size = this->impl->get_services(this->instance, 0, NULL, NULL);
+    if (size != 0)
+    {
+      std::vector<const char *> names(size);
+      std::vector<void *> comp_services(size);
+      size = this->impl->get_services(this->instance, size, names.data(), comp_services.data());
+
+      for (int i=0; i<size; i++)
+      {
+        service_names.push_back(names[i]);
+        services.push_back(comp_services[i]);
+      }
+    }
+  }
+
+  // Clock and reset are propagated to the sub-components which do not get
+  // them from a binding
+  for (auto name: {"clock", "reset"})
+  {
+    this->new_port(name);
+
+    for (auto comp: this->sub_comps)
+    {
+      port *slave_port = comp->get_port(name);
+      port *master_port = this->get_port(name);
+      if (slave_port->is_bound)
+        continue;
+      if (master_port->is_master() && slave_port->is_slave())
+        master_port->bind_to(slave_port);
+    }
+  }
+
+  return 0;
+}
+
+launcher::component *launcher::component::new_comp(std::string name, std::string cls, js::config *config, std::string config_path)
+{
+  component *comp = new component(name, cls, config, config_path, this);
+  if (comp->create())
+    return NULL;
+
+  this->sub_comps.push_back(comp);
+  this->sub_comps_dict[name] = comp;
+
+  return comp;
+}
+
+launcher::component *launcher::component::get_comp_from_list(std::vector<std::string> name_list)
+{
+  auto it = this->sub_comps_dict.find(name_list[0]);
+  if (it == this->sub_comps_dict.end())
+    return NULL;
+
+  if (name_list.size() == 1)
+    return it->second;
+
+  return it->second->get_comp_from_list(std::vector<std::string>(name_list.begin() + 1, name_list.end()));
+}
+
+launcher::component *launcher::component::get_time_engine()
+{
+  if (this->cls && (this->cls->flags & LAUNCHER_CLASS_TIME_ENGINE))
+    return this;
+  if (this->parent == NULL)
+    return NULL;
+  return this->parent->get_time_engine();
+}
+
+launcher::port *launcher::component::get_port(std::string name)
+{
+  // Implementation ports first, as in python
+  auto it = this->master_ports.find(name);
+  if (it != this->master_ports.end())
+    return it->second;
+
+  it = this->slave_ports.find(name);
+  if (it != this->slave_ports.end())
+    return it->second;
+
+  it = this->ports.find(name);
+  if (it != this->ports.end())
+    return it->second;
+
+  return NULL;
+}
+
+void launcher::component::new_port(std::string name)
+{
+  this->ports[name] = new port(this, name, port::COMPOSITE);
+}
+
+int launcher::component::create_comps()
+{
+  js::config *comps = this->config->get("vp_comps");
+  if (comps == NULL)
+    return 0;
+
+  for (auto comp_name_config: comps->get_elems())
+  {
+    std::string comp_name = comp_name_config->get_str();
+    js::config *comp_config = this->config->get(comp_name);
+    if (comp_config == NULL)
+    {
+      error("Component has no configuration (path: %s/%s)\n", this->path.c_str(), comp_name.c_str());
+      return -1;
+    }
+
+    js::config *class_config = comp_config->get("vp_class");
+    std::string cls = class_config ? class_config->get_str() : "utils/composite";
+
+    std::string config_path = this->config_path == "" ? comp_name : this->config_path + "/" + comp_name;
+
+    if (this->new_comp(comp_name, cls, comp_config, config_path) == NULL)
+      return -1;
+  }
+
+  return 0;
+}
+
+int launcher::component::create_ports()
+{
+  js::config *ports = this->config->get("vp_ports");
+  if (ports == NULL)
+    return 0;
+
+  for (auto port_config: ports->get_elems())
+  {
+    this->new_port(port_config->get_str());
+  }
+
+  return 0;
+}
+
+static std::vector<std::string> split(std::string str, std::string delimiter)
+{
+  std::vector<std::string> result;
+  size_t start = 0, end;
+  while ((end = str.find(delimiter, start)) != std::string::npos)
+  {
+    result.push_back(str.substr(start, end - start));
+    start = end + delimiter.size();
+  }
+  result.push_back(str.substr(start));
+  return result;
+}
+
+int launcher::component::create_bindings()
+{
+  js::config *bindings = this->config->get("vp_bindings");
+  if (bindings == NULL)
+    return 0;
+
+  for (auto binding: bindings->get_elems())
+  {
+    std::string master = binding->get_elem(0)->get_str();
+    std::string slave = binding->get_elem(1)->get_str();
+    std::vector<std::string> master_names = split(master, "->");
+    std::vector<std::string> slave_names = split(slave, "->");
+
+    if (master_names.size() != 2 || slave_names.size() != 2)
+    {
+      error("Invalid binding (path: %s, master: %s, slave: %s)\n", this->path.c_str(), master.c_str(), slave.c_str());
+      return -1;
+    }
+
+    component *master_comp = master_names[0] == "self" ? this : this->get_comp_from_list(split(master_names[0], "/"));
+    component *slave_comp = slave_names[0] == "self" ? this : this->get_comp_from_list(split(slave_names[0], "/"));
+
+    if (master_comp == NULL)
+    {
+      error("Unknown master component in binding (path: %s, binding: %s)\n", this->path.c_str(), master.c_str());
+      return -1;
+    }
+
+    if (slave_comp == NULL)
+    {
+      error("Unknown slave component in binding (path: %s, binding: %s)\n", this->path.c_str(), slave.c_str());
+      return -1;
+    }
+
+    port *master_port = master_comp->get_port(master_names[1]);
+    port *slave_port = slave_comp->get_port(slave_names[1]);
+
+    if (master_port == NULL)
+    {
+      error("Unknown master port in binding (path: %s, binding: %s)\n", this->path.c_str(), master.c_str());
+      return -1;
+    }
+
+    if (slave_port == NULL)
+    {
+      error("Unknown slave port in binding (path: %s, binding: %s)\n", this->path.c_str(), slave.c_str());
+      return -1;
+    }
+
+    master_port->bind_to(slave_port);
+  }
+
+  return 0;
+}
+
+void launcher::component::bind()
+{
+  for (auto comp: this->sub_comps)
+  {
+    comp->bind();
+  }
+
+  for (auto &x: this->master_ports)
+  {
+    x.second->bind();
+  }
+}
+
+void launcher::component::post_post_build_all()
+{
+  if (this->impl)
+    this->impl->set_services(this->instance, services.size(), service_names.data(), services.data());
+
+  for (auto comp: this->sub_comps)
+  {
+    comp->post_post_build_all();
+  }
+
+  if (this->impl)
+    this->impl->post_post_build(this->instance);
+}
+
+void launcher::component::pre_start_all()
+{
+  for (auto comp: this->sub_comps)
+  {
+    comp->pre_start_all();
+  }
+
+  if (this->cls && this->cls->pre_start)
+    this->cls->pre_start(this);
+
+  if (this->impl)
+    this->impl->pre_start(this->instance);
+}
+
+void launcher::component::start_all()
+{
+  for (auto comp: this->sub_comps)
+  {
+    comp->start_all();
+  }
+
+  if (this->impl)
+    this->impl->start(this->instance);
+}
+
+void launcher::component::final_bind()
+{
+  for (auto comp: this->sub_comps)
+  {
+    comp->final_bind();
+  }
+
+  for (auto &x: this->master_ports)
+  {
+    x.second->final_bind();
+  }
+
+  for (auto &x: this->slave_ports)
+  {
+    x.second->final_bind();
+  }
+}
+
+int launcher::component::load_all()
+{
+  for (auto comp: this->sub_comps)
+  {
+    if (comp->load_all())
+      return -1;
+  }
+
+  if (this->cls && this->cls->load && this->cls->load(this))
+    return -1;
+
+  if (this->impl)
+    this->impl->load(this->instance);
+
+  return 0;
+}
+
+void launcher::component::stop_all()
+{
+  for (auto comp: this->sub_comps)
+  {
+    comp->stop_all();
+  }
+
+  if (this->impl)
+    this->impl->stop(this->instance);
+}
+
+
+static bool get_config_bool(js::config *config, std::string name)
+{
+  js::config *conf = config->get(name);
+  return conf != NULL && conf->get_bool();
+}
+
+static void usage(const char *name)
+{
+  printf("Usage: %s [--config=<plt_config.json>] [--build-only] [--list-implementations]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+  std::string config_file = "plt_config.json";
+  bool build_only = false;
+  bool list = false;
+
+  for (int i=1; i<argc; i++)
+  {
+    if (strncmp(argv[i], "--config=", 9) == 0)
+      config_file = argv[i] + 9;
+    else if (strcmp(argv[i], "--build-only") == 0)
+      build_only = true;
+    else if (strcmp(argv[i], "--list-implementations") == 0)
+      list = true;
+    else
+    {
+      usage(argv[0]);
+      return strcmp(argv[i], "--help") == 0 ? 0 : -1;
+    }
+  }
+
+  std::ifstream file(config_file);
+  if (!file)
+  {
+    launcher::error("Failed to open configuration (path: %s)\n", config_file.c_str());
+    return -1;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  root_config = buffer.str();
+
+  js::config *config = js::import_config_from_string(strdup(root_config.c_str()));
+  if (config == NULL)
+  {
+    launcher::error("Failed to parse configuration (path: %s)\n", config_file.c_str());
+    return -1;
+  }
+
+  // Some models find the configuration from the environment
+  char config_path[PATH_MAX];
+  if (getenv("PULP_CONFIG_FILE") == NULL && realpath(config_file.c_str(), config_path))
+    setenv("PULP_CONFIG_FILE", config_path, 1);
+
+  // The implementations are found where python would find them
+  const char *python_path = getenv("PYTHONPATH");
+  if (python_path)
+  {
+    for (auto &dir: split(python_path, ":"))
+    {
+      if (dir != "")
+        module_paths.push_back(dir);
+    }
+  }
+
+  js::config *gvsoc_config = config->get("gvsoc");
+  js::config *top_config = config->get("system_tree/vp_class");
+  if (gvsoc_config == NULL || top_config == NULL)
+  {
+    launcher::error("The specified configuration does not contain any top component\n");
+    return -1;
+  }
+
+  // Implementations to be linked in a static launcher for this platform
+  if (list)
+  {
+    std::vector<std::string> implementations;
+    const char *engines[] = { "vp/trace_engine", "vp/power_engine", "vp/stats_engine", "vp/time_domain" };
+    for (auto engine: engines)
+    {
+      launcher::component comp("", engine, config, "", NULL);
+      if (comp.list_implementations(implementations))
+        return -1;
+    }
+
+    launcher::component top("sys", top_config->get_str(), config->get("system_tree"), "", NULL);
+    if (top.list_implementations(implementations))
+      return -1;
+
+    for (auto &implementation: implementations)
+    {
+      printf("%s\n", implementation.c_str());
+    }
+    return 0;
+  }
+
+  // The debug implementations are used for traces, unless they are enabled
+  // at runtime in the default implementations
+#ifndef VP_TRACE_RUNTIME
+  js::config *traces = gvsoc_config->get("trace");
+  js::config *events = gvsoc_config->get("event");
+  launcher::debug_mode = (traces && traces->get_elems().size() != 0) || (events && events->get_elems().size() != 0);
+#endif
+
+#ifdef LAUNCHER_STATIC
+  if (launcher::debug_mode)
+    fprintf(stderr, "GVSOC launcher warning: traces and events are compiled out of static launchers\n");
+#endif
+
+  launcher::component *trace_engine = new launcher::component("", "vp/trace_engine", gvsoc_config, "gvsoc", NULL);
+  if (trace_engine->create())
+    return -1;
+
+  launcher::component *power_engine = trace_engine->new_comp("", "vp/power_engine", gvsoc_config, "gvsoc");
+  if (power_engine == NULL)
+    return -1;
+
+  launcher::component *stats_engine = power_engine->new_comp("", "vp/stats_engine", gvsoc_config, "gvsoc");
+  if (stats_engine == NULL)
+    return -1;
+
+  launcher::component *time_engine = stats_engine->new_comp("", "vp/time_domain", config, "");
+  if (time_engine == NULL)
+    return -1;
+
+  if (time_engine->new_comp("sys", top_config->get_str(), config->get("system_tree"), "system_tree") == NULL)
+    return -1;
+
+  trace_engine->bind();
+
+  trace_engine->post_post_build_all();
+
+  trace_engine->pre_start_all();
+
+  trace_engine->start_all();
+
+  trace_engine->final_bind();
+
+  // Reset is propagated by the implementations
+  trace_engine->impl->reset(trace_engine->instance, true);
+
+  if (!get_config_bool(config, "**/gvsoc/use_external_bridge"))
+    trace_engine->impl->reset(trace_engine->instance, false);
+
+  if (trace_engine->load_all())
+    return -1;
+
+  if (build_only || get_config_bool(config, "**/gvsoc/build_only"))
+    return 0;
+
+  std::string status = time_engine->impl->run(time_engine->instance);
+
+  trace_engine->stop_all();
+
+  if (status == "killed")
+  {
+    printf("The top engine was not responding and was killed\n");
+    return -1;
+  }
+  else if (status == "error")
+  {
+    return -1;
+  }
+
+  return time_engine->impl->run_status(time_engine->instance);
+}
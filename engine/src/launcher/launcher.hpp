@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __LAUNCHER_LAUNCHER_HPP__
+#define __LAUNCHER_LAUNCHER_HPP__
+
+#include "json.hpp"
+#include <string>
+#include <vector>
+#include <map>
+
+// Native launcher, building and running a platform from plt_config.json
+// without python. It does what vp_runner.py and vp_core.py do: the model
+// implementations are loaded with dlopen, and the components are built,
+// bound and go through the same phases in the same order. The behaviors
+// which are implemented in python by some component classes are given by
+// the class registry.
+
+namespace launcher {
+
+  class component;
+
+  // In static builds, the implementations are linked in the launcher, and
+  // each one gets a table of the symbols it exports, generated by
+  // gvsoc-static
+  typedef struct
+  {
+    const char *name;
+    void *address;
+  } static_symbol_t;
+
+  typedef struct
+  {
+    const char *name;
+    const static_symbol_t *symbols;
+  } static_module_t;
+
+#ifdef LAUNCHER_STATIC
+  extern const static_module_t static_modules[];
+#endif
+
+  // Functions exported by every model implementation
+  class module
+  {
+  public:
+    module(void *handle, std::string path, const static_symbol_t *symbols=NULL);
+
+    void *handle;
+    std::string path;
+    const static_symbol_t *symbols;
+
+    void *(*constructor)(const char *config);
+    void (*comp_conf)(void *comp, const char *path, void *parent);
+    int (*build)(void *comp);
+    const char *(*get_error)();
+    int (*get_ports)(void *comp, bool master, int size, const char *names[], void *ports[]);
+    int (*get_services)(void *comp, int size, const char *names[], void *services[]);
+    void (*set_services)(void *comp, int nb_services, const char *names[], void *services[]);
+    void (*port_bind_to)(void *master, void *slave, const char *config);
+    void (*port_finalize)(void *master);
+    void (*post_post_build)(void *comp);
+    void (*pre_start)(void *comp);
+    void (*start)(void *comp);
+    void (*reset)(void *comp, int active);
+    void (*load)(void *comp);
+    void (*stop)(void *comp);
+    const char *(*run)(void *comp);
+    int (*run_status)(void *comp);
+    int (*config_tree_load)(const char *config);
+    int (*config_tree_select)(const char *path);
+
+    // Any other function exported by the implementation, or NULL
+    void *get_symbol(const char *name);
+  };
+
+  // Load the implementation, given by its python module name, from the
+  // python path, or from its debug variant if traces are active
+  module *get_module(std::string implementation);
+
+  // Name of the implementation as declared in the makefiles
+  std::string get_module_name(std::string implementation);
+
+
+  #define LAUNCHER_CLASS_TIME_ENGINE (1<<0)
+  #define LAUNCHER_CLASS_PYTHON_ONLY (1<<1)
+
+  // What the python class of a component does on top of its implementation.
+  // Classes which are not in the registry only have an implementation whose
+  // name is the class name followed by _impl, get_class returns NULL for
+  // them.
+  typedef struct
+  {
+    const char *name;
+    // Implementation module, unless it is chosen from the configuration
+    const char *implementation;
+    int flags;
+    std::string (*get_implementation)(component *comp);
+    int (*build)(component *comp);
+    void (*pre_start)(component *comp);
+    int (*load)(component *comp);
+  } component_class_t;
+
+  const component_class_t *get_class(std::string name);
+
+
+  class port
+  {
+  public:
+    typedef enum {
+      MASTER,
+      SLAVE,
+      // Port declared by the python class, forwarding to the ports bound to it
+      COMPOSITE
+    } port_type_e;
+
+    port(component *comp, std::string name, port_type_e type, void *ref=NULL);
+
+    bool is_master() { return this->type != SLAVE; }
+    bool is_slave() { return this->type != MASTER; }
+
+    void bind_to(port *slave);
+
+    // Implementation slave ports this port stands for
+    void get_ports(std::vector<port *> &ports);
+
+    void bind();
+    void final_bind();
+
+    component *comp;
+    std::string name;
+    port_type_e type;
+    void *ref;
+    std::vector<port *> slaves;
+    bool is_bound = false;
+    bool is_bound_to_port = false;
+  };
+
+
+  class component
+  {
+  public:
+    component(std::string name, std::string cls, js::config *config, std::string config_path, component *parent);
+
+    // Load and construct the implementation, and build the component
+    int create();
+
+    // Implementation of the component, empty if it has none
+    int get_implementation(std::string &implementation);
+
+    // Implementations used by the component and its sub-components, without
+    // loading them
+    int list_implementations(std::vector<std::string> &implementations);
+
+    void bind();
+    void post_post_build_all();
+    void pre_start_all();
+    void start_all();
+    void final_bind();
+    int load_all();
+    void stop_all();
+
+    component *new_comp(std::string name, std::string cls, js::config *config, std::string config_path);
+    component *get_comp_from_list(std::vector<std::string> name_list);
+    component *get_time_engine();
+
+    port *get_port(std::string name);
+    void new_port(std::string name);
+
+    int create_comps();
+    int create_ports();
+    int create_bindings();
+
+    std::string name;
+    std::string path;
+    std::string cls_name;
+    js::config *config;
+    std::string config_path;
+    component *parent;
+    const component_class_t *cls;
+    module *impl = NULL;
+    void *instance = NULL;
+
+    std::vector<component *> sub_comps;
+    std::map<std::string, component *> sub_comps_dict;
+    std::map<std::string, port *> master_ports;
+    std::map<std::string, port *> slave_ports;
+    std::map<std::string, port *> ports;
+
+  private:
+    int build_all();
+    int get_impl_ports(bool master);
+  };
+
+
+  // Configuration values given either as numbers or as strings
+  bool get_config_int(js::config *config, std::string name, int64_t *value);
+
+  void error(const char *fmt, ...);
+
+  extern bool debug_mode;
+  extern int max_path_len;
+};
+
+#endif
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "launcher/launcher.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <elf.h>
+#include <fstream>
+#include <iterator>
+
+using namespace launcher;
+
+
+// Composite components, whose sub-components, ports and bindings are
+// described in their configuration (utils/composite.py)
+static int composite_build(component *comp)
+{
+  if (comp->create_comps() || comp->create_ports() || comp->create_bindings())
+    return -1;
+  return 0;
+}
+
+
+// Trace engine (vp/trace_engine.py)
+static int trace_engine_build(component *comp)
+{
+  void (*trace_level)(void *, const char *) = (void (*)(void *, const char *))comp->impl->get_symbol("vp_trace_level");
+  void (*add_paths)(void *, int, int, const char **) = (void (*)(void *, int, int, const char **))comp->impl->get_symbol("vp_trace_add_paths");
+
+  js::config *level = comp->config->get("trace-level");
+  if (level)
+    trace_level(comp->instance, level->get_str().c_str());
+
+  for (int event=0; event<2; event++)
+  {
+    js::config *paths_config = comp->config->get(event ? "event" : "trace");
+    if (paths_config == NULL)
+      continue;
+
+    std::vector<std::string> paths;
+    for (auto path: paths_config->get_elems())
+    {
+      paths.push_back(path->get_str());
+    }
+
+    std::vector<const char *> paths_str;
+    for (auto &path: paths)
+    {
+      paths_str.push_back(path.c_str());
+    }
+
+    add_paths(comp->instance, event, paths_str.size(), paths_str.data());
+  }
+
+  return 0;
+}
+
+static void trace_engine_pre_start(component *comp)
+{
+  int (*exchange)(void *, int) = (int (*)(void *, int))comp->impl->get_symbol("vp_trace_exchange_max_path_len");
+
+  int len = exchange(comp->instance, max_path_len);
+  if (len > max_path_len)
+    max_path_len = len;
+}
+
+
+// Clock domains get the time engine before they start (vp/clock_domain.py)
+static void clock_domain_pre_start(component *comp)
+{
+  void (*set_time_engine)(void *, void *) = (void (*)(void *, void *))comp->impl->get_symbol("vp_set_time_engine");
+  component *engine = comp->get_time_engine();
+  set_time_engine(comp->instance, engine ? engine->instance : NULL);
+}
+
+
+// Cores and uDMA choose their implementation from their configuration
+// (cpu/iss/iss.py and pulp/udma/udma_v*.py)
+static std::string iss_get_implementation(component *comp)
+{
+  js::config *iss_class = comp->config->get("iss_class");
+  return "cpu/iss/" + (iss_class ? iss_class->get_str() : std::string("iss_riscy"));
+}
+
+static std::string udma_get_implementation(component *comp)
+{
+  js::config *udma_class = comp->config->get("vp_impl");
+  if (udma_class == NULL)
+  {
+    error("uDMA has no implementation (path: %s)\n", comp->path.c_str());
+    return "";
+  }
+  return udma_class->get_str();
+}
+
+
+// Binary loader (utils/loader.py), which writes the loadable segments of the
+// binaries through the io path of the loader implementation
+typedef void (*loader_io_req_t)(void *, uint64_t, uint64_t, bool, uint8_t *);
+typedef void (*loader_memset_t)(void *, uint64_t, uint64_t, uint8_t);
+
+template<typename Ehdr, typename Phdr> static int load_elf(component *comp, std::string binary, std::vector<uint8_t> &data, uint64_t *entry)
+{
+  loader_io_req_t io_req = (loader_io_req_t)comp->impl->get_symbol("loader_io_req");
+  loader_memset_t memset = (loader_memset_t)comp->impl->get_symbol("loader_memset");
+
+  Ehdr *ehdr = (Ehdr *)data.data();
+  if (data.size() < sizeof(Ehdr) || ehdr->e_phoff + (uint64_t)ehdr->e_phnum * ehdr->e_phentsize > data.size())
+  {
+    error("Invalid ELF binary (path: %s)\n", binary.c_str());
+    return -1;
+  }
+
+  for (int i=0; i<ehdr->e_phnum; i++)
+  {
+    Phdr *phdr = (Phdr *)(data.data() + ehdr->e_phoff + i * ehdr->e_phentsize);
+    if (phdr->p_type != PT_LOAD)
+      continue;
+
+    if (phdr->p_offset + phdr->p_filesz > data.size())
+    {
+      error("Invalid ELF segment (path: %s, segment: %d)\n", binary.c_str(), i);
+      return -1;
+    }
+
+    io_req(comp->instance, phdr->p_paddr, phdr->p_filesz, true, data.data() + phdr->p_offset);
+
+    if (phdr->p_filesz < phdr->p_memsz)
+      memset(comp->instance, phdr->p_paddr + phdr->p_filesz, phdr->p_memsz - phdr->p_filesz, 0);
+  }
+
+  *entry = ehdr->e_entry;
+
+  return 0;
+}
+
+static void loader_write_word(component *comp, uint64_t addr, uint32_t value)
+{
+  loader_io_req_t io_req = (loader_io_req_t)comp->impl->get_symbol("loader_io_req");
+  uint8_t data[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+  io_req(comp->instance, addr, 4, true, data);
+}
+
+static int loader_load(component *comp)
+{
+  if (comp->config->get("load-binary_eval"))
+  {
+    error("Binary given as a python expression, the platform must be launched from python (path: %s)\n", comp->path.c_str());
+    return -1;
+  }
+
+  js::config *binaries = comp->config->get("binaries");
+  if (binaries == NULL)
+    return 0;
+
+  bool loaded = false;
+  uint64_t entry = 0;
+
+  for (auto binary_config: binaries->get_elems())
+  {
+    std::string binary = binary_config->get_str();
+    std::ifstream file(binary, std::ios::binary);
+    if (!file)
+    {
+      error("Failed to open binary (path: %s)\n", binary.c_str());
+      return -1;
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < EI_NIDENT || memcmp(data.data(), ELFMAG, SELFMAG) != 0)
+    {
+      error("Binary is not an ELF file (path: %s)\n", binary.c_str());
+      return -1;
+    }
+
+    int err = data[EI_CLASS] == ELFCLASS64 ?
+      load_elf<Elf64_Ehdr, Elf64_Phdr>(comp, binary, data, &entry) :
+      load_elf<Elf32_Ehdr, Elf32_Phdr>(comp, binary, data, &entry);
+    if (err)
+      return -1;
+
+    loaded = true;
+  }
+
+  int64_t set_pc_addr, set_pc_offset, start_addr, start_value;
+
+  if (get_config_int(comp->config, "set_pc_addr", &set_pc_addr) && loaded)
+  {
+    if (get_config_int(comp->config, "set_pc_offset", &set_pc_offset))
+      entry += set_pc_offset;
+    loader_write_word(comp, set_pc_addr, entry);
+  }
+
+  if (get_config_int(comp->config, "start_addr", &start_addr))
+  {
+    if (!get_config_int(comp->config, "start_value", &start_value))
+    {
+      error("Start address given without start value (path: %s)\n", comp->path.c_str());
+      return -1;
+    }
+    loader_write_word(comp, start_addr, start_value);
+  }
+
+  return 0;
+}
+
+
+static const component_class_t classes[] = {
+  { "utils/composite",        "utils.composite_impl",      0, NULL, composite_build, NULL, NULL },
+  { "pulp/system",            "utils.composite_impl",      0, NULL, composite_build, NULL, NULL },
+  { "pulp/chip",              "utils.composite_impl",      0, NULL, composite_build, NULL, NULL },
+  { "pulp/soc",               "utils.composite_impl",      0, NULL, composite_build, NULL, NULL },
+  { "pulp/cluster/cluster",   "pulp.cluster.cluster_impl", 0, NULL, composite_build, NULL, NULL },
+  { "pulp/hwpe/example/hwpe", "pulp.hwpe.hwpe_impl",       0, NULL, NULL, NULL, NULL },
+  { "cpu/iss/iss",            NULL,                        0, iss_get_implementation, NULL, NULL, NULL },
+  { "pulp/udma/udma_v2",      NULL,                        0, udma_get_implementation, NULL, NULL, NULL },
+  { "pulp/udma/udma_v3",      NULL,                        0, udma_get_implementation, NULL, NULL, NULL },
+  { "utils/loader",           "utils.loader_impl",         0, NULL, NULL, NULL, loader_load },
+  { "pulp/soc_ico",           NULL,                        LAUNCHER_CLASS_PYTHON_ONLY, NULL, NULL, NULL, NULL },
+  { "vp/trace_engine",        "vp.trace_domain_impl",      0, NULL, trace_engine_build, trace_engine_pre_start, NULL },
+  { "vp/time_domain",         "vp.time_domain_impl",       LAUNCHER_CLASS_TIME_ENGINE, NULL, NULL, NULL, NULL },
+  { "vp/clock_domain",        "vp.clock_domain_impl",      0, NULL, NULL, clock_domain_pre_start, NULL },
+};
+
+
+const component_class_t *launcher::get_class(std::string name)
+{
+  for (auto &cls: classes)
+  {
+    if (name == cls.name)
+      return &cls;
+  }
+  return NULL;
+}
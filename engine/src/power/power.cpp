@@ -217,6 +217,20 @@ void vp::component_power::pre_start()
   {
     this->get_engine()->reg_trace(trace);
   }
+
+  for (auto source: this->sources)
+  {
+    source->batched = this->get_engine()->is_batched();
+  }
+}
+
+
+void vp::component_power::set_operating_point(double temp, double volt, double freq)
+{
+  for (auto source: this->sources)
+  {
+    source->setup(temp, volt, freq);
+  }
 }
 
 
@@ -238,6 +252,9 @@ int vp::component_power::new_event(std::string name, power_source *source, js::c
 
   source->setup(VP_POWER_DEFAULT_TEMP, VP_POWER_DEFAULT_VOLT, VP_POWER_DEFAULT_FREQ);
 
+  this->sources.push_back(source);
+  trace->reg_source(source);
+
   return 0;
 }
 
@@ -266,6 +283,9 @@ int vp::power_trace::init(component *top, std::string name)
 void vp::power_trace::clear()
 {
   this->dumped = false;
+  // The energy of the current cycle goes to the new capture. In batched
+  // mode, the events of the current cycle are still counted by the sources
+  // and will be folded into it.
   this->total = this->get_value();
   this->total_leakage = 0;
   this->last_clear_timestamp = this->top->get_time();
@@ -282,12 +302,19 @@ void vp::power_trace::get(double *dynamic, double *leakage)
   *leakage = this->get_total_leakage() / (this->top->get_time() - this->last_clear_timestamp);
 }
 
-void vp::power_trace::dump(FILE *file)
+void vp::power_trace::flush_child_traces()
 {
-  for (auto x: child_traces)
+  for (auto x: this->child_traces)
   {
+    x->flush_child_traces();
     x->flush();
+    x->fold_deferred();
   }
+}
+
+void vp::power_trace::dump(FILE *file)
+{
+  this->flush_child_traces();
 
 
   fprintf(file, "Trace path; Dynamic power (W); Leakage power (W); Total (W); Percentage\n");
@@ -333,7 +360,7 @@ void vp::power_trace::account_power()
   {
     double energy = this->current_power * diff;
     if (this->top_trace)
-      this->top_trace->incr(energy);
+      this->incr_top(energy, false);
     this->total += energy;
     this->current_power_timestamp = this->top->get_time();
   }
@@ -347,13 +374,51 @@ void vp::power_trace::account_leakage_power()
     double energy = this->current_leakage_power * diff;
     if (this->top_trace)
     {
-      this->top_trace->incr(energy, true);
+      this->incr_top(energy, true);
     }
     this->total_leakage += energy;
     this->current_leakage_power_timestamp = this->top->get_time();
   }
 }
 
+void vp::power_trace::fold(bool current_cycle)
+{
+  for (auto source: this->sources)
+  {
+    source->fold(current_cycle);
+  }
+}
+
+void vp::power_trace::account_energy(double energy)
+{
+  if (this->top_trace)
+  {
+    if (this->deferred)
+      this->deferred_energy += energy;
+    else
+      this->top_trace->account_energy(energy);
+  }
+  this->total += energy;
+}
+
+void vp::power_trace::fold_deferred()
+{
+  if (this->deferred_energy == 0 && this->deferred_leakage == 0)
+    return;
+
+  // All groups are stopped, the energy can go to the whole hierarchy at
+  // once. The top traces accumulate their own energy separately, so it is
+  // not counted twice.
+  for (vp::power_trace *trace = this->top_trace; trace; trace = trace->top_trace)
+  {
+    trace->total += this->deferred_energy;
+    trace->total_leakage += this->deferred_leakage;
+  }
+
+  this->deferred_energy = 0;
+  this->deferred_leakage = 0;
+}
+
 void vp::power_trace::set_power(double quantum, bool is_leakage)
 {
   if (is_leakage)
@@ -382,9 +447,56 @@ vp::power_trace *vp::power_trace::get_top_trace()
 }
 
 
+void vp::power_source::fold(bool current_cycle)
+{
+  if (this->cycle_timestamp != this->top->get_time())
+  {
+    this->nb_events += this->cycle_events;
+    this->cycle_events = 0;
+  }
+
+  if (current_cycle)
+  {
+    this->nb_events += this->cycle_events;
+    this->cycle_events = 0;
+  }
+
+  if (this->nb_events)
+  {
+    this->trace->account_energy(this->nb_events * this->quantum);
+    this->nb_events = 0;
+  }
+}
+
+
 void vp::power_source::setup(double temp, double volt, double freq)
 {
-  this->quantum = this->table->get(temp, volt, freq);
+  double quantum = 0;
+  bool found = false;
+
+  for (auto &point: this->points)
+  {
+    if (std::get<0>(point) == temp && std::get<1>(point) == volt && std::get<2>(point) == freq)
+    {
+      quantum = std::get<3>(point);
+      found = true;
+      break;
+    }
+  }
+
+  if (!found)
+  {
+    quantum = this->table->get(temp, volt, freq);
+    this->points.push_back(std::make_tuple(temp, volt, freq, quantum));
+  }
+
+  if (this->nb_events || this->cycle_events)
+    this->fold();
+
+  if (this->is_on)
+    this->trace->set_power(quantum - this->quantum, this->is_leakage);
+
+  this->quantum = quantum;
 }
 
 
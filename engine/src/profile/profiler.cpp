@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "vp/vp.hpp"
+#include "vp/profile/profiler.hpp"
+#include <string.h>
+#include <time.h>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+namespace vp {
+
+  class profile_node
+  {
+  public:
+    profile_node(component *comp, int kind, profile_node *parent)
+      : comp(comp), kind(kind), parent(parent) {}
+
+    component *comp;
+    int kind;
+    profile_node *parent;
+    std::map<std::pair<component *, int>, profile_node *> children;
+    // Most calls from a node go to the same child, which avoids the lookup
+    profile_node *last_child = NULL;
+    int64_t calls = 0;
+    uint64_t ticks = 0;
+  };
+
+};
+
+
+class profile_stats
+{
+public:
+  uint64_t self = 0;
+  uint64_t inclusive[2] = { 0, 0 };
+  int64_t calls[2] = { 0, 0 };
+};
+
+
+bool vp::profiler::enabled = false;
+
+static std::mutex profile_mutex;
+static std::vector<vp::profile_node *> profile_roots;
+static thread_local vp::profile_node *profile_current = NULL;
+
+static uint64_t profile_start_ticks;
+static struct timespec profile_start_time;
+
+
+static inline uint64_t profile_get_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+
+void vp::profiler::enable()
+{
+  enabled = true;
+  clock_gettime(CLOCK_MONOTONIC, &profile_start_time);
+  profile_start_ticks = profile_get_ticks();
+}
+
+
+void vp::profiler::enter(profile_frame *frame, component *comp, int kind)
+{
+  profile_node *parent = profile_current;
+  if (unlikely(parent == NULL))
+  {
+    parent = new profile_node(NULL, -1, NULL);
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    profile_roots.push_back(parent);
+  }
+
+  profile_node *node = parent->last_child;
+  if (node == NULL || node->comp != comp || node->kind != kind)
+  {
+    node = parent->children[std::make_pair(comp, kind)];
+    if (node == NULL)
+    {
+      node = new profile_node(comp, kind, parent);
+      parent->children[std::make_pair(comp, kind)] = node;
+    }
+    parent->last_child = node;
+  }
+
+  frame->parent = parent;
+  profile_current = node;
+  frame->start = profile_get_ticks();
+}
+
+
+void vp::profiler::leave(profile_frame *frame)
+{
+  uint64_t end = profile_get_ticks();
+  profile_node *node = profile_current;
+  node->ticks += end - frame->start;
+  node->calls++;
+  profile_current = frame->parent;
+}
+
+
+static void profile_walk(vp::profile_node *node, std::vector<vp::profile_node *> &stack,
+  std::string prefix, std::map<vp::component *, profile_stats> &stats, FILE *folded, double ns_per_tick)
+{
+  uint64_t children_ticks = 0;
+  for (auto &x: node->children)
+  {
+    children_ticks += x.second->ticks;
+  }
+
+  uint64_t self = node->ticks > children_ticks ? node->ticks - children_ticks : 0;
+
+  profile_stats *comp_stats = &stats[node->comp];
+  comp_stats->self += self;
+  comp_stats->calls[node->kind] += node->calls;
+
+  // Time of recursive calls is already included in the outer one
+  bool recursive = false;
+  for (auto ancestor: stack)
+  {
+    if (ancestor->comp == node->comp && ancestor->kind == node->kind)
+      recursive = true;
+  }
+  if (!recursive)
+    comp_stats->inclusive[node->kind] += node->ticks;
+
+  std::string name = node->comp->get_path();
+  if (node->kind == PROFILE_REQ)
+    name += ":req";
+  std::string path = prefix == "" ? name : prefix + ";" + name;
+
+  if (folded && self)
+    fprintf(folded, "%s %ld\n", path.c_str(), (int64_t)(self * ns_per_tick));
+
+  stack.push_back(node);
+  for (auto &x: node->children)
+  {
+    profile_walk(x.second, stack, path, stats, folded, ns_per_tick);
+  }
+  stack.pop_back();
+}
+
+
+void vp::profiler::dump(std::string report_path, std::string folded_path)
+{
+  if (!enabled)
+    return;
+
+  struct timespec end_time;
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+  uint64_t end_ticks = profile_get_ticks();
+
+  double elapsed_ns = (end_time.tv_sec - profile_start_time.tv_sec) * 1e9 +
+    (end_time.tv_nsec - profile_start_time.tv_nsec);
+  double ns_per_tick = end_ticks > profile_start_ticks ?
+    elapsed_ns / (end_ticks - profile_start_ticks) : 1.0;
+
+  FILE *folded = NULL;
+  if (folded_path != "")
+  {
+    folded = fopen(folded_path.c_str(), "w");
+    if (folded == NULL)
+    {
+      fprintf(stderr, "Unable to open profile file (path: %s, error: %s)\n", folded_path.c_str(), strerror(errno));
+    }
+  }
+
+  std::map<vp::component *, profile_stats> stats;
+  std::vector<vp::profile_node *> stack;
+  uint64_t total = 0;
+
+  for (auto root: profile_roots)
+  {
+    for (auto &x: root->children)
+    {
+      total += x.second->ticks;
+      profile_walk(x.second, stack, "", stats, folded, ns_per_tick);
+    }
+  }
+
+  if (folded)
+    fclose(folded);
+
+  std::vector<std::pair<vp::component *, profile_stats>> sorted(stats.begin(), stats.end());
+  std::sort(sorted.begin(), sorted.end(),
+    [](const std::pair<vp::component *, profile_stats> &a, const std::pair<vp::component *, profile_stats> &b) {
+      return a.second.self > b.second.self;
+    });
+
+  FILE *file = stdout;
+  if (report_path != "")
+  {
+    file = fopen(report_path.c_str(), "w");
+    if (file == NULL)
+    {
+      fprintf(stderr, "Unable to open profile file (path: %s, error: %s)\n", report_path.c_str(), strerror(errno));
+      return;
+    }
+  }
+
+  fprintf(file, "Host time profile (simulation: %f s, profiled: %f s)\n", elapsed_ns / 1e9, total * ns_per_tick / 1e9);
+  fprintf(file, "%12s %7s %12s %14s %12s %14s  %s\n", "Self (ms)", "Self %", "Events", "Avg event (ns)",
+    "Requests", "Avg req (ns)", "Path");
+
+  for (auto &x: sorted)
+  {
+    profile_stats *comp_stats = &x.second;
+    double avg_event = comp_stats->calls[PROFILE_EVENT] ?
+      comp_stats->inclusive[PROFILE_EVENT] * ns_per_tick / comp_stats->calls[PROFILE_EVENT] : 0;
+    double avg_req = comp_stats->calls[PROFILE_REQ] ?
+      comp_stats->inclusive[PROFILE_REQ] * ns_per_tick / comp_stats->calls[PROFILE_REQ] : 0;
+
+    fprintf(file, "%12.3f %6.2f%% %12ld %14.1f %12ld %14.1f  %s\n",
+      comp_stats->self * ns_per_tick / 1e6, total ? 100.0 * comp_stats->self / total : 0.0,
+      comp_stats->calls[PROFILE_EVENT], avg_event,
+      comp_stats->calls[PROFILE_REQ], avg_req,
+      x.first->get_path().c_str());
+  }
+
+  if (file != stdout)
+    fclose(file);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "vp/vp.hpp"
+#include "vp/stats/stats_engine.hpp"
+
+
+vp::component_stats::component_stats(vp::component &top)
+: top(top)
+{
+}
+
+
+void vp::component_stats::init_stat(vp::stat *stat, std::string name, vp::stat_type_e type)
+{
+  stat->type = type;
+  stat->comp = &top;
+  stat->name = top.get_path() + "/" + name;
+  this->stats.push_back(stat);
+}
+
+
+void vp::component_stats::new_stat(std::string name, vp::stat_scalar *stat)
+{
+  this->init_stat(stat, name, vp::STAT_SCALAR);
+}
+
+
+void vp::component_stats::new_stat(std::string name, vp::stat_rate *stat)
+{
+  this->init_stat(stat, name, vp::STAT_RATE);
+}
+
+
+void vp::component_stats::new_stat(std::string name, vp::stat_histogram *stat, int nb_buckets, int64_t bucket_width)
+{
+  stat->nb_buckets = nb_buckets;
+  stat->bucket_width = bucket_width;
+  stat->buckets = new int64_t[nb_buckets]();
+  this->init_stat(stat, name, vp::STAT_HISTOGRAM);
+}
+
+
+void vp::component_stats::post_post_build()
+{
+  stats_manager = (vp::stats_engine *)top.get_service("stats");
+
+  // Platforms may be launched without stats engine, in which case the stats
+  // are still updated but never dumped
+  if (stats_manager)
+  {
+    for (auto stat: this->stats)
+    {
+      stats_manager->reg_stat(stat);
+    }
+  }
+}
@@ -22,6 +22,7 @@
 #include "vp/vp.hpp"
 #include "vp/trace/event_dumper.hpp"
 #include <string.h>
+#include <thread>
 
 vp::Fst_file::Fst_file(vp::Event_dumper *dumper, string path)
 {
@@ -30,6 +31,26 @@ vp::Fst_file::Fst_file(vp::Event_dumper *dumper, string path)
   {
     dumper->comp->get_engine()->fatal("Error while opening FST file (path: %s)\n", path.c_str());
   }
+
+  // With threads set, blocks are flushed on a separate thread while the next
+  // one is filled, and their value changes are compressed by a pool of this
+  // many threads. The file content is the same as with the default writer.
+  js::config *config = dumper->comp->get_js_config("**/vcd/fst/threads");
+  int nb_threads = config ? config->get_int() : 0;
+  if (nb_threads > 0)
+  {
+    int nb_cores = std::thread::hardware_concurrency();
+    if (nb_cores > 0 && nb_threads > nb_cores)
+      nb_threads = nb_cores;
+
+    fstWriterSetParallelMode(this->writer, 1);
+    fstWriterSetCompressThreads(this->writer, nb_threads);
+
+    // Block size then follows the time taken to flush the previous one
+    config = dumper->comp->get_js_config("**/vcd/fst/adaptive");
+    if (config && config->get_bool())
+      fstWriterSetAdaptiveBreakSize(this->writer, 1);
+  }
 }
 
 
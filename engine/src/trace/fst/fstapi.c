@@ -49,6 +49,7 @@
 
 #ifdef FST_WRITER_PARALLEL
 #include <pthread.h>
+#include <time.h>
 #endif
 
 #ifdef __MINGW32__
@@ -772,6 +773,11 @@ pthread_mutex_t mutex;
 pthread_t thread;
 pthread_attr_t thread_attr;
 struct fstWriterContext *xc_parent;
+
+int compress_threads;           /* number of threads compressing value change chains of a block */
+unsigned adaptive_break : 1;    /* block size follows the flush time */
+uint64_t flush_start_ns;        /* when the previous block flush started */
+uint64_t flush_time_ns;         /* how long the previous block flush took, set by the flush thread */
 #endif
 
 size_t fst_orig_break_size;
@@ -1221,6 +1227,312 @@ if(xc)
 }
 
 
+/*
+ * encodes the value change chain of a variable starting at offs, building
+ * the buffer backwards from scratchpnt, and returns the start of the buffer.
+ * when scratchstart is not NULL, returns NULL if the buffer is too small.
+ */
+static unsigned char *fstWriterEncodeChain(struct fstWriterContext *xc, uint32_t *vm4ip, uint32_t offs, unsigned char *scratchstart, unsigned char *scratchpnt)
+{
+unsigned char *vchg_mem = xc->vchg_mem;
+uint32_t next_offs;
+unsigned int wrlen;
+
+if(vm4ip[1] <= 1)
+        {
+        if(vm4ip[1] == 1)
+                {
+                wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
+#ifndef FST_REMOVE_DUPLICATE_VC
+                xc->curval_mem[vm4ip[0]] = vchg_mem[offs + 4 + wrlen]; /* checkpoint variable */
+#endif
+                while(offs)
+                        {
+                        unsigned char val;
+                        uint32_t time_delta, rcv;
+
+                        if(scratchstart && (scratchpnt - scratchstart < 5)) return(NULL);
+
+                        next_offs = fstGetUint32(vchg_mem + offs);
+                        offs += 4;
+
+                        time_delta = fstGetVarint32(vchg_mem + offs, (int *)&wrlen);
+                        val = vchg_mem[offs+wrlen];
+                        offs = next_offs;
+
+                        switch(val)
+                                {
+                                case '0':
+                                case '1':               rcv = ((val&1)<<1) | (time_delta<<2);
+                                                        break; /* pack more delta bits in for 0/1 vchs */
+
+                                case 'x': case 'X':     rcv = FST_RCV_X | (time_delta<<4); break;
+                                case 'z': case 'Z':     rcv = FST_RCV_Z | (time_delta<<4); break;
+                                case 'h': case 'H':     rcv = FST_RCV_H | (time_delta<<4); break;
+                                case 'u': case 'U':     rcv = FST_RCV_U | (time_delta<<4); break;
+                                case 'w': case 'W':     rcv = FST_RCV_W | (time_delta<<4); break;
+                                case 'l': case 'L':     rcv = FST_RCV_L | (time_delta<<4); break;
+                                default:                rcv = FST_RCV_D | (time_delta<<4); break;
+                                }
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, rcv);
+                        }
+                }
+                else
+                {
+                /* variable length */
+                /* fstGetUint32 (next_offs) + fstGetVarint32 (time_delta) + fstGetVarint32 (len) + payload */
+                unsigned char *pnt;
+                uint32_t record_len;
+                uint32_t time_delta;
+
+                while(offs)
+                        {
+                        next_offs = fstGetUint32(vchg_mem + offs);
+                        offs += 4;
+                        pnt = vchg_mem + offs;
+                        offs = next_offs;
+                        time_delta = fstGetVarint32(pnt, (int *)&wrlen);
+                        pnt += wrlen;
+                        record_len = fstGetVarint32(pnt, (int *)&wrlen);
+                        pnt += wrlen;
+
+                        if(scratchstart && ((uint32_t)(scratchpnt - scratchstart) < record_len + 10)) return(NULL);
+
+                        scratchpnt -= record_len;
+                        memcpy(scratchpnt, pnt, record_len);
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, record_len);
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1)); /* reserve | 1 case for future expansion */
+                        }
+                }
+        }
+        else
+        {
+        wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
+#ifndef FST_REMOVE_DUPLICATE_VC
+        memcpy(xc->curval_mem + vm4ip[0], vchg_mem + offs + 4 + wrlen, vm4ip[1]); /* checkpoint variable */
+#endif
+        while(offs)
+                {
+                unsigned int idx;
+                char is_binary = 1;
+                unsigned char *pnt;
+                uint32_t time_delta;
+
+                if(scratchstart && ((uint32_t)(scratchpnt - scratchstart) < vm4ip[1] + 5)) return(NULL);
+
+                next_offs = fstGetUint32(vchg_mem + offs);
+                offs += 4;
+
+                time_delta = fstGetVarint32(vchg_mem + offs, (int *)&wrlen);
+
+                pnt = vchg_mem+offs+wrlen;
+                offs = next_offs;
+
+                for(idx=0;idx<vm4ip[1];idx++)
+                        {
+                        if((pnt[idx] == '0') || (pnt[idx] == '1'))
+                                {
+                                continue;
+                                }
+                                else
+                                {
+                                is_binary = 0;
+                                break;
+                                }
+                        }
+
+                if(is_binary)
+                        {
+                        unsigned char acc = 0;
+                        /* new algorithm */
+                        idx = ((vm4ip[1]+7) & ~7);
+                        switch(vm4ip[1] & 7)
+                                {
+                                case 0: do {    acc  = (pnt[idx+7-8] & 1) << 0; /* fallthrough */
+                                case 7:         acc |= (pnt[idx+6-8] & 1) << 1; /* fallthrough */
+                                case 6:         acc |= (pnt[idx+5-8] & 1) << 2; /* fallthrough */
+                                case 5:         acc |= (pnt[idx+4-8] & 1) << 3; /* fallthrough */
+                                case 4:         acc |= (pnt[idx+3-8] & 1) << 4; /* fallthrough */
+                                case 3:         acc |= (pnt[idx+2-8] & 1) << 5; /* fallthrough */
+                                case 2:         acc |= (pnt[idx+1-8] & 1) << 6; /* fallthrough */
+                                case 1:         acc |= (pnt[idx+0-8] & 1) << 7;
+                                                *(--scratchpnt) = acc;
+                                                idx -= 8;
+                                        } while(idx);
+                                }
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1));
+                        }
+                        else
+                        {
+                        scratchpnt -= vm4ip[1];
+                        memcpy(scratchpnt, pnt, vm4ip[1]);
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1) | 1);
+                        }
+                }
+        }
+
+return(scratchpnt);
+}
+
+
+#ifdef FST_WRITER_PARALLEL
+/*
+ * a value change chain encoded and compressed by a worker, waiting
+ * to be written in handle order
+ */
+struct fstWriterCompressedChain
+{
+unsigned char *mem;     /* compressed or raw encoded chain */
+uint32_t len;           /* length of mem */
+uint32_t unc_len;       /* uncompressed length written in front of mem, 0 when raw */
+uint32_t wrlen;         /* encoded length, for reader memory requirement */
+};
+
+struct fstWriterCompressPool
+{
+struct fstWriterContext *xc;
+struct fstWriterCompressedChain *chains;
+uint32_t next_handle;   /* next chunk of handles to compress, taken atomically */
+};
+
+#define FST_COMPRESS_CHUNK (64)
+#define FST_COMPRESS_SCRATCH_SIZE (1UL << 16)
+
+
+/*
+ * compresses chunks of chains until all handles are done, the packing
+ * decisions are the same as in the sequential writer so that the file
+ * content does not depend on the number of threads
+ */
+static void *fstWriterCompressWorker(void *ctx)
+{
+struct fstWriterCompressPool *pool = (struct fstWriterCompressPool *)ctx;
+struct fstWriterContext *xc = pool->xc;
+uint32_t scratchlen = FST_COMPRESS_SCRATCH_SIZE;
+unsigned char *scratchpad = (unsigned char *)malloc(scratchlen);
+
+for(;;)
+        {
+        uint32_t first = __atomic_fetch_add(&pool->next_handle, FST_COMPRESS_CHUNK, __ATOMIC_RELAXED);
+        uint32_t last = first + FST_COMPRESS_CHUNK;
+        uint32_t i;
+
+        if(first >= xc->maxhandle) break;
+        if(last > xc->maxhandle) last = xc->maxhandle;
+
+        for(i=first;i<last;i++)
+                {
+                uint32_t *vm4ip = &(xc->valpos_mem[4*i]);
+                struct fstWriterCompressedChain *chain = &pool->chains[i];
+                unsigned char *scratchpnt;
+                unsigned char *dmem;
+                uint32_t wrlen;
+
+                if(!vm4ip[2]) continue;
+
+                /* the scratchpad is grown until the chain fits, which is rare after the first chains */
+                while(!(scratchpnt = fstWriterEncodeChain(xc, vm4ip, vm4ip[2], scratchpad, scratchpad + scratchlen)))
+                        {
+                        free(scratchpad);
+                        scratchpad = (unsigned char *)malloc(scratchlen *= 2);
+                        }
+                wrlen = scratchpad + scratchlen - scratchpnt;
+                chain->wrlen = wrlen;
+
+                if(wrlen > 32)
+                        {
+                        if(!xc->fastpack)
+                                {
+                                unsigned long destlen = wrlen;
+
+                                dmem = (unsigned char *)malloc(compressBound(wrlen));
+                                if(compress2(dmem, &destlen, scratchpnt, wrlen, 4) == Z_OK)
+                                        {
+                                        chain->mem = dmem;
+                                        chain->len = destlen;
+                                        chain->unc_len = wrlen;
+                                        continue;
+                                        }
+                                }
+                                else
+                                {
+                                unsigned int rc;
+
+                                dmem = (unsigned char *)malloc((wrlen * 2) + 2);
+                                rc = (xc->fourpack) ? LZ4_compress((char *)scratchpnt, (char *)dmem, wrlen) : fastlz_compress(scratchpnt, wrlen, dmem);
+                                if(rc < wrlen)
+                                        {
+                                        chain->mem = dmem;
+                                        chain->len = rc;
+                                        chain->unc_len = wrlen;
+                                        continue;
+                                        }
+                                }
+                        free(dmem);
+                        }
+
+                chain->mem = (unsigned char *)malloc(wrlen);
+                memcpy(chain->mem, scratchpnt, wrlen);
+                chain->len = wrlen;
+                chain->unc_len = 0;
+                }
+        }
+
+free(scratchpad);
+return(NULL);
+}
+
+
+/*
+ * encodes and compresses all the value change chains of the block on
+ * compress_threads threads, including the calling one
+ */
+static struct fstWriterCompressedChain *fstWriterCompressChains(struct fstWriterContext *xc)
+{
+struct fstWriterCompressPool pool;
+pthread_t *threads;
+int nb_threads = xc->compress_threads - 1;
+int i;
+
+pool.xc = xc;
+pool.chains = (struct fstWriterCompressedChain *)calloc(xc->maxhandle ? xc->maxhandle : 1, sizeof(struct fstWriterCompressedChain));
+pool.next_handle = 0;
+
+threads = (pthread_t *)malloc(nb_threads * sizeof(pthread_t));
+for(i=0;i<nb_threads;i++)
+        {
+        if(pthread_create(&threads[i], NULL, fstWriterCompressWorker, &pool))
+                {
+                nb_threads = i;
+                break;
+                }
+        }
+
+fstWriterCompressWorker(&pool);
+
+for(i=0;i<nb_threads;i++)
+        {
+        pthread_join(threads[i], NULL);
+        }
+free(threads);
+
+return(pool.chains);
+}
+
+
+static uint64_t fstWriterGetTimeNs(void)
+{
+struct timespec ts;
+clock_gettime(CLOCK_MONOTONIC, &ts);
+return((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+#endif
+
+
 /*
  * only to be called directly by fst code...otherwise must
  * be synced up with time changes
@@ -1235,12 +1547,11 @@ static void fstWriterFlushContextPrivate(void *ctx)
 int cnt = 0;
 #endif
 unsigned int i;
-unsigned char *vchg_mem;
 FILE *f;
 off_t fpos, indxpos, endpos;
 uint32_t prevpos;
 int zerocnt;
-unsigned char *scratchpad;
+unsigned char *scratchpad = NULL;
 unsigned char *scratchpnt;
 unsigned char *tmem;
 off_t tlen;
@@ -1271,9 +1582,6 @@ if((xc->vchg_siz <= 1)||(xc->already_in_flush)) return;
 xc->already_in_flush = 1; /* should really do this with a semaphore */
 
 xc->section_header_only = 0;
-scratchpad = (unsigned char *)malloc(xc->vchg_siz);
-
-vchg_mem = xc->vchg_mem;
 
 f = xc->handle;
 fstWriterVarint(f, xc->maxhandle);      /* emit current number of handles */
@@ -1283,292 +1591,211 @@ fpos = 1;
 packmemlen = 1024;                      /* maintain a running "longest" allocation to */
 packmem = (unsigned char *)malloc(packmemlen);           /* prevent continual malloc...free every loop iter */
 
-for(i=0;i<xc->maxhandle;i++)
+#ifdef FST_WRITER_PARALLEL
+if(xc->compress_threads > 1)
         {
-        vm4ip = &(xc->valpos_mem[4*i]);
+        /* chains are encoded and compressed by the worker pool, then written in handle order */
+        struct fstWriterCompressedChain *chains = fstWriterCompressChains(xc);
 
-        if(vm4ip[2])
+        for(i=0;i<xc->maxhandle;i++)
                 {
-                uint32_t offs = vm4ip[2];
-                uint32_t next_offs;
-                unsigned int wrlen;
+                struct fstWriterCompressedChain *chain = &chains[i];
 
-                vm4ip[2] = fpos;
+                vm4ip = &(xc->valpos_mem[4*i]);
 
-                scratchpnt = scratchpad + xc->vchg_siz;         /* build this buffer backwards */
-                if(vm4ip[1] <= 1)
+                if(vm4ip[2])
                         {
-                        if(vm4ip[1] == 1)
+                        vm4ip[2] = fpos;
+                        unc_memreq += chain->wrlen;
+#ifndef FST_DYNAMIC_ALIAS_DISABLE
+                        PPvoid_t pv = JudyHSIns(&PJHSArray, chain->mem, chain->len, NULL);
+                        if(*pv)
                                 {
-                                wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
-#ifndef FST_REMOVE_DUPLICATE_VC
-                                xc->curval_mem[vm4ip[0]] = vchg_mem[offs + 4 + wrlen]; /* checkpoint variable */
-#endif
-                                while(offs)
-                                        {
-                                        unsigned char val;
-                                        uint32_t time_delta, rcv;
-                                        next_offs = fstGetUint32(vchg_mem + offs);
-                                        offs += 4;
-
-                                        time_delta = fstGetVarint32(vchg_mem + offs, (int *)&wrlen);
-                                        val = vchg_mem[offs+wrlen];
-                                        offs = next_offs;
-
-                                        switch(val)
-                                                {
-                                                case '0':
-                                                case '1':               rcv = ((val&1)<<1) | (time_delta<<2);
-                                                                        break; /* pack more delta bits in for 0/1 vchs */
-
-                                                case 'x': case 'X':     rcv = FST_RCV_X | (time_delta<<4); break;
-                                                case 'z': case 'Z':     rcv = FST_RCV_Z | (time_delta<<4); break;
-                                                case 'h': case 'H':     rcv = FST_RCV_H | (time_delta<<4); break;
-                                                case 'u': case 'U':     rcv = FST_RCV_U | (time_delta<<4); break;
-                                                case 'w': case 'W':     rcv = FST_RCV_W | (time_delta<<4); break;
-                                                case 'l': case 'L':     rcv = FST_RCV_L | (time_delta<<4); break;
-                                                default:                rcv = FST_RCV_D | (time_delta<<4); break;
-                                                }
-
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, rcv);
-                                        }
+                                uint32_t pvi = (intptr_t)(*pv);
+                                vm4ip[2] = -pvi;
                                 }
                                 else
                                 {
-                                /* variable length */
-                                /* fstGetUint32 (next_offs) + fstGetVarint32 (time_delta) + fstGetVarint32 (len) + payload */
-                                unsigned char *pnt;
-                                uint32_t record_len;
-                                uint32_t time_delta;
-
-                                while(offs)
-                                        {
-                                        next_offs = fstGetUint32(vchg_mem + offs);
-                                        offs += 4;
-                                        pnt = vchg_mem + offs;
-                                        offs = next_offs;
-                                        time_delta = fstGetVarint32(pnt, (int *)&wrlen);
-                                        pnt += wrlen;
-                                        record_len = fstGetVarint32(pnt, (int *)&wrlen);
-                                        pnt += wrlen;
-
-                                        scratchpnt -= record_len;
-                                        memcpy(scratchpnt, pnt, record_len);
-
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, record_len);
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1)); /* reserve | 1 case for future expansion */
-                                        }
+                                *pv = (void *)(intptr_t)(i+1);
+#endif
+                                fpos += fstWriterVarint(f, chain->unc_len);
+                                fpos += chain->len;
+                                fstFwrite(chain->mem, chain->len, 1, f);
+#ifndef FST_DYNAMIC_ALIAS_DISABLE
                                 }
-                        }
-                        else
-                        {
-                        wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
-#ifndef FST_REMOVE_DUPLICATE_VC
-                        memcpy(xc->curval_mem + vm4ip[0], vchg_mem + offs + 4 + wrlen, vm4ip[1]); /* checkpoint variable */
 #endif
-                        while(offs)
-                                {
-                                unsigned int idx;
-                                char is_binary = 1;
-                                unsigned char *pnt;
-                                uint32_t time_delta;
-
-                                next_offs = fstGetUint32(vchg_mem + offs);
-                                offs += 4;
-
-                                time_delta = fstGetVarint32(vchg_mem + offs, (int *)&wrlen);
-
-                                pnt = vchg_mem+offs+wrlen;
-                                offs = next_offs;
+                        free(chain->mem);
+#ifdef FST_DEBUG
+                        cnt++;
+#endif
+                        }
+                }
 
-                                for(idx=0;idx<vm4ip[1];idx++)
-                                        {
-                                        if((pnt[idx] == '0') || (pnt[idx] == '1'))
-                                                {
-                                                continue;
-                                                }
-                                                else
-                                                {
-                                                is_binary = 0;
-                                                break;
-                                                }
-                                        }
+        free(chains);
+        }
+        else
+#endif
+        {
+        scratchpad = (unsigned char *)malloc(xc->vchg_siz);
 
-                                if(is_binary)
-                                        {
-                                        unsigned char acc = 0;
-                                        /* new algorithm */
-                                        idx = ((vm4ip[1]+7) & ~7);
-                                        switch(vm4ip[1] & 7)
-                                                {
-                                                case 0: do {    acc  = (pnt[idx+7-8] & 1) << 0; /* fallthrough */
-                                                case 7:         acc |= (pnt[idx+6-8] & 1) << 1; /* fallthrough */
-                                                case 6:         acc |= (pnt[idx+5-8] & 1) << 2; /* fallthrough */
-                                                case 5:         acc |= (pnt[idx+4-8] & 1) << 3; /* fallthrough */
-                                                case 4:         acc |= (pnt[idx+3-8] & 1) << 4; /* fallthrough */
-                                                case 3:         acc |= (pnt[idx+2-8] & 1) << 5; /* fallthrough */
-                                                case 2:         acc |= (pnt[idx+1-8] & 1) << 6; /* fallthrough */
-                                                case 1:         acc |= (pnt[idx+0-8] & 1) << 7;
-                                                                *(--scratchpnt) = acc;
-                                                                idx -= 8;
-                                                        } while(idx);
-                                                }
+        for(i=0;i<xc->maxhandle;i++)
+                {
+                vm4ip = &(xc->valpos_mem[4*i]);
 
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1));
-                                        }
-                                        else
-                                        {
-                                        scratchpnt -= vm4ip[1];
-                                        memcpy(scratchpnt, pnt, vm4ip[1]);
+                if(vm4ip[2])
+                        {
+                        uint32_t offs = vm4ip[2];
+                        unsigned int wrlen;
 
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1) | 1);
-                                        }
-                                }
-                        }
+                        vm4ip[2] = fpos;
 
-                wrlen = scratchpad + xc->vchg_siz - scratchpnt;
-                unc_memreq += wrlen;
-                if(wrlen > 32)
-                        {
-                        unsigned long destlen = wrlen;
-                        unsigned char *dmem;
-                        unsigned int rc;
+                        scratchpnt = scratchpad + xc->vchg_siz;         /* build this buffer backwards */
+                        scratchpnt = fstWriterEncodeChain(xc, vm4ip, offs, NULL, scratchpnt);
 
-                        if(!xc->fastpack)
+                        wrlen = scratchpad + xc->vchg_siz - scratchpnt;
+                        unc_memreq += wrlen;
+                        if(wrlen > 32)
                                 {
-                                if(wrlen <= packmemlen)
-                                        {
-                                        dmem = packmem;
-                                        }
-                                        else
-                                        {
-                                        free(packmem);
-                                        dmem = packmem = (unsigned char *)malloc(compressBound(packmemlen = wrlen));
-                                        }
+                                unsigned long destlen = wrlen;
+                                unsigned char *dmem;
+                                unsigned int rc;
 
-                                rc = compress2(dmem, &destlen, scratchpnt, wrlen, 4);
-                                if(rc == Z_OK)
+                                if(!xc->fastpack)
                                         {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                        PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, destlen, NULL);
-                                        if(*pv)
+                                        if(wrlen <= packmemlen)
                                                 {
-                                                uint32_t pvi = (intptr_t)(*pv);
-                                                vm4ip[2] = -pvi;
+                                                dmem = packmem;
                                                 }
                                                 else
                                                 {
-                                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                                fpos += fstWriterVarint(f, wrlen);
-                                                fpos += destlen;
-                                                fstFwrite(dmem, destlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                free(packmem);
+                                                dmem = packmem = (unsigned char *)malloc(compressBound(packmemlen = wrlen));
                                                 }
-#endif
-                                        }
-                                        else
-                                        {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                        PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-                                        if(*pv)
+
+                                        rc = compress2(dmem, &destlen, scratchpnt, wrlen, 4);
+                                        if(rc == Z_OK)
                                                 {
-                                                uint32_t pvi = (intptr_t)(*pv);
-                                                vm4ip[2] = -pvi;
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, destlen, NULL);
+                                                if(*pv)
+                                                        {
+                                                        uint32_t pvi = (intptr_t)(*pv);
+                                                        vm4ip[2] = -pvi;
+                                                        }
+                                                        else
+                                                        {
+                                                        *pv = (void *)(intptr_t)(i+1);
+        #endif
+                                                        fpos += fstWriterVarint(f, wrlen);
+                                                        fpos += destlen;
+                                                        fstFwrite(dmem, destlen, 1, f);
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                        }
+        #endif
                                                 }
                                                 else
                                                 {
-                                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                                fpos += fstWriterVarint(f, 0);
-                                                fpos += wrlen;
-                                                fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
+                                                if(*pv)
+                                                        {
+                                                        uint32_t pvi = (intptr_t)(*pv);
+                                                        vm4ip[2] = -pvi;
+                                                        }
+                                                        else
+                                                        {
+                                                        *pv = (void *)(intptr_t)(i+1);
+        #endif
+                                                        fpos += fstWriterVarint(f, 0);
+                                                        fpos += wrlen;
+                                                        fstFwrite(scratchpnt, wrlen, 1, f);
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                        }
+        #endif
                                                 }
-#endif
-                                        }
-                                }
-                                else
-                                {
-                                /* this is extremely conservative: fastlz needs +5% for worst case, lz4 needs siz+(siz/255)+16 */
-                                if(((wrlen * 2) + 2) <= packmemlen)
-                                        {
-                                        dmem = packmem;
                                         }
                                         else
                                         {
-                                        free(packmem);
-                                        dmem = packmem = (unsigned char *)malloc(packmemlen = (wrlen * 2) + 2);
-                                        }
-
-                                rc = (xc->fourpack) ? LZ4_compress((char *)scratchpnt, (char *)dmem, wrlen) : fastlz_compress(scratchpnt, wrlen, dmem);
-                                if(rc < destlen)
-                                        {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                        PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, rc, NULL);
-                                        if(*pv)
+                                        /* this is extremely conservative: fastlz needs +5% for worst case, lz4 needs siz+(siz/255)+16 */
+                                        if(((wrlen * 2) + 2) <= packmemlen)
                                                 {
-                                                uint32_t pvi = (intptr_t)(*pv);
-                                                vm4ip[2] = -pvi;
+                                                dmem = packmem;
                                                 }
                                                 else
                                                 {
-                                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                                fpos += fstWriterVarint(f, wrlen);
-                                                fpos += rc;
-                                                fstFwrite(dmem, rc, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                free(packmem);
+                                                dmem = packmem = (unsigned char *)malloc(packmemlen = (wrlen * 2) + 2);
                                                 }
-#endif
-                                        }
-                                        else
-                                        {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                        PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-                                        if(*pv)
+
+                                        rc = (xc->fourpack) ? LZ4_compress((char *)scratchpnt, (char *)dmem, wrlen) : fastlz_compress(scratchpnt, wrlen, dmem);
+                                        if(rc < destlen)
                                                 {
-                                                uint32_t pvi = (intptr_t)(*pv);
-                                                vm4ip[2] = -pvi;
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, rc, NULL);
+                                                if(*pv)
+                                                        {
+                                                        uint32_t pvi = (intptr_t)(*pv);
+                                                        vm4ip[2] = -pvi;
+                                                        }
+                                                        else
+                                                        {
+                                                        *pv = (void *)(intptr_t)(i+1);
+        #endif
+                                                        fpos += fstWriterVarint(f, wrlen);
+                                                        fpos += rc;
+                                                        fstFwrite(dmem, rc, 1, f);
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                        }
+        #endif
                                                 }
                                                 else
                                                 {
-                                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                                fpos += fstWriterVarint(f, 0);
-                                                fpos += wrlen;
-                                                fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
+                                                if(*pv)
+                                                        {
+                                                        uint32_t pvi = (intptr_t)(*pv);
+                                                        vm4ip[2] = -pvi;
+                                                        }
+                                                        else
+                                                        {
+                                                        *pv = (void *)(intptr_t)(i+1);
+        #endif
+                                                        fpos += fstWriterVarint(f, 0);
+                                                        fpos += wrlen;
+                                                        fstFwrite(scratchpnt, wrlen, 1, f);
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                                        }
+        #endif
                                                 }
-#endif
                                         }
                                 }
-                        }
-                        else
-                        {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                        PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-                        if(*pv)
-                                {
-                                uint32_t pvi = (intptr_t)(*pv);
-                                vm4ip[2] = -pvi;
-                                }
                                 else
                                 {
-                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                fpos += fstWriterVarint(f, 0);
-                                fpos += wrlen;
-                                fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
+                                if(*pv)
+                                        {
+                                        uint32_t pvi = (intptr_t)(*pv);
+                                        vm4ip[2] = -pvi;
+                                        }
+                                        else
+                                        {
+                                        *pv = (void *)(intptr_t)(i+1);
+        #endif
+                                        fpos += fstWriterVarint(f, 0);
+                                        fpos += wrlen;
+                                        fstFwrite(scratchpnt, wrlen, 1, f);
+        #ifndef FST_DYNAMIC_ALIAS_DISABLE
+                                        }
+        #endif
                                 }
-#endif
-                        }
 
-                /* vm4ip[3] = 0; ...redundant with clearing below */
-#ifdef FST_DEBUG
-                cnt++;
-#endif
+                        /* vm4ip[3] = 0; ...redundant with clearing below */
+        #ifdef FST_DEBUG
+                        cnt++;
+        #endif
+                        }
                 }
         }
 
@@ -1756,13 +1983,47 @@ xc->already_in_flush = 0;
 }
 
 
+#ifdef FST_WRITER_PARALLEL
+/*
+ * resizes blocks from the duration of the previous flush: when it took longer
+ * than filling the next block, the writer stalls on it and blocks are doubled
+ * to amortize the per-block costs of the flush; when it took less than a
+ * quarter of it, blocks are halved to bound memory usage
+ */
+static void fstWriterAdaptBreakSize(struct fstWriterContext *xc)
+{
+uint64_t now = fstWriterGetTimeNs();
+
+if(xc->flush_start_ns)
+        {
+        uint64_t fill_time = now - xc->flush_start_ns;
+
+        if((xc->flush_time_ns > fill_time) && (xc->fst_break_size < FST_BREAK_SIZE_MAX))
+                {
+                xc->fst_break_size <<= 1;
+                }
+        else if((xc->flush_time_ns < fill_time / 4) && (xc->fst_break_size > xc->fst_orig_break_size / 4))
+                {
+                xc->fst_break_size >>= 1;
+                }
+
+        xc->vchg_alloc_siz = xc->fst_break_size + xc->fst_break_add_size;
+        }
+
+xc->flush_start_ns = now;
+}
+#endif
+
+
 #ifdef FST_WRITER_PARALLEL
 static void *fstWriterFlushContextPrivate1(void *ctx)
 {
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+uint64_t start = fstWriterGetTimeNs();
 
 fstWriterFlushContextPrivate2(xc);
 
+xc->xc_parent->flush_time_ns = fstWriterGetTimeNs() - start;
 pthread_mutex_unlock(&(xc->xc_parent->mutex));
 
 #ifdef FST_REMOVE_DUPLICATE_VC
@@ -1789,6 +2050,11 @@ if(xc->parallel_enabled)
         pthread_mutex_lock(&xc->mutex);
         pthread_mutex_unlock(&xc->mutex);
 
+        if(xc->adaptive_break)
+                {
+                fstWriterAdaptBreakSize(xc);
+                }
+
         xc->xc_parent = xc;
         memcpy(xc2, xc, sizeof(struct fstWriterContext));
 
@@ -2489,6 +2755,42 @@ if(xc)
 }
 
 
+void fstWriterSetCompressThreads(void *ctx, int nb_threads)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+if(xc)
+        {
+#ifndef FST_WRITER_PARALLEL
+        if(nb_threads > 1)
+                {
+                fprintf(stderr, FST_APIMESS"fstWriterSetCompressThreads(), FST_WRITER_PARALLEL not enabled during compile, exiting.\n");
+                exit(255);
+                }
+#else
+        xc->compress_threads = nb_threads;
+#endif
+        }
+}
+
+
+void fstWriterSetAdaptiveBreakSize(void *ctx, int enable)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+if(xc)
+        {
+#ifndef FST_WRITER_PARALLEL
+        if(enable)
+                {
+                fprintf(stderr, FST_APIMESS"fstWriterSetAdaptiveBreakSize(), FST_WRITER_PARALLEL not enabled during compile, exiting.\n");
+                exit(255);
+                }
+#else
+        xc->adaptive_break = (enable != 0);
+#endif
+        }
+}
+
+
 void fstWriterSetDumpSizeLimit(void *ctx, uint64_t numbytes)
 {
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
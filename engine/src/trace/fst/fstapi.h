@@ -370,6 +370,8 @@ void            fstWriterSetEnvVar(void *ctx, const char *envvar);
 void            fstWriterSetFileType(void *ctx, enum fstFileType filetype);
 void            fstWriterSetPackType(void *ctx, enum fstWriterPackType typ);
 void            fstWriterSetParallelMode(void *ctx, int enable);
+void            fstWriterSetCompressThreads(void *ctx, int nb_threads);
+void            fstWriterSetAdaptiveBreakSize(void *ctx, int enable);
 void            fstWriterSetRepackOnClose(void *ctx, int enable);       /* type = 0 (none), 1 (libz) */
 void            fstWriterSetScope(void *ctx, enum fstScopeType scopetype,
                         const char *scopename, const char *scopecomp);
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "vp/vp.hpp"
+#include "vp/trace/event_dumper.hpp"
+#include <string.h>
+
+#define GVT_MAGIC         "GVTRACE"
+#define GVT_INDEX_MAGIC   "GVTINDEX"
+#define GVT_VERSION       1
+// Timestamps are in 10^-12 s, as for VCD files
+#define GVT_TIMESCALE     12
+
+#define GVT_BLOCK_SCHEMA  'S'
+#define GVT_BLOCK_CHUNK   'C'
+#define GVT_BLOCK_INDEX   'I'
+
+#define GVT_TYPE_BITS     0
+#define GVT_TYPE_REAL     1
+#define GVT_TYPE_STRING   2
+
+#define GVT_CHUNK_SIZE    (64*1024)
+
+
+vp::Gvt_file::Gvt_file(vp::Event_dumper *dumper, string path)
+{
+  file = fopen(path.c_str(), "w");
+  if (file == NULL)
+  {
+    dumper->comp->get_engine()->fatal("Error while opening GVT file (path: %s, error: %s)\n", path.c_str(), strerror(errno));
+  }
+
+  js::config *config = dumper->comp->get_js_config("**/vcd/gvt/chunk_size");
+  this->chunk_size = config ? config->get_int() : GVT_CHUNK_SIZE;
+  this->chunk_nb_events = 0;
+  this->chunk_start = 0;
+  this->offset = 0;
+
+  this->block.insert(this->block.end(), GVT_MAGIC, GVT_MAGIC + 8);
+  this->block.push_back(GVT_VERSION);
+  this->block.push_back(GVT_TIMESCALE);
+  this->write(this->block);
+}
+
+
+void vp::Gvt_file::write(std::vector<uint8_t> &buffer)
+{
+  fwrite(buffer.data(), 1, buffer.size(), file);
+  this->offset += buffer.size();
+  buffer.clear();
+}
+
+
+void vp::Gvt_file::put_varint(std::vector<uint8_t> &buffer, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    buffer.push_back((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  buffer.push_back(value);
+}
+
+
+void vp::Gvt_file::put_schema(std::vector<uint8_t> &buffer, int index)
+{
+  gvt_trace *trace = &this->traces[index];
+  this->put_varint(buffer, trace->id);
+  buffer.push_back(trace->type);
+  this->put_varint(buffer, trace->width);
+  this->put_varint(buffer, trace->path.size());
+  buffer.insert(buffer.end(), trace->path.begin(), trace->path.end());
+}
+
+
+void vp::Gvt_file::add_trace(string path, int id, int width, bool is_real, bool is_string)
+{
+  int type = is_real ? GVT_TYPE_REAL : is_string ? GVT_TYPE_STRING : GVT_TYPE_BITS;
+
+  this->traces.push_back({ path, id, type, width });
+
+  if (id >= (int)this->last_values.size())
+  {
+    this->last_values.resize(id + 1);
+    this->last_values_chunk.resize(id + 1, -1);
+    this->trace_types.resize(id + 1);
+  }
+  this->trace_types[id] = type;
+
+  // Traces can be added while events are dumped. The schema block is written
+  // before the chunk which may refer to it, so that the file can be read
+  // sequentially even if it was never closed.
+  this->flush_chunk();
+  this->block.push_back(GVT_BLOCK_SCHEMA);
+  this->put_schema(this->block, this->traces.size() - 1);
+  this->write(this->block);
+}
+
+
+void vp::Gvt_file::flush_chunk()
+{
+  if (this->chunk_nb_events == 0)
+    return;
+
+  this->chunks.push_back({ this->offset, this->chunk_start, this->last_timestamp, this->chunk_nb_events });
+
+  this->block.push_back(GVT_BLOCK_CHUNK);
+  this->put_varint(this->block, this->chunk_start);
+  this->put_varint(this->block, this->last_timestamp - this->chunk_start);
+  this->put_varint(this->block, this->chunk_nb_events);
+  this->put_varint(this->block, this->chunk.size());
+  this->write(this->block);
+  this->write(this->chunk);
+
+  this->chunk_nb_events = 0;
+}
+
+
+void vp::Gvt_file::dump(int64_t timestamp, int id, uint8_t *event, int width, bool is_real, bool is_string)
+{
+  if (this->chunk_nb_events == 0)
+  {
+    this->chunk_start = timestamp;
+    this->last_timestamp = timestamp;
+  }
+
+  this->put_varint(this->chunk, timestamp - this->last_timestamp);
+  this->last_timestamp = timestamp;
+
+  // Lowest bit tells the value is undefined, in which case nothing follows
+  this->put_varint(this->chunk, ((uint64_t)id << 1) | (event == NULL));
+
+  if (event)
+  {
+    int type = this->trace_types[id];
+
+    if (type == GVT_TYPE_REAL)
+    {
+      this->chunk.insert(this->chunk.end(), event, event + 8);
+    }
+    else if (type == GVT_TYPE_STRING)
+    {
+      this->put_varint(this->chunk, width / 8);
+      this->chunk.insert(this->chunk.end(), event, event + width / 8);
+    }
+    else if (width <= 64)
+    {
+      // Difference with the previous value of the same trace in this chunk,
+      // zigzag-encoded so that small decrements stay small
+      uint64_t value = 0;
+      memcpy((void *)&value, (void *)event, (width + 7) / 8);
+      if (width < 64)
+        value &= (1ULL << width) - 1;
+
+      int64_t chunk_index = this->chunks.size();
+      uint64_t last = this->last_values_chunk[id] == chunk_index ? this->last_values[id] : 0;
+      int64_t delta = (int64_t)(value - last);
+      this->put_varint(this->chunk, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+
+      this->last_values[id] = value;
+      this->last_values_chunk[id] = chunk_index;
+    }
+    else
+    {
+      this->chunk.insert(this->chunk.end(), event, event + (width + 7) / 8);
+    }
+  }
+
+  this->chunk_nb_events++;
+
+  if ((int64_t)this->chunk.size() >= this->chunk_size)
+    this->flush_chunk();
+}
+
+
+void vp::Gvt_file::close()
+{
+  this->flush_chunk();
+
+  int64_t index_offset = this->offset;
+
+  this->block.push_back(GVT_BLOCK_INDEX);
+  this->put_varint(this->block, this->traces.size());
+  for (unsigned int i=0; i<this->traces.size(); i++)
+  {
+    this->put_schema(this->block, i);
+  }
+  this->put_varint(this->block, this->chunks.size());
+  for (auto &chunk: this->chunks)
+  {
+    this->put_varint(this->block, chunk.offset);
+    this->put_varint(this->block, chunk.start);
+    this->put_varint(this->block, chunk.end - chunk.start);
+    this->put_varint(this->block, chunk.nb_events);
+  }
+
+  // Fixed-size trailer so that the index can be found from the end of file
+  for (int i=0; i<8; i++)
+  {
+    this->block.push_back((index_offset >> (i*8)) & 0xff);
+  }
+  this->block.insert(this->block.end(), GVT_INDEX_MAGIC, GVT_INDEX_MAGIC + 8);
+  this->write(this->block);
+
+  fclose(file);
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "vp/trace/text_sink.hpp"
+#include <stdlib.h>
+
+
+void vp::trace_text_sink::open(std::string path, int64_t rotate_size, bool gzip)
+{
+  this->path = path;
+  this->rotate_size = rotate_size;
+  this->gzip = gzip && path != "";
+  this->index = 0;
+  this->open_file();
+}
+
+
+void vp::trace_text_sink::open_file()
+{
+  this->size = 0;
+
+  if (this->path == "")
+  {
+    this->file = stdout;
+    return;
+  }
+
+  std::string path = this->path;
+  if (this->index)
+    path += "." + std::to_string(this->index);
+
+  if (this->gzip)
+    this->gz_file = gzopen(path.c_str(), "wb");
+  else
+    this->file = fopen(path.c_str(), "w");
+
+  if (this->file == NULL && this->gz_file == NULL)
+  {
+    fprintf(stderr, "Unable to open trace file (path: %s)\n", path.c_str());
+    abort();
+  }
+}
+
+
+void vp::trace_text_sink::close_file()
+{
+  if (this->gz_file)
+  {
+    gzclose(this->gz_file);
+    this->gz_file = NULL;
+  }
+  else if (this->file && this->file != stdout)
+  {
+    fclose(this->file);
+    this->file = NULL;
+  }
+  else if (this->file)
+  {
+    fflush(this->file);
+  }
+}
+
+
+void vp::trace_text_sink::close()
+{
+  this->close_file();
+}
+
+
+void vp::trace_text_sink::flush()
+{
+  if (this->gz_file)
+    gzflush(this->gz_file, Z_SYNC_FLUSH);
+  else if (this->file)
+    fflush(this->file);
+}
+
+
+void vp::trace_text_sink::write(const char *str, int len)
+{
+  if (this->gz_file)
+    gzwrite(this->gz_file, str, len);
+  else
+    fwrite(str, 1, len, this->file);
+
+  this->size += len;
+}
+
+
+void vp::trace_text_sink::message_done()
+{
+  if (this->rotate_size && this->size >= this->rotate_size && this->path != "")
+  {
+    this->close_file();
+    this->index++;
+    this->open_file();
+  }
+}
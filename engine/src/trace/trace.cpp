@@ -22,6 +22,7 @@
 #include "vp/trace/trace.hpp"
 #include "vp/trace/trace_engine.hpp"
 #include <string.h>
+#include <chrono>
 
 
 
@@ -116,79 +117,163 @@ void vp::trace::dump_fatal_header()
 
 
 
-char *vp::trace_engine::get_event_buffer(int bytes)
+thread_local vp::trace_ring *vp_thread_trace_ring = NULL;
+
+
+
+vp::trace_ring::trace_ring(trace_engine *engine, int size)
+: engine(engine), size(size), mask(size - 1), head(0), tail(0)
 {
-  if (current_buffer == NULL || bytes > TRACE_EVENT_BUFFER_SIZE - current_buffer_size)
+  this->buffer = new char[size];
+}
+
+void vp::trace_ring::wait_space(uint64_t needed)
+{
+  if (needed > this->size)
   {
-    pthread_mutex_lock(&mutex);
+    fprintf(stderr, "Trace event of %ld bytes does not fit in the trace ring (size: %ld), increase trace_ring/size\n", needed, this->size);
+    abort();
+  }
 
-    if (current_buffer && bytes > TRACE_EVENT_BUFFER_SIZE - current_buffer_size)
-    {
-      *(vp::trace **)(current_buffer + current_buffer_size) = NULL;
-      ready_event_buffers.push_back(current_buffer);
-      pthread_cond_broadcast(&cond);
-    }
+  // The ring is full, wake-up the consumer and wait until it has freed
+  // enough space
+  auto start = std::chrono::steady_clock::now();
+  uint64_t head = this->head.load(std::memory_order_relaxed);
 
-    while (event_buffers.size() == 0)
-    {
-      pthread_cond_wait(&cond, &mutex);
-    }
-    current_buffer = event_buffers[0];
-    event_buffers.erase(event_buffers.begin());
-    current_buffer_size = 0;
-    pthread_mutex_unlock(&mutex);
+  this->nb_full++;
+
+  while(1)
+  {
+    if (this->engine->consumer_waiting.load())
+      this->engine->wakeup_consumer();
+    std::this_thread::yield();
+
+    this->cached_tail = this->tail.load(std::memory_order_acquire);
+    if (head + needed - this->cached_tail <= this->size)
+      break;
   }
 
-  char *result = current_buffer + current_buffer_size;
+  this->full_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+vp::trace_ring *vp::trace_engine::new_ring()
+{
+  pthread_mutex_lock(&this->mutex);
+  int index = this->nb_rings.load(std::memory_order_relaxed);
+  if (index == TRACE_MAX_RINGS)
+  {
+    pthread_mutex_unlock(&this->mutex);
+    fprintf(stderr, "Too many threads dumping trace events (max: %d)\n", TRACE_MAX_RINGS);
+    abort();
+  }
+  trace_ring *ring = new trace_ring(this, this->ring_size);
+  this->rings[index] = ring;
+  this->nb_rings.store(index + 1, std::memory_order_release);
+  pthread_mutex_unlock(&this->mutex);
 
-  current_buffer_size += bytes;
+  vp_thread_trace_ring = ring;
+  return ring;
+}
 
-  return result;
+void vp::trace_engine::wakeup_consumer()
+{
+  pthread_mutex_lock(&this->mutex);
+  pthread_cond_broadcast(&this->cond);
+  pthread_mutex_unlock(&this->mutex);
 }
 
 void vp::trace_engine::stop()
 {
   this->check_pending_events(-1);
-  this->flush();
   pthread_mutex_lock(&mutex);
-  this->end = 1;
+  this->end.store(1);
   pthread_cond_broadcast(&cond);
   pthread_mutex_unlock(&mutex);
   this->thread->join();
+  if (this->ring_stats)
+    this->dump_ring_stats();
+  vp::profiler::dump(this->profile_report, this->profile_folded);
   fflush(NULL);
 }
 
 void vp::trace_engine::flush()
 {
-  if (current_buffer_size)
+  if (this->end.load())
+    return;
+
+  this->flush_requested.store(true);
+  while (this->flush_requested.load())
   {
-    pthread_mutex_lock(&mutex);
-    *(vp::trace **)(current_buffer + current_buffer_size) = NULL;
-    ready_event_buffers.push_back(current_buffer);
-    current_buffer = NULL;
-    pthread_cond_broadcast(&cond);
-    pthread_mutex_unlock(&mutex);
+    this->wakeup_consumer();
+    std::this_thread::yield();
   }
-
 }
 
-void vp::trace_engine::dump_event_to_buffer(vp::trace *trace, int64_t timestamp, uint8_t *event, int bytes, bool include_size)
+void vp::trace_engine::dump_msg(vp::trace *trace, bool warning, const char *fmt, va_list ap)
 {
-  int size = bytes + sizeof(trace) + sizeof(timestamp);
-  if (include_size)
-    size += 4;
-  char *event_buffer = this->get_event_buffer(size);
+  int64_t time = -1;
+  int64_t cycles = -1;
+  if (trace->comp->get_clock())
+  {
+    time = trace->comp->get_clock()->get_time();
+    cycles = trace->comp->get_clock()->get_cycles();
 
-  *(vp::trace **)event_buffer = trace;
-  event_buffer += sizeof(trace);
-  *(int64_t *)event_buffer = timestamp;
-  event_buffer += sizeof(timestamp);
+    // Pending pulse ends are flushed first to keep the records of the ring
+    // in timestamp order
+    this->check_pending_events(time);
+  }
 
-  if (include_size)
+  // The message is formatted directly in the ring, and formatted again in
+  // a bigger record only when it is too long
+  va_list aq;
+  va_copy(aq, ap);
+  trace_ring *ring = this->get_ring();
+  char *record = ring->reserve(TRACE_RECORD_SIZE(8 + TRACE_TEXT_INLINE_SIZE));
+  int len = vsnprintf(record + TRACE_RECORD_HEADER_SIZE + 8, TRACE_TEXT_INLINE_SIZE, fmt, ap);
+  if (len >= TRACE_TEXT_INLINE_SIZE)
+  {
+    record = ring->reserve(TRACE_RECORD_SIZE(8 + len + 1));
+    vsnprintf(record + TRACE_RECORD_HEADER_SIZE + 8, len + 1, fmt, aq);
+  }
+  else if (len < 0)
   {
-    *(int32_t *)event_buffer = bytes;
-    event_buffer += 4;
+    len = 0;
+    record[TRACE_RECORD_HEADER_SIZE + 8] = 0;
   }
+  va_end(aq);
+
+  int bytes = 8 + len + 1;
+  *(vp::trace **)record = trace;
+  *(int64_t *)(record + 8) = time;
+  *(uint32_t *)(record + 16) = bytes | TRACE_RECORD_TEXT | (warning ? TRACE_RECORD_WARNING : 0);
+  memcpy((void *)(record + TRACE_RECORD_HEADER_SIZE), (void *)&cycles, 8);
+
+  ring->commit(TRACE_RECORD_SIZE(bytes));
+}
+
+void vp::trace_engine::dump_ring_stats()
+{
+  int nb_rings = this->nb_rings.load(std::memory_order_acquire);
+  for (int i=0; i<nb_rings; i++)
+  {
+    trace_ring *ring = this->rings[i];
+    fprintf(stdout, "Trace ring %d (size: %ld, records: %ld, bytes: %ld, max fill: %ld, full: %ld, stall: %ld ns)\n",
+      i, ring->size, ring->nb_records, ring->nb_bytes, ring->max_fill, ring->nb_full, ring->full_time);
+  }
+}
+
+void vp::trace_engine::dump_event_to_buffer(vp::trace *trace, int64_t timestamp, uint8_t *event, int bytes)
+{
+  // The size is always stored, so that the consumer can walk the records
+  // without looking at the traces, and string traces can have any size
+  int size = TRACE_RECORD_SIZE(bytes);
+  trace_ring *ring = this->get_ring();
+  char *event_buffer = ring->reserve(size);
+
+  *(vp::trace **)event_buffer = trace;
+  *(int64_t *)(event_buffer + 8) = timestamp;
+  *(uint32_t *)(event_buffer + 16) = bytes;
+  event_buffer += TRACE_RECORD_HEADER_SIZE;
 
   if (event)
   {
@@ -202,6 +287,7 @@ void vp::trace_engine::dump_event_to_buffer(vp::trace *trace, int64_t timestamp,
     memset((void *)event_buffer, 0, bytes);
   }
 
+  ring->commit(size);
 }
 
 
@@ -217,7 +303,7 @@ void vp::trace_engine::dump_event_string(vp::trace *trace, int64_t timestamp, ui
 {
   this->check_pending_events(timestamp);
 
-  this->dump_event_to_buffer(trace, timestamp, event, bytes, true);
+  this->dump_event_to_buffer(trace, timestamp, event, bytes);
 }
 
 
@@ -227,15 +313,7 @@ void vp::trace_engine::dump_event_pulse(vp::trace *trace, int64_t timestamp, int
 
   // Then dequeue the trace if a pending value is already there
   if (trace->pending_timestamp != -1)
-  {
-    if (trace->prev != NULL)
-      trace->prev->next = trace->next;
-    else
-      this->first_pending_event = trace->next;
- 
-    if (trace->next != NULL)
-      trace->next->prev = trace->prev;
-  }
+    this->pending_remove(trace);
 
   this->dump_event_to_buffer(trace, timestamp, pulse_event, width);
 
@@ -243,47 +321,97 @@ void vp::trace_engine::dump_event_pulse(vp::trace *trace, int64_t timestamp, int
 }
 
 
+// Pending pulse ends are only dumped once the time goes past the first one,
+// all the ones which are reached are then dumped in a batch, in timestamp
+// order
 void vp::trace_engine::check_pending_events(int64_t timestamp)
 {
-  vp::trace *trace = this->first_pending_event;
-  while (trace && (timestamp == -1 || trace->pending_timestamp <= timestamp))
+  if (likely(timestamp != -1 && timestamp < this->next_pending_timestamp))
+    return;
+
+  while (this->pending_heap.size() && (timestamp == -1 || this->pending_heap[0]->pending_timestamp <= timestamp))
   {
+    vp::trace *trace = this->pending_heap[0];
     this->dump_event_to_buffer(trace, trace->pending_timestamp, trace->buffer, trace->bytes);
-    trace->pending_timestamp = -1;
-    trace = trace->next;
+    this->pending_remove(trace);
   }
-  this->first_pending_event = trace;
-  if (trace)
-    trace->prev = NULL;
 }
 
 
-void vp::trace_engine::enqueue_pending(vp::trace *trace, int64_t timestamp, uint8_t *event)
+void vp::trace_engine::pending_sift_up(int index)
 {
-  // Eenqueue the trace to the pending queue
-  vp::trace *current = this->first_pending_event, *prev = NULL;
+  vp::trace *trace = this->pending_heap[index];
 
-  while (current && current->pending_timestamp < timestamp)
+  while (index > 0)
   {
-    prev = current;
-    current = current->next;
+    int parent = (index - 1) / 2;
+    vp::trace *parent_trace = this->pending_heap[parent];
+    if (parent_trace->pending_timestamp <= trace->pending_timestamp)
+      break;
+    this->pending_heap[index] = parent_trace;
+    parent_trace->pending_index = index;
+    index = parent;
   }
 
-  if (prev)
+  this->pending_heap[index] = trace;
+  trace->pending_index = index;
+}
+
+
+void vp::trace_engine::pending_sift_down(int index)
+{
+  int size = this->pending_heap.size();
+  vp::trace *trace = this->pending_heap[index];
+
+  while (1)
   {
-    prev->next = trace;
+    int child = index * 2 + 1;
+    if (child >= size)
+      break;
+    if (child + 1 < size && this->pending_heap[child + 1]->pending_timestamp < this->pending_heap[child]->pending_timestamp)
+      child++;
+    vp::trace *child_trace = this->pending_heap[child];
+    if (trace->pending_timestamp <= child_trace->pending_timestamp)
+      break;
+    this->pending_heap[index] = child_trace;
+    child_trace->pending_index = index;
+    index = child;
   }
-  else
+
+  this->pending_heap[index] = trace;
+  trace->pending_index = index;
+}
+
+
+void vp::trace_engine::pending_remove(vp::trace *trace)
+{
+  int index = trace->pending_index;
+  vp::trace *last = this->pending_heap.back();
+  this->pending_heap.pop_back();
+
+  if (last != trace)
   {
-    this->first_pending_event = trace;
+    // Move the last one to the free slot and restore the heap order from
+    // there, in whichever direction it must go
+    this->pending_heap[index] = last;
+    last->pending_index = index;
+    if (index > 0 && this->pending_heap[(index - 1) / 2]->pending_timestamp > last->pending_timestamp)
+      this->pending_sift_up(index);
+    else
+      this->pending_sift_down(index);
   }
 
-  trace->prev = prev;
-  trace->next = current;
-  if (current)
-    current->prev = trace;
+  trace->pending_timestamp = -1;
+  this->next_pending_timestamp = this->pending_heap.size() ? this->pending_heap[0]->pending_timestamp : INT64_MAX;
+}
 
+
+void vp::trace_engine::enqueue_pending(vp::trace *trace, int64_t timestamp, uint8_t *event)
+{
   trace->pending_timestamp = timestamp;
+  this->pending_heap.push_back(trace);
+  this->pending_sift_up(this->pending_heap.size() - 1);
+  this->next_pending_timestamp = this->pending_heap[0]->pending_timestamp;
   
   // And dump the value to the trace
   memcpy(trace->buffer, event, trace->bytes);
@@ -313,90 +441,203 @@ void vp::trace_engine::flush_Event_traces(int64_t timestamp)
   first_trace_to_dump = NULL;
 }
 
-void vp::trace_engine::vcd_routine()
+void vp::trace_engine::dump_text_record(char *record, uint32_t flags)
 {
-  int64_t last_timestamp = -1;
+  vp::trace *trace = *(vp::trace **)record;
+  int64_t timestamp = *(int64_t *)(record + 8);
+  int64_t cycles;
+  memcpy((void *)&cycles, (void *)(record + TRACE_RECORD_HEADER_SIZE), 8);
+  const char *text = record + TRACE_RECORD_HEADER_SIZE + 8;
+
+  // Same header as trace::dump_header and trace::dump_warning_header
+  char header[1024];
+  int max_trace_len = this->get_max_path_len();
+  int len;
+  if (this->text_sink.use_colors())
+  {
+    len = snprintf(header, sizeof(header), "%ld: %ld: [\033[%sm%-*.*s\033[0m] ", timestamp, cycles,
+      flags & TRACE_RECORD_WARNING ? "31" : "34", max_trace_len, max_trace_len, trace->name.c_str());
+  }
+  else
+  {
+    len = snprintf(header, sizeof(header), "%ld: %ld: [%-*.*s] ", timestamp, cycles,
+      max_trace_len, max_trace_len, trace->name.c_str());
+  }
+  if (len >= (int)sizeof(header))
+    len = sizeof(header) - 1;
 
-  while(1)
+  this->text_sink.write(header, len);
+  this->text_sink.write(text, strlen(text));
+  this->text_sink.message_done();
+}
+
+void vp::trace_engine::dump_record(char *record, int64_t *last_timestamp)
+{
+  uint32_t flags = *(uint32_t *)(record + 16);
+  if (flags & TRACE_RECORD_TEXT)
   {
-    char *event_buffer, *event_buffer_start;
+    this->dump_text_record(record, flags);
+    return;
+  }
 
-    pthread_mutex_lock(&this->mutex);
-    while(this->ready_event_buffers.size() == 0 && !end)
+  vp::trace *trace = *(vp::trace **)record;
+  int64_t timestamp = *(int64_t *)(record + 8);
+  uint8_t *event = (uint8_t *)(record + TRACE_RECORD_HEADER_SIZE);
+
+  if (*last_timestamp == -1)
+    *last_timestamp = timestamp;
+
+  if (*last_timestamp < timestamp)
+  {
+    this->flush_Event_traces(*last_timestamp);
+    *last_timestamp = timestamp;
+  }
+
+  if (trace->is_string)
+  {
+    trace->bytes = *(uint32_t *)(record + 16);
+    trace->width = trace->bytes * 8;
+    if (trace->event_trace)
     {
-      pthread_cond_wait(&this->cond, &this->mutex);
+      trace->event_trace->width = trace->width;
     }
+  }
 
-    if (this->ready_event_buffers.size() == 0 && end)
+  if (trace->event_trace)
+  {
+    // The value is passed directly from the ring, the event trace copies it
+    trace->event_trace->reg(timestamp, event, trace->width);
+    if (!trace->event_trace->is_enqueued)
     {
-      pthread_mutex_unlock(&this->mutex);
-      break;
+      trace->event_trace->is_enqueued = true;
+      trace->event_trace->next = this->first_trace_to_dump;
+      this->first_trace_to_dump = trace->event_trace;
     }
+  }
+}
 
-    event_buffer = ready_event_buffers[0];
-    event_buffer_start = event_buffer;
-    ready_event_buffers.erase(ready_event_buffers.begin());
+// Drain all records currently available in the rings, and return true if
+// at least one was found.
+// Records from different rings are merged on their timestamp.
+bool vp::trace_engine::drain_rings(int64_t *last_timestamp)
+{
+  int nb_rings = this->nb_rings.load(std::memory_order_acquire);
+  uint64_t heads[TRACE_MAX_RINGS];
+  uint64_t tails[TRACE_MAX_RINGS];
+  bool found = false;
 
-    pthread_mutex_unlock(&this->mutex);
+  for (int i=0; i<nb_rings; i++)
+  {
+    heads[i] = this->rings[i]->head.load(std::memory_order_acquire);
+    tails[i] = this->rings[i]->tail.load(std::memory_order_relaxed);
+  }
 
-    int size = 0;
-    while (size < TRACE_EVENT_BUFFER_SIZE)
-    {
-      int64_t timestamp;
-      vp::trace *trace = *(vp::trace **)event_buffer;
-      if (trace == NULL) break;
+  while(1)
+  {
+    trace_ring *ring = NULL;
+    int ring_index = 0;
+    char *record = NULL;
+    int64_t timestamp = 0;
 
-      event_buffer += sizeof(trace);
-      timestamp = *(int64_t *)event_buffer;
+    for (int i=0; i<nb_rings; i++)
+    {
+      trace_ring *current = this->rings[i];
 
-      if (last_timestamp == -1)
-        last_timestamp = timestamp;        
+      if (tails[i] == heads[i])
+        continue;
 
-      if (last_timestamp < timestamp)
+      char *current_record = current->buffer + (tails[i] & current->mask);
+      if (*(vp::trace **)current_record == NULL)
       {
-        this->flush_Event_traces(last_timestamp);
-        last_timestamp = timestamp;
+        // Wrap record, skip the end of the buffer
+        tails[i] += current->size - (tails[i] & current->mask);
+        if (tails[i] == heads[i])
+          continue;
+        current_record = current->buffer;
       }
 
-      event_buffer += sizeof(timestamp);
-
-      if (trace->is_string)
+      int64_t current_timestamp = *(int64_t *)(current_record + 8);
+      if (ring == NULL || current_timestamp < timestamp)
       {
-        trace->bytes = *(int32_t *)event_buffer;
-        trace->width = trace->bytes * 8;
-        if (trace->event_trace)
-        {
-          trace->event_trace->width = trace->width;
-        }
-        event_buffer += 4;
+        ring = current;
+        ring_index = i;
+        record = current_record;
+        timestamp = current_timestamp;
       }
+    }
 
-      int bytes = trace->bytes;
-      uint8_t event[bytes];
-      memcpy((void *)&event, (void *)event_buffer, bytes);
-      event_buffer += bytes;
+    if (ring == NULL)
+      break;
 
-      size += sizeof(trace) + bytes;
+    found = true;
 
-      if (trace->event_trace)
-      {
-        trace->event_trace->reg(timestamp, event, trace->width);
-        if (!trace->event_trace->is_enqueued)
-        {
-          trace->event_trace->is_enqueued = true;
-          trace->event_trace->next = this->first_trace_to_dump;
-          this->first_trace_to_dump = trace->event_trace;
-        }
-      }
+    this->dump_record(record, last_timestamp);
+
+    tails[ring_index] += TRACE_RECORD_SIZE(*(uint32_t *)(record + 16) & TRACE_RECORD_SIZE_MASK);
+
+    // Give back space regularly so that a blocked producer can go on while
+    // we are still draining
+    if ((ring->nb_drained++ & 0x3f) == 0)
+      ring->tail.store(tails[ring_index], std::memory_order_release);
+  }
+
+  for (int i=0; i<nb_rings; i++)
+  {
+    this->rings[i]->tail.store(tails[i], std::memory_order_release);
+  }
+
+  return found;
+}
 
+void vp::trace_engine::vcd_routine()
+{
+  int64_t last_timestamp = -1;
+
+  while(1)
+  {
+    if (this->drain_rings(&last_timestamp))
+      continue;
+
+    if (this->flush_requested.load())
+    {
+      // Records committed before the request may have been missed by the
+      // previous pass
+      while (this->drain_rings(&last_timestamp)) {}
+      this->text_sink.flush();
+      this->flush_requested.store(false);
+      continue;
     }
 
+    if (this->end.load())
+    {
+      // Producers are stopped once end is set, one last pass is enough to
+      // get everything which was committed before
+      this->drain_rings(&last_timestamp);
+      break;
+    }
+
+    // Nothing to dump, sleep until a producer fills a significant part of
+    // its ring, or at most 1ms, so that events are not delayed too long.
+    // The flag is set before checking again to not miss a wake-up.
     pthread_mutex_lock(&this->mutex);
-    event_buffers.push_back(event_buffer_start);
-    pthread_cond_broadcast(&cond);
+    this->consumer_waiting.store(true);
+    if (!this->end.load() && !this->drain_rings(&last_timestamp))
+    {
+      struct timespec ts;
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_nsec += 1000000;
+      if (ts.tv_nsec >= 1000000000)
+      {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+      }
+      pthread_cond_timedwait(&this->cond, &this->mutex, &ts);
+    }
+    this->consumer_waiting.store(false);
     pthread_mutex_unlock(&this->mutex);
   }
 
   this->flush_Event_traces(last_timestamp);
   event_dumper.close();
+  this->text_sink.close();
 }
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "vp/trace/trace_matcher.hpp"
+#include <algorithm>
+
+// Token of a .* in a parsed pattern, other tokens are characters
+#define TRACE_MATCHER_ANY -1
+
+
+vp::trace_matcher::trace_matcher()
+{
+  this->root = new trace_matcher_node();
+}
+
+
+// Parses a basic regular expression made of literal characters, .* and
+// ^/$ anchors, and returns false for anything else. Unanchored patterns
+// get a wildcard on the corresponding side, as regexec matches anywhere in
+// the path.
+bool vp::trace_matcher::parse_glob(const char *pattern, std::vector<int> &tokens)
+{
+  const char *current = pattern;
+  bool anchored_end = false;
+
+  if (*current == '^')
+    current++;
+  else
+    tokens.push_back(TRACE_MATCHER_ANY);
+
+  while (*current)
+  {
+    char c = *current;
+
+    if (c == '.' && current[1] == '*')
+    {
+      if (current[2] == '*')
+        return false;
+      tokens.push_back(TRACE_MATCHER_ANY);
+      current += 2;
+    }
+    else if (c == '$' && current[1] == 0)
+    {
+      anchored_end = true;
+      current++;
+    }
+    else if (c == '.' || c == '[' || c == '\\' || c == '*' || c == '^' || c == '$')
+    {
+      return false;
+    }
+    else
+    {
+      tokens.push_back((unsigned char)c);
+      current++;
+    }
+  }
+
+  if (!anchored_end)
+    tokens.push_back(TRACE_MATCHER_ANY);
+
+  return true;
+}
+
+
+void vp::trace_matcher::add(const char *pattern, int id)
+{
+  std::vector<int> tokens;
+
+  // The cached states do not know about the new pattern
+  this->path_cache.clear();
+
+  if (this->regex_only || !this->parse_glob(pattern, tokens))
+  {
+    regex_t *regex = new regex_t();
+    if (regcomp(regex, pattern, 0) != 0)
+    {
+      delete regex;
+      return;
+    }
+    this->regexs.push_back(regex);
+    this->regex_ids.push_back(id);
+    return;
+  }
+
+  trace_matcher_node *node = this->root;
+  for (int token: tokens)
+  {
+    if (token == TRACE_MATCHER_ANY)
+    {
+      // Consecutive wildcards are the same as one
+      if (node->is_any)
+        continue;
+      if (node->any == NULL)
+      {
+        node->any = new trace_matcher_node();
+        node->any->is_any = true;
+      }
+      node = node->any;
+    }
+    else
+    {
+      trace_matcher_node *child = node->childs[token];
+      if (child == NULL)
+      {
+        child = new trace_matcher_node();
+        node->childs[token] = child;
+      }
+      node = child;
+    }
+  }
+
+  node->ids.push_back(id);
+}
+
+
+// Adds a node to the active set, with its wildcard child, as a wildcard
+// can match an empty string
+void vp::trace_matcher::add_active(std::vector<trace_matcher_node *> &active, trace_matcher_node *node)
+{
+  while (node && node->stamp != this->stamp)
+  {
+    node->stamp = this->stamp;
+    active.push_back(node);
+    node = node->any;
+  }
+}
+
+
+void vp::trace_matcher::walk(std::vector<trace_matcher_node *> &active, const char *str)
+{
+  std::vector<trace_matcher_node *> next;
+
+  for (const char *current = str; *current && active.size(); current++)
+  {
+    this->stamp++;
+    next.clear();
+
+    for (trace_matcher_node *node: active)
+    {
+      // Wildcards stay active on any character
+      if (node->is_any)
+        this->add_active(next, node);
+
+      auto it = node->childs.find(*current);
+      if (it != node->childs.end())
+        this->add_active(next, it->second);
+    }
+
+    active.swap(next);
+  }
+}
+
+
+void vp::trace_matcher::match(std::string &path, std::string &name, std::vector<int> &ids)
+{
+  auto it = this->path_cache.find(path);
+  if (it == this->path_cache.end())
+  {
+    std::vector<trace_matcher_node *> active;
+    this->stamp++;
+    this->add_active(active, this->root);
+    this->walk(active, path.c_str());
+    this->walk(active, "/");
+    it = this->path_cache.emplace(path, active).first;
+  }
+
+  std::vector<trace_matcher_node *> active = it->second;
+  this->walk(active, name.c_str());
+
+  for (trace_matcher_node *node: active)
+  {
+    ids.insert(ids.end(), node->ids.begin(), node->ids.end());
+  }
+
+  if (this->regexs.size())
+  {
+    std::string full_path = path + "/" + name;
+    for (unsigned int i=0; i<this->regexs.size(); i++)
+    {
+      if (regexec(this->regexs[i], full_path.c_str(), 0, NULL, 0) == 0)
+        ids.push_back(this->regex_ids[i]);
+    }
+  }
+
+  std::sort(ids.begin(), ids.end());
+}
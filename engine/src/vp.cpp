@@ -35,7 +35,10 @@
 
 char vp_error[VP_ERROR_SIZE];
 
-vp::component::component(const char *config_string) : traces(*this), power(*this), reset_done_from_itf(false)
+static js::config *config_tree = NULL;
+static js::config *selected_config = NULL;
+
+vp::component::component(const char *config_string) : traces(*this), power(*this), stats(*this), reset_done_from_itf(false)
 {
   this->set_config(config_string);
 }
@@ -43,7 +46,46 @@ vp::component::component(const char *config_string) : traces(*this), power(*this
 
 void vp::component::set_config(const char *config_string)
 {
-  comp_js_config = js::import_config_from_string(strdup(config_string));
+  if (config_string == NULL)
+  {
+    comp_js_config = selected_config;
+    selected_config = NULL;
+  }
+  else
+  {
+    comp_js_config = js::import_config_from_string(strdup(config_string));
+  }
+
+  this->js_config_lookups.clear();
+}
+
+js::config *vp::component::get_js_config(std::string path)
+{
+  auto it = this->js_config_lookups.find(path);
+  if (it != this->js_config_lookups.end())
+    return it->second;
+
+  // Paths which are not found are memoized too, most glob lookups are for
+  // optional settings
+  js::config *result = this->comp_js_config->get(path);
+  this->js_config_lookups[path] = result;
+  return result;
+}
+
+int vp::component::load_config_tree(const char *config)
+{
+  config_tree = js::import_config_from_string(strdup(config));
+  return config_tree == NULL ? -1 : 0;
+}
+
+int vp::component::select_config(const char *path)
+{
+  if (config_tree == NULL)
+    return -1;
+
+  selected_config = path[0] == 0 ? config_tree : config_tree->get(path);
+
+  return selected_config == NULL ? -1 : 0;
 }
 
 void vp::component::reg_step_pre_start(std::function<void()> callback)
@@ -55,6 +97,7 @@ void vp::component::post_post_build()
 {
   traces.post_post_build();
   power.post_post_build();
+  stats.post_post_build();
 }
 
 
@@ -96,6 +139,115 @@ void vp::component::reset_all(bool active, bool from_itf)
   }
 }
 
+void vp::component::save_all(vp::checkpoint *checkpoint)
+{
+  checkpoint->begin_section(this->get_path());
+
+  for (auto reg: this->regs)
+  {
+    checkpoint->write(reg->value_bytes, reg->nb_bytes);
+  }
+
+  this->save(checkpoint);
+
+  // Events are identified by their creation order, which is the same as long
+  // as the platform is the same. Only the remaining cycles and the payload
+  // are saved, arguments are pointers and must be restored by the component.
+  checkpoint->write<uint32_t>(this->events.size());
+  for (auto event: this->events)
+  {
+    checkpoint->write<uint8_t>(event->is_enqueued());
+    if (event->is_enqueued())
+    {
+      checkpoint->write<int64_t>(event->get_cycle() - this->get_clock()->get_checkpoint_cycles());
+      checkpoint->write(event->get_payload(), event->get_payload_size());
+    }
+  }
+
+  checkpoint->end_section();
+
+  for (auto& x: this->childs)
+  {
+    x->save_all(checkpoint);
+  }
+}
+
+int vp::component::restore_all(vp::checkpoint *checkpoint)
+{
+  if (checkpoint->enter_section(this->get_path()))
+    return -1;
+
+  for (auto reg: this->regs)
+  {
+    checkpoint->read(reg->value_bytes, reg->nb_bytes);
+  }
+
+  // Events enqueued since the start are canceled and the saved ones are only
+  // enqueued once all clock engines are restored
+  for (auto event: this->events)
+  {
+    if (event->is_enqueued())
+      this->event_cancel(event);
+  }
+
+  // Components restore their state before the events so that they can
+  // allocate again the events they allocated after the start
+  this->restore(checkpoint);
+
+  this->restored_events.clear();
+
+  uint32_t nb_events = checkpoint->read<uint32_t>();
+  for (uint32_t i=0; i<nb_events && !checkpoint->has_error(); i++)
+  {
+    if (checkpoint->read<uint8_t>())
+    {
+      int64_t cycles = checkpoint->read<int64_t>();
+      if (cycles < 0)
+        cycles = 0;
+      uint8_t payload[CLOCK_EVENT_PAYLOAD_SIZE];
+      checkpoint->read(payload, CLOCK_EVENT_PAYLOAD_SIZE);
+
+      if (i < this->events.size())
+      {
+        memcpy(this->events[i]->get_payload(), payload, CLOCK_EVENT_PAYLOAD_SIZE);
+        this->restored_events.push_back(std::make_pair(this->events[i], cycles));
+      }
+      else
+      {
+        vp_warning_always(&this->warning, "Dropping pending event from checkpoint which was allocated after start (index: %d)\n", i);
+      }
+    }
+  }
+
+  if (checkpoint->leave_section())
+    return -1;
+
+  for (auto& x: this->childs)
+  {
+    if (x->restore_all(checkpoint))
+      return -1;
+  }
+
+  return 0;
+}
+
+void vp::component::post_restore_all()
+{
+  for (auto x: this->restored_events)
+  {
+    this->get_clock()->enqueue_restored(x.first, x.second);
+  }
+
+  this->restored_events.clear();
+
+  this->post_restore();
+
+  for (auto& x: this->childs)
+  {
+    x->post_restore_all();
+  }
+}
+
 void vp::component_clock::reset_sync(void *__this, bool active)
 {
   component *_this = (component *)__this;
@@ -115,6 +267,8 @@ void vp::component_clock::pre_build(component *comp) {
   comp->traces.new_trace("warning", &comp->warning, vp::WARNING);
 }
 
+thread_local vp::time_engine *vp::time_engine::current_group = NULL;
+
 bool vp::time_engine::dequeue(time_engine_client *client)
 {
   if (!client->is_enqueued) return false;
@@ -135,10 +289,31 @@ bool vp::time_engine::dequeue(time_engine_client *client)
   return true;
 }
 
+void vp::time_engine::reg_client(time_engine_client *client)
+{
+  this->clients.push_back(client);
+}
+
 void vp::time_engine::enqueue(time_engine_client *client, int64_t time)
 {
   vp_assert(time >= 0, NULL, "Time must be positive\n");
 
+  // Once groups are running, the main engine is only used to schedule the
+  // windows, clients enqueued there are executed by the first group. The
+  // enqueue is posted to it as it may come from another group.
+  if (this->parallel && this->parallel_started && this->parent == NULL)
+  {
+    vp::time_engine *group = this->groups[0];
+    int64_t full_time = (current_group != NULL ? current_group : this)->get_time() + time;
+
+    group->post([client, group, full_time]() {
+      int64_t group_time = full_time - group->get_time();
+      client->engine = group;
+      group->enqueue(client, group_time > 0 ? group_time : 0);
+    });
+    return;
+  }
+
   int64_t full_time = this->get_time() + time;
 
 #ifdef __VP_USE_SYSTEMC
@@ -222,6 +397,45 @@ void vp::clock_engine::apply_frequency(int frequency)
 }
 
 
+int64_t vp::clock_engine::get_checkpoint_cycles()
+{
+  if (this->period == 0)
+    return this->cycles;
+
+  // When stepping through the circular buffer, the cycle count is the one of
+  // the next execution, otherwise it was synchronized when the engine stopped
+  if (this->is_enqueued && this->nb_enqueued_to_cycle)
+    return this->cycles - (this->next_event_time - this->get_time()) / this->period;
+
+  int64_t diff = this->get_time() - this->stop_time;
+  if (diff > 0)
+    return this->cycles + (diff + this->period - 1) / this->period;
+
+  return this->cycles;
+}
+
+void vp::clock_engine::save(vp::checkpoint *checkpoint)
+{
+  // Saved with the cycle count and time of the checkpoint, so that events can
+  // be enqueued again relative to it
+  checkpoint->write<int64_t>(this->get_checkpoint_cycles());
+  checkpoint->write<int64_t>(this->freq);
+  checkpoint->write<int64_t>(this->period);
+}
+
+void vp::clock_engine::restore(vp::checkpoint *checkpoint)
+{
+  // All events of this engine have been canceled by their components, pending
+  // events are enqueued again relative to the restored cycle count. The time
+  // engine is restored first so that the stop time is the checkpoint time.
+  this->cycles = checkpoint->read<int64_t>();
+  this->freq = checkpoint->read<int64_t>();
+  this->period = checkpoint->read<int64_t>();
+  this->stop_time = this->get_time();
+  this->current_cycle = this->cycles & CLOCK_EVENT_QUEUE_MASK;
+  this->must_flush_delayed_queue = true;
+}
+
 void vp::clock_engine::update()
 {
   if (this->period == 0)
@@ -269,21 +483,41 @@ vp::clock_event *vp::clock_engine::enqueue_other(vp::clock_event *event, int64_t
   }
   else
   {
-    vp::clock_event *current = delayed_queue, *prev = NULL;
-    int64_t full_cycle = cycle + get_cycles();
-    while (current && current->cycle < full_cycle)
-    {
-      prev = current;
-      current = current->next;
-    }
-    if (prev) prev->next = event;
-    else delayed_queue = event;
-    event->next = current;
-    event->cycle = full_cycle;
+    this->enqueue_to_delayed(event, cycle);
   }
   return event;
 }
 
+void vp::clock_engine::enqueue_to_delayed(vp::clock_event *event, int64_t cycle)
+{
+  vp::clock_event *current = delayed_queue, *prev = NULL;
+  int64_t full_cycle = cycle + get_cycles();
+  while (current && current->cycle < full_cycle)
+  {
+    prev = current;
+    current = current->next;
+  }
+  if (prev) prev->next = event;
+  else delayed_queue = event;
+  event->next = current;
+  event->cycle = full_cycle;
+}
+
+vp::clock_event *vp::clock_engine::enqueue_restored(vp::clock_event *event, int64_t cycle)
+{
+  vp_assert(!event->enqueued, 0, "Enqueueing already enqueued event\n");
+
+  event->enqueued = true;
+
+  if (this->period != 0)
+    enqueue_to_engine(cycle*period);
+
+  this->enqueue_to_delayed(event, cycle);
+  this->must_flush_delayed_queue = true;
+
+  return event;
+}
+
 vp::clock_event *vp::clock_engine::get_next_event()
 {
   // There is no quick way of getting the next event.
@@ -466,6 +700,17 @@ vp::clock_event::clock_event(component_clock *comp, clock_event_meth_t *meth)
 
 }
 
+
+void vp::clock_event::profile_stub(void *_this, clock_event *event)
+{
+  // The event may be deleted by the callback, so nothing must be read from
+  // it after the call
+  profile_frame frame;
+  profiler::enter(&frame, static_cast<vp::component *>((vp::component_clock *)(event->comp)), PROFILE_EVENT);
+  event->profile_meth(_this, event);
+  profiler::leave(&frame);
+}
+
 void vp::component::new_master_port(std::string name, vp::master_port *port)
 {
   port->set_owner(this);
@@ -558,6 +803,25 @@ std::vector<std::string> split_name(const std::string& s, char delimiter)
    return tokens;
 }
 
+static std::unordered_set<std::string> *config_keys = NULL;
+
+const std::string *vp::config::intern_key(const std::string &name)
+{
+  if (config_keys == NULL)
+    config_keys = new std::unordered_set<std::string>();
+
+  return &*config_keys->insert(name).first;
+}
+
+const std::string *vp::config::find_key(const std::string &name)
+{
+  if (config_keys == NULL)
+    return NULL;
+
+  auto key = config_keys->find(name);
+  return key == config_keys->end() ? NULL : &*key;
+}
+
 vp::config *vp::config::create_config(jsmntok_t *tokens, int *_size)
 {
   jsmntok_t *current = tokens;
@@ -607,63 +871,77 @@ vp::config *vp::config::create_config(jsmntok_t *tokens, int *_size)
   return config;
 }
 
-vp::config *vp::config_string::get_from_list(std::vector<std::string> name_list)
+vp::config *vp::config_string::get_from_list(const std::vector<std::string> &name_list, unsigned int index)
 {
-  if (name_list.size() == 0) return this;
+  if (index == name_list.size()) return this;
   return NULL;
 }
 
-vp::config *vp::config_number::get_from_list(std::vector<std::string> name_list)
+vp::config *vp::config_number::get_from_list(const std::vector<std::string> &name_list, unsigned int index)
 {
-  if (name_list.size() == 0) return this;
+  if (index == name_list.size()) return this;
   return NULL;
 }
 
-vp::config *vp::config_bool::get_from_list(std::vector<std::string> name_list)
+vp::config *vp::config_bool::get_from_list(const std::vector<std::string> &name_list, unsigned int index)
 {
-  if (name_list.size() == 0) return this;
+  if (index == name_list.size()) return this;
   return NULL;
 }
 
-vp::config *vp::config_array::get_from_list(std::vector<std::string> name_list)
+vp::config *vp::config_array::get_from_list(const std::vector<std::string> &name_list, unsigned int index)
 {
-  if (name_list.size() == 0) return this;
+  if (index == name_list.size()) return this;
   return NULL;
 }
 
-vp::config *vp::config_object::get_from_list(std::vector<std::string> name_list)
+vp::config *vp::config_object::get_from_list(const std::vector<std::string> &name_list, unsigned int index)
 {
-  if (name_list.size() == 0) return this;
+  if (index == name_list.size()) return this;
 
   vp::config *result = NULL;
-  std::string name;
-  int name_pos = 0;
+  unsigned int name_pos = index;
 
-  for (auto& x: name_list) {
-    if (x != "*" && x != "**")
+  for (; name_pos < name_list.size(); name_pos++) {
+    if (name_list[name_pos] != "*" && name_list[name_pos] != "**")
     {
-      name = x;
       break;
     }
-    name_pos++;
   }
 
-  for (auto& x: childs) {
+  const std::string *name = NULL;
+  if (name_pos < name_list.size())
+  {
+    // A key which is not interned is not in any configuration, so the path
+    // cannot be found, with or without globs
+    name = find_key(name_list[name_pos]);
+    if (name == NULL)
+      return NULL;
+  }
+
+  if (name_pos == index)
+  {
+    auto child = this->indexed_childs.find(name);
+    if (child == this->indexed_childs.end())
+      return NULL;
+    return child->second->get_from_list(name_list, name_pos + 1);
+  }
+
+  for (auto& x: this->ordered_childs) {
 
     if (name == x.first)
     {
-      result = x.second->get_from_list(std::vector<std::string>(name_list.begin () + name_pos + 1, name_list.begin () + name_list.size()));
-      if (name_pos == 0 || result != NULL) return result;
-
+      result = x.second->get_from_list(name_list, name_pos + 1);
+      if (result != NULL) return result;
     }
-    else if (name_list[0] == "*")
+    else if (name_list[index] == "*")
     {
-      result = x.second->get_from_list(std::vector<std::string>(name_list.begin () + 1, name_list.begin () + name_list.size()));
+      result = x.second->get_from_list(name_list, index + 1);
       if (result != NULL) return result;
     }
-    else if (name_list[0] == "**")
+    else if (name_list[index] == "**")
     {
-      result = x.second->get_from_list(name_list);
+      result = x.second->get_from_list(name_list, index);
       if (result != NULL) return result;
     }
   }
@@ -673,7 +951,13 @@ vp::config *vp::config_object::get_from_list(std::vector<std::string> name_list)
 
 vp::config *vp::config_object::get(std::string name)
 {
-  return get_from_list(split_name(name, '/'));
+  auto path = this->paths.find(name);
+  if (path != this->paths.end())
+    return path->second;
+
+  vp::config *result = get_from_list(split_name(name, '/'));
+  this->paths[name] = result;
+  return result;
 }
 
 vp::config_string::config_string(jsmntok_t *tokens)
@@ -728,6 +1012,13 @@ vp::config_object::config_object(jsmntok_t *tokens, int *_size)
     }
   }
 
+  for (auto& x: childs)
+  {
+    const std::string *key = intern_key(x.first);
+    this->ordered_childs.push_back(std::make_pair(key, x.second));
+    this->indexed_childs[key] = x.second;
+  }
+
   if (_size) {
     *_size = current - tokens;
   }
@@ -943,6 +1234,16 @@ extern "C" void vp_comp_set_config(void *comp, const char *config)
   ((vp::component *)comp)->set_config(config);
 }
 
+extern "C" int vp_config_tree_load(const char *config)
+{
+  return vp::component::load_config_tree(config);
+}
+
+extern "C" int vp_config_tree_select(const char *path)
+{
+  return vp::component::select_config(path);
+}
+
 extern "C" void vp_comp_conf(void *comp, const char *path, void *parent)
 {
   ((vp::component *)comp)->conf(path, (vp::component *)parent);
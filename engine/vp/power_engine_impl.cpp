@@ -24,6 +24,28 @@
 #include <vector>
 #include <thread>
 #include <string.h>
+#include <algorithm>
+#include <atomic>
+
+
+// The power profile gives for each window the energy in pJ consumed by each
+// power trace, dynamic and leakage separately. Top traces, which usually
+// stand for power domains, include the energy of the traces they collect.
+// It is written as the simulation goes, so that only the totals of the
+// previous window are kept.
+// The binary format starts with a header, followed by the NUL-terminated
+// names of the traces, and then one record per window made of the end time
+// of the window and of 2 doubles per trace.
+#define POWER_PROFILE_MAGIC "GVPOWER"
+#define POWER_PROFILE_VERSION 1
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nb_traces;
+  int64_t window;
+} power_profile_header_t;
 
 
 class power_manager : public vp::power_engine
@@ -40,20 +62,110 @@ public:
 
   void reg_trace(vp::power_trace *trace);
 
+  bool is_batched() { return this->batched; }
+
+  int64_t get_window() { return this->window_duration; }
+
+  void window(int64_t time);
+
+  void stop();
+
+  void start_parallel();
+
+  void sync();
+
 private:
+  void open_profile();
+  void fold_deferred();
+  void do_start_capture();
+  void do_stop_capture();
+
   std::vector<vp::power_trace *> traces;
+  bool batched;
+
+  int64_t window_duration = 0;
+  bool profile_binary;
+  std::string profile_path;
+  FILE *profile_file = NULL;
+  bool profile_opened = false;
+  std::vector<double> last_totals;
+  std::vector<double> energies;
+
+  // Capture requests received while groups are running in parallel, which
+  // are executed at the next synchronization
+  bool parallel = false;
+  std::atomic<bool> start_capture_req{false};
+  std::atomic<bool> stop_capture_req{false};
 };
 
+void power_manager::start_parallel()
+{
+  this->parallel = true;
+  for (auto trace: this->traces)
+  {
+    trace->set_deferred(true);
+  }
+}
+
+void power_manager::fold_deferred()
+{
+  for (auto trace: this->traces)
+  {
+    trace->fold_deferred();
+  }
+}
+
+void power_manager::sync()
+{
+  this->fold_deferred();
+
+  if (this->start_capture_req.exchange(false))
+    this->do_start_capture();
+
+  if (this->stop_capture_req.exchange(false))
+    this->do_stop_capture();
+}
+
 void power_manager::start_capture()
 {
+  if (this->parallel)
+    this->start_capture_req = true;
+  else
+    this->do_start_capture();
+}
+
+void power_manager::stop_capture()
+{
+  if (this->parallel)
+    this->stop_capture_req = true;
+  else
+    this->do_stop_capture();
+}
+
+void power_manager::do_start_capture()
+{
+  this->fold_deferred();
+
+  // Events are folded before any trace is cleared, as they are also
+  // propagated to the top traces
+  for (auto trace: this->traces)
+  {
+    trace->fold(false);
+  }
+
   for (auto trace: this->traces)
   {
     trace->clear();
   }
+
+  // The totals are back to 0, the next window starts from there
+  std::fill(this->last_totals.begin(), this->last_totals.end(), 0);
 }
 
-void power_manager::stop_capture()
+void power_manager::do_stop_capture()
 {
+  this->fold_deferred();
+
   FILE *file = fopen("power_report.csv", "w");
   if (file == NULL)
   {
@@ -68,6 +180,8 @@ void power_manager::stop_capture()
     if (!trace->is_dumped())
       trace->get_top_trace()->dump(file);
   }
+
+  fclose(file);
 }
 
 void power_manager::reg_trace(vp::power_trace *trace)
@@ -75,6 +189,106 @@ void power_manager::reg_trace(vp::power_trace *trace)
   this->traces.push_back(trace);
 }
 
+void power_manager::open_profile()
+{
+  this->profile_opened = true;
+
+  this->last_totals.resize(this->traces.size() * 2);
+  this->energies.resize(this->traces.size() * 2);
+
+  this->profile_file = fopen(this->profile_path.c_str(), this->profile_binary ? "wb" : "w");
+  if (this->profile_file == NULL)
+  {
+    vp_warning_always(&this->warning, "Failed to open power profile file (path: %s, error: %s)\n", this->profile_path.c_str(), strerror(errno));
+    return;
+  }
+
+  if (this->profile_binary)
+  {
+    power_profile_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, POWER_PROFILE_MAGIC, 8);
+    header.version = POWER_PROFILE_VERSION;
+    header.nb_traces = this->traces.size();
+    header.window = this->window_duration;
+    fwrite(&header, sizeof(header), 1, this->profile_file);
+
+    for (auto trace: this->traces)
+    {
+      std::string name = trace->trace.get_name();
+      fwrite(name.c_str(), name.size() + 1, 1, this->profile_file);
+    }
+  }
+  else
+  {
+    fprintf(this->profile_file, "Time (ps)");
+    for (auto trace: this->traces)
+    {
+      fprintf(this->profile_file, "; %s dynamic (pJ); %s leakage (pJ)", trace->trace.get_name().c_str(), trace->trace.get_name().c_str());
+    }
+    fprintf(this->profile_file, "\n");
+  }
+}
+
+void power_manager::window(int64_t time)
+{
+  if (!this->profile_opened)
+    this->open_profile();
+
+  if (this->profile_file == NULL)
+    return;
+
+  // All the traces are flushed first, as they also account their energy to
+  // their top trace
+  for (auto trace: this->traces)
+  {
+    trace->flush();
+  }
+
+  this->fold_deferred();
+
+  for (unsigned int i=0; i<this->traces.size(); i++)
+  {
+    double dynamic = this->traces[i]->get_total();
+    double leakage = this->traces[i]->get_total_leakage();
+    this->energies[i*2] = dynamic - this->last_totals[i*2];
+    this->energies[i*2+1] = leakage - this->last_totals[i*2+1];
+    this->last_totals[i*2] = dynamic;
+    this->last_totals[i*2+1] = leakage;
+  }
+
+  if (this->profile_binary)
+  {
+    fwrite(&time, sizeof(time), 1, this->profile_file);
+    fwrite(this->energies.data(), sizeof(double), this->energies.size(), this->profile_file);
+  }
+  else
+  {
+    fprintf(this->profile_file, "%ld", time);
+    for (auto energy: this->energies)
+    {
+      fprintf(this->profile_file, "; %.12f", energy);
+    }
+    fprintf(this->profile_file, "\n");
+  }
+}
+
+void power_manager::stop()
+{
+  if (this->window_duration > 0)
+  {
+    // Last window, which may be shorter
+    if (this->engine)
+      this->window(this->engine->get_time());
+
+    if (this->profile_file)
+    {
+      fclose(this->profile_file);
+      this->profile_file = NULL;
+    }
+  }
+}
+
 
 vp::power_engine::power_engine(const char *config)
   : vp::component(config)
@@ -85,7 +299,23 @@ vp::power_engine::power_engine(const char *config)
 power_manager::power_manager(const char *config)
 : vp::power_engine(config)
 {
+  js::config *conf = this->get_js_config("**/power/batched");
+  this->batched = conf && conf->get_bool();
+
+  conf = this->get_js_config("**/power/profile/window");
+  if (conf)
+    this->window_duration = conf->get_int();
+
+  conf = this->get_js_config("**/power/profile/format");
+  std::string format = conf ? conf->get_str() : "csv";
+  this->profile_binary = format == "bin";
+  if (format != "csv" && format != "bin")
+  {
+    vp_warning_always(&this->warning, "Unknown power profile format, using csv (format: %s)\n", format.c_str());
+  }
 
+  conf = this->get_js_config("**/power/profile/file");
+  this->profile_path = conf ? conf->get_str() : this->profile_binary ? "power_profile.bin" : "power_profile.csv";
 }
 
 int power_manager::build()
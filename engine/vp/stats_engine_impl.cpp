@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/stats/stats_engine.hpp>
+#include <vector>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+// Layout of the live view, which is a file mapped in memory, usually in
+// /dev/shm, and updated at each dump. The sequence number is odd while the
+// values are being updated, so that readers can retry.
+#define STATS_SHM_MAGIC "GVSTATS"
+#define STATS_SHM_VERSION 1
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nb_values;
+  uint64_t seq;
+  int64_t time;
+  uint32_t names_offset;
+  uint32_t values_offset;
+} stats_shm_header_t;
+
+
+class stats_manager : public vp::stats_engine
+{
+public:
+
+  stats_manager(const char *config);
+
+  void reg_stat(vp::stat *stat);
+
+  int64_t get_period() { return this->period; }
+
+  void dump(int64_t time);
+
+  void stop();
+
+private:
+  void open();
+  void open_shm();
+  void get_values(int64_t time);
+
+  std::vector<vp::stat *> stats;
+  bool enabled;
+  bool json;
+  int64_t period = 0;
+  std::string path;
+  std::string shm_path;
+
+  FILE *file = NULL;
+  bool opened = false;
+  bool first_dump = true;
+
+  // One column per scalar and rate, one per bucket for histograms
+  std::vector<std::string> names;
+  std::vector<double> values;
+
+  stats_shm_header_t *shm = NULL;
+};
+
+
+vp::stats_engine::stats_engine(const char *config)
+  : vp::component(config)
+{
+  new_service("stats", static_cast<stats_engine *>(this));
+}
+
+
+stats_manager::stats_manager(const char *config)
+: vp::stats_engine(config)
+{
+  js::config *conf = this->get_js_config("**/stats/enabled");
+  this->enabled = conf && conf->get_bool();
+
+  conf = this->get_js_config("**/stats/format");
+  std::string format = conf ? conf->get_str() : "csv";
+  this->json = format == "json";
+  if (format != "csv" && format != "json")
+  {
+    vp_warning_always(&this->warning, "Unknown stats format, using csv (format: %s)\n", format.c_str());
+  }
+
+  conf = this->get_js_config("**/stats/file");
+  this->path = conf ? conf->get_str() : this->json ? "stats.json" : "stats.csv";
+
+  conf = this->get_js_config("**/stats/shm");
+  this->shm_path = conf ? conf->get_str() : "";
+
+  // The period is given either in picoseconds or in cycles of the
+  // specified frequency
+  conf = this->get_js_config("**/stats/period");
+  if (conf)
+    this->period = conf->get_int();
+
+  conf = this->get_js_config("**/stats/cycles");
+  if (conf)
+  {
+    js::config *freq_conf = this->get_js_config("**/stats/frequency");
+    int64_t frequency = freq_conf ? freq_conf->get_int() : 0;
+    if (frequency <= 0)
+    {
+      vp_warning_always(&this->warning, "Stats period given in cycles without frequency, only dumping at the end\n");
+    }
+    else
+    {
+      this->period = (int64_t)((double)conf->get_int() * 1e12 / frequency);
+    }
+  }
+
+  if (!this->enabled)
+    this->period = 0;
+}
+
+
+void stats_manager::reg_stat(vp::stat *stat)
+{
+  this->stats.push_back(stat);
+}
+
+
+void stats_manager::open()
+{
+  this->opened = true;
+
+  for (auto stat: this->stats)
+  {
+    if (stat->get_type() == vp::STAT_HISTOGRAM)
+    {
+      vp::stat_histogram *histogram = (vp::stat_histogram *)stat;
+      for (int i=0; i<histogram->get_nb_buckets(); i++)
+      {
+        this->names.push_back(stat->get_name() + "[" + std::to_string(histogram->get_bucket_base(i)) + "]");
+      }
+    }
+    else
+    {
+      this->names.push_back(stat->get_name());
+    }
+  }
+  this->values.resize(this->names.size());
+
+  if (this->path != "")
+  {
+    this->file = fopen(this->path.c_str(), "w");
+    if (this->file == NULL)
+    {
+      vp_warning_always(&this->warning, "Failed to open stats file (path: %s, error: %s)\n", this->path.c_str(), strerror(errno));
+    }
+    else if (!this->json)
+    {
+      fprintf(this->file, "time");
+      for (auto &name: this->names)
+      {
+        fprintf(this->file, ",%s", name.c_str());
+      }
+      fprintf(this->file, "\n");
+    }
+  }
+
+  if (this->shm_path != "")
+    this->open_shm();
+}
+
+
+void stats_manager::open_shm()
+{
+  uint32_t names_size = 0;
+  for (auto &name: this->names)
+  {
+    names_size += name.size() + 1;
+  }
+
+  uint32_t values_offset = (sizeof(stats_shm_header_t) + names_size + 7) & ~7;
+  size_t size = values_offset + this->names.size() * sizeof(double);
+
+  int fd = ::open(this->shm_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1 || ftruncate(fd, size) == -1)
+  {
+    vp_warning_always(&this->warning, "Failed to create stats live view (path: %s, error: %s)\n", this->shm_path.c_str(), strerror(errno));
+    if (fd != -1)
+      close(fd);
+    return;
+  }
+
+  void *area = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (area == MAP_FAILED)
+  {
+    vp_warning_always(&this->warning, "Failed to map stats live view (path: %s, error: %s)\n", this->shm_path.c_str(), strerror(errno));
+    return;
+  }
+
+  this->shm = (stats_shm_header_t *)area;
+  memcpy(this->shm->magic, STATS_SHM_MAGIC, 8);
+  this->shm->version = STATS_SHM_VERSION;
+  this->shm->nb_values = this->names.size();
+  this->shm->seq = 0;
+  this->shm->time = 0;
+  this->shm->names_offset = sizeof(stats_shm_header_t);
+  this->shm->values_offset = values_offset;
+
+  char *names = (char *)area + this->shm->names_offset;
+  for (auto &name: this->names)
+  {
+    memcpy(names, name.c_str(), name.size() + 1);
+    names += name.size() + 1;
+  }
+}
+
+
+void stats_manager::get_values(int64_t time)
+{
+  int index = 0;
+  for (auto stat: this->stats)
+  {
+    switch (stat->get_type())
+    {
+      case vp::STAT_SCALAR:
+        this->values[index++] = ((vp::stat_scalar *)stat)->get();
+        break;
+
+      case vp::STAT_RATE:
+        this->values[index++] = ((vp::stat_rate *)stat)->sample(time);
+        break;
+
+      case vp::STAT_HISTOGRAM:
+      {
+        vp::stat_histogram *histogram = (vp::stat_histogram *)stat;
+        for (int i=0; i<histogram->get_nb_buckets(); i++)
+        {
+          this->values[index++] = histogram->get_bucket(i);
+        }
+        break;
+      }
+    }
+  }
+}
+
+
+void stats_manager::dump(int64_t time)
+{
+  if (!this->enabled)
+    return;
+
+  if (!this->opened)
+    this->open();
+
+  this->get_values(time);
+
+  if (this->file)
+  {
+    if (this->json)
+    {
+      // One JSON object per line and per dump
+      fprintf(this->file, "{\"time\": %ld, \"stats\": {", time);
+      for (unsigned int i=0; i<this->names.size(); i++)
+      {
+        fprintf(this->file, "%s\"%s\": %.17g", i == 0 ? "" : ", ", this->names[i].c_str(), this->values[i]);
+      }
+      fprintf(this->file, "}}\n");
+    }
+    else
+    {
+      fprintf(this->file, "%ld", time);
+      for (auto value: this->values)
+      {
+        fprintf(this->file, ",%.17g", value);
+      }
+      fprintf(this->file, "\n");
+    }
+  }
+
+  if (this->shm)
+  {
+    double *values = (double *)((char *)this->shm + this->shm->values_offset);
+    __atomic_store_n(&this->shm->seq, this->shm->seq + 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    memcpy(values, this->values.data(), this->values.size() * sizeof(double));
+    this->shm->time = time;
+    __atomic_store_n(&this->shm->seq, this->shm->seq + 1, __ATOMIC_RELEASE);
+  }
+}
+
+
+void stats_manager::stop()
+{
+  if (!this->enabled)
+    return;
+
+  this->dump(this->engine ? this->engine->get_time() : 0);
+
+  if (this->file)
+  {
+    fclose(this->file);
+    this->file = NULL;
+  }
+}
+
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new stats_manager(config);
+}
@@ -20,6 +20,8 @@
 
 #include <vp/vp.hpp>
 #include "vp/time/time_engine.hpp"
+#include "vp/stats/stats_engine.hpp"
+#include "vp/power/power_engine.hpp"
 #include <pthread.h>
 #include <signal.h>
 
@@ -50,6 +52,104 @@ SC_MODULE(my_module)
 
 
 
+// Client of the time engine used to save a checkpoint at a given time,
+// while no clock engine is running
+class checkpoint_client : public vp::time_engine_client
+{
+public:
+  checkpoint_client(vp::time_engine *engine, std::string path, std::string parent, bool exit);
+
+  int64_t exec();
+
+private:
+  std::string path;
+  std::string parent;
+  bool exit;
+};
+
+checkpoint_client::checkpoint_client(vp::time_engine *engine, std::string path, std::string parent, bool exit)
+: vp::time_engine_client("{}"), path(path), parent(parent), exit(exit)
+{
+  this->engine = engine;
+}
+
+int64_t checkpoint_client::exec()
+{
+  if (this->engine->save_checkpoint(this->path, this->parent) == 0 && this->exit)
+  {
+    this->engine->stop_engine(0);
+  }
+
+  return -1;
+}
+
+
+
+// Client of the time engine used to dump the stats periodically. It is
+// passive and stops once no other active client has events so that it does
+// not keep the simulation alive.
+class stats_client : public vp::time_engine_client
+{
+public:
+  stats_client(vp::time_engine *engine, vp::stats_engine *stats);
+
+  int64_t exec();
+
+private:
+  vp::stats_engine *stats;
+};
+
+stats_client::stats_client(vp::time_engine *engine, vp::stats_engine *stats)
+: vp::time_engine_client("{}"), stats(stats)
+{
+  this->engine = engine;
+  this->passive = true;
+}
+
+int64_t stats_client::exec()
+{
+  this->stats->dump(this->engine->get_time());
+
+  if (!this->engine->has_clients())
+    return -1;
+
+  return this->stats->get_period();
+}
+
+
+
+// Client of the time engine used to close the windows of the power profile.
+// Like the stats one, it stops once no other client has events.
+class power_client : public vp::time_engine_client
+{
+public:
+  power_client(vp::time_engine *engine, vp::power_engine *power);
+
+  int64_t exec();
+
+private:
+  vp::power_engine *power;
+};
+
+power_client::power_client(vp::time_engine *engine, vp::power_engine *power)
+: vp::time_engine_client("{}"), power(power)
+{
+  this->engine = engine;
+  this->passive = true;
+}
+
+int64_t power_client::exec()
+{
+  this->power->window(this->engine->get_time());
+
+  if (!this->engine->has_clients())
+    return -1;
+
+  return this->power->get_window();
+}
+
+
+
 class time_domain : public vp::time_engine
 {
 
@@ -128,6 +228,13 @@ vp::time_engine::time_engine(const char *config)
   stop_req = false;
 }
 
+vp::time_engine::time_engine(time_engine *parent, int id)
+  : vp::component("{}"), first_client(NULL), parent(parent), group_id(id)
+{
+  run_req = false;
+  stop_req = false;
+}
+
 
 // This is called by the python thread once he wants to start the time engine.
 // This for now just takes care of stopping the engine when it is asked
@@ -182,6 +289,7 @@ string vp::time_engine::run()
       {
 
         running = false;
+        killed = true;
         pthread_cancel(run_thread);
 
         result = "killed";
@@ -197,7 +305,7 @@ string vp::time_engine::run()
 void vp::time_engine::start()
 {
 
-  js::config *item_conf = this->get_js_config()->get("**/gvsoc/no_exit");
+  js::config *item_conf = this->get_js_config("**/gvsoc/no_exit");
   this->no_exit = item_conf != NULL && item_conf->get_bool();
 
   if (this->no_exit)
@@ -206,9 +314,444 @@ void vp::time_engine::start()
     // from exiting in case there is no more events.
     retain_count++;
   }
+
+#ifndef __VP_USE_SYSTEMC
+  item_conf = this->get_js_config("**/gvsoc/parallel/enabled");
+  this->parallel = item_conf != NULL && item_conf->get_bool();
+  if (this->parallel)
+  {
+    // Quantum is in picoseconds, default is 1us
+    item_conf = this->get_js_config("**/gvsoc/parallel/quantum");
+    this->quantum = item_conf != NULL ? item_conf->get_int() : 1000000;
+  }
+#endif
+
   pthread_create(&run_thread, NULL, engine_routine, (void *)this);
 }
 
+// Routine executed by the threads running the groups of clock domains in
+// parallel mode. Each window is started and ended by the coordinator through
+// barriers.
+void *vp::time_engine::group_routine(void *arg)
+{
+  vp::time_engine *group = (vp::time_engine *)arg;
+  vp::time_engine *engine = group->parent;
+
+  current_group = group;
+
+  while(1)
+  {
+    pthread_barrier_wait(&engine->window_start_barrier);
+    if (engine->groups_exit)
+      break;
+    group->run_group(engine->window_end);
+    pthread_barrier_wait(&engine->window_end_barrier);
+  }
+
+  return NULL;
+}
+
+void vp::time_engine::stop()
+{
+  if (this->group_threads.size() == 0)
+    return;
+
+  // The engine thread is not running anymore, the groups are waiting for the
+  // next window and are released to exit instead. If the engine thread was
+  // killed, the groups may be in the middle of a window and are left as is.
+  if (!this->killed)
+  {
+    this->groups_exit = true;
+    pthread_barrier_wait(&this->window_start_barrier);
+
+    for (auto thread: this->group_threads)
+    {
+      pthread_join(thread, NULL);
+    }
+  }
+
+  this->group_threads.clear();
+}
+
+void vp::time_engine::parallel_init()
+{
+  this->parallel_started = true;
+
+  // Traces and events are dumped through shared buffers which are not
+  // protected against concurrent accesses
+  js::config *traces = this->get_js_config("**/gvsoc/trace");
+  js::config *events = this->get_js_config("**/gvsoc/event");
+  if ((traces && traces->get_size()) || (events && events->get_size()))
+  {
+    this->engine_warning("Parallel mode is not compatible with traces and events, switching to sequential mode\n");
+    this->parallel = false;
+    return;
+  }
+
+  // The first group gets all clock domains not matching any group path
+  js::config *groups_conf = this->get_js_config("**/gvsoc/parallel/groups");
+  int nb_groups = 1 + (groups_conf != NULL ? groups_conf->get_size() : 0);
+
+  for (int i=0; i<nb_groups; i++)
+  {
+    vp::time_engine *group = new vp::time_engine(this, i);
+    group->time = this->time;
+    group->posted_calls.resize(nb_groups);
+    this->groups.push_back(group);
+  }
+
+  for (auto client: this->clients)
+  {
+    vp::time_engine *group = this->groups[0];
+
+    if (groups_conf != NULL)
+    {
+      int index = 1;
+      for (auto group_conf: groups_conf->get_elems())
+      {
+        for (auto path_conf: group_conf->get_elems())
+        {
+          std::string path = path_conf->get_str();
+          if (group == this->groups[0] && client->get_path().compare(0, path.size(), path) == 0)
+          {
+            group = this->groups[index];
+          }
+        }
+        index++;
+      }
+    }
+
+    // Move the pending events of the client to its group
+    int64_t next_event_time = client->next_event_time;
+    bool enqueued = this->dequeue(client);
+    client->engine = group;
+    if (enqueued)
+    {
+      group->enqueue(client, next_event_time - group->get_time());
+    }
+  }
+
+  // The other clients, which are not driven by a clock, go to the first
+  // group, as the main engine only schedules the windows
+  while (this->first_client)
+  {
+    time_engine_client *client = this->first_client;
+    int64_t next_event_time = client->next_event_time;
+    this->dequeue(client);
+    client->engine = this->groups[0];
+    this->groups[0]->enqueue(client, next_event_time - this->groups[0]->get_time());
+  }
+
+  // Power traces may propagate their energy to top traces executed by other
+  // groups, they now accumulate it locally until the next synchronization
+  this->power = (vp::power_engine *)this->get_service("power");
+  if (this->power)
+    this->power->start_parallel();
+
+  pthread_barrier_init(&this->window_start_barrier, NULL, nb_groups);
+  pthread_barrier_init(&this->window_end_barrier, NULL, nb_groups);
+
+  // The first group is executed by the engine thread
+  for (int i=1; i<nb_groups; i++)
+  {
+    pthread_t thread;
+    pthread_create(&thread, NULL, group_routine, (void *)this->groups[i]);
+    this->group_threads.push_back(thread);
+  }
+}
+
+void vp::time_engine::run_group(int64_t end_time)
+{
+  while (this->first_client && this->first_client->next_event_time < end_time)
+  {
+    time_engine_client *current = this->first_client;
+    this->first_client = current->next;
+    current->is_enqueued = false;
+
+    this->time = current->next_event_time;
+
+    current->running = true;
+
+    int64_t time = current->exec();
+
+    // Shortcut to quickly continue with the same client
+    while (time > 0 && this->time + time < end_time &&
+      (!this->first_client || this->first_client->next_event_time >= this->time + time))
+    {
+      this->time += time;
+      time = current->exec();
+    }
+
+    current->running = false;
+
+    if (time > 0)
+    {
+      this->enqueue(current, time);
+    }
+  }
+
+  this->time = end_time;
+}
+
+void vp::time_engine::run_parallel()
+{
+  while (run_req)
+  {
+    // Quanta are aligned on multiples of the quantum so that the execution
+    // does not depend on when groups became idle
+    int64_t next_time = -1;
+    for (auto group: this->groups)
+    {
+      if (group->first_client && (next_time == -1 || group->first_client->next_event_time < next_time))
+        next_time = group->first_client->next_event_time;
+    }
+
+    if (next_time == -1)
+      break;
+
+    this->window_end = (next_time / this->quantum + 1) * this->quantum;
+
+    pthread_barrier_wait(&this->window_start_barrier);
+    current_group = this->groups[0];
+    this->groups[0]->run_group(this->window_end);
+    current_group = NULL;
+    pthread_barrier_wait(&this->window_end_barrier);
+
+    this->time = this->window_end;
+
+    // All groups are now stopped, deliver the calls which crossed groups
+    // during the quantum, always in the same order
+    this->delivering = true;
+    for (auto group: this->groups)
+    {
+      for (auto &calls: group->posted_calls)
+      {
+        for (auto &call: calls)
+        {
+          call();
+        }
+        calls.clear();
+      }
+    }
+    this->delivering = false;
+
+    if (this->power)
+      this->power->sync();
+  }
+}
+
+bool vp::time_engine::has_active_clients(vp::time_engine_client *client)
+{
+  for (; client; client = client->next)
+  {
+    if (!client->passive)
+      return true;
+  }
+  return false;
+}
+
+bool vp::time_engine::has_clients()
+{
+  if (this->parallel && this->parallel_started)
+  {
+    for (auto group: this->groups)
+    {
+      if (has_active_clients(group->first_client))
+        return true;
+    }
+    return false;
+  }
+
+  return has_active_clients(this->first_client);
+}
+
+void vp::time_engine::save(vp::checkpoint *checkpoint)
+{
+  checkpoint->write<int64_t>(this->time);
+}
+
+void vp::time_engine::restore(vp::checkpoint *checkpoint)
+{
+  // The time is restored first as it is the root of the hierarchy, so that
+  // clock engines can resynchronize on it
+  this->time = checkpoint->read<int64_t>();
+}
+
+int vp::time_engine::save_checkpoint(std::string path, std::string parent)
+{
+  vp::checkpoint checkpoint;
+
+  if (checkpoint.open_write(path, parent) == 0)
+  {
+    this->save_all(&checkpoint);
+  }
+
+  checkpoint.close();
+
+  if (checkpoint.has_error())
+  {
+    this->engine_warning("Failed to save checkpoint (error: %s)\n", checkpoint.get_error().c_str());
+    return -1;
+  }
+
+  return 0;
+}
+
+bool vp::time_engine::is_checkpoint_enabled()
+{
+  if (this->parent)
+    return this->parent->is_checkpoint_enabled();
+
+  // This can be called by the components before the checkpoints are
+  // initialized, the configuration is then read on first call
+  if (this->checkpoint_enabled == -1)
+  {
+    js::config *item_conf = this->get_js_config("**/gvsoc/checkpoint/save");
+    this->checkpoint_enabled = item_conf != NULL && item_conf->get_str() != "";
+  }
+
+  return this->checkpoint_enabled;
+}
+
+bool vp::time_engine::is_checkpoint_used()
+{
+  if (this->parent)
+    return this->parent->is_checkpoint_used();
+
+  if (this->checkpoint_used == -1)
+  {
+    js::config *item_conf = this->get_js_config("**/gvsoc/checkpoint/restore");
+    this->checkpoint_used = this->is_checkpoint_enabled() || (item_conf != NULL && item_conf->get_str() != "");
+  }
+
+  return this->checkpoint_used;
+}
+
+int vp::time_engine::load_checkpoint(std::string path)
+{
+  vp::checkpoint checkpoint;
+
+  if (checkpoint.open_read(path) == 0)
+  {
+    // Incremental checkpoints only contain the memory pages modified since
+    // their parent, which must then be restored first
+    if (checkpoint.is_incremental() && this->load_checkpoint(checkpoint.get_parent()))
+    {
+      checkpoint.close();
+      return -1;
+    }
+
+    this->restore_all(&checkpoint);
+  }
+
+  checkpoint.close();
+
+  if (checkpoint.has_error())
+  {
+    this->engine_warning("Failed to restore checkpoint (error: %s)\n", checkpoint.get_error().c_str());
+    return -1;
+  }
+
+  return 0;
+}
+
+int vp::time_engine::restore_checkpoint(std::string path)
+{
+  if (this->load_checkpoint(path))
+    return -1;
+
+  // Pending events are only enqueued once all clock engines are restored
+  this->post_restore_all();
+
+  return 0;
+}
+
+void vp::time_engine::checkpoint_init()
+{
+  js::config *item_conf = this->get_js_config("**/gvsoc/checkpoint/restore");
+  std::string restore_path = item_conf != NULL ? item_conf->get_str() : "";
+  item_conf = this->get_js_config("**/gvsoc/checkpoint/save");
+  std::string save_path = item_conf != NULL ? item_conf->get_str() : "";
+
+  if ((restore_path != "" || save_path != "") && this->parallel)
+  {
+    this->engine_warning("Checkpoints are not supported in parallel mode, switching to sequential mode\n");
+    this->parallel = false;
+  }
+
+  if (restore_path != "")
+  {
+    if (this->restore_checkpoint(restore_path))
+    {
+      this->fatal("Failed to restore checkpoint from %s\n", restore_path.c_str());
+      return;
+    }
+  }
+
+  if (save_path != "")
+  {
+    item_conf = this->get_js_config("**/gvsoc/checkpoint/parent");
+    std::string parent = item_conf != NULL ? item_conf->get_str() : "";
+    item_conf = this->get_js_config("**/gvsoc/checkpoint/save_exit");
+    bool exit = item_conf != NULL && item_conf->get_bool();
+
+    // The time is given as a string as it does not fit the integer type
+    // of the configuration
+    item_conf = this->get_js_config("**/gvsoc/checkpoint/save_time");
+    int64_t save_time = item_conf != NULL ? strtoll(item_conf->get_str().c_str(), NULL, 0) : 0;
+
+    if (save_time < this->time)
+    {
+      this->engine_warning("Checkpoint save time is before the restored time, saving now\n");
+      save_time = this->time;
+    }
+
+    checkpoint_client *client = new checkpoint_client(this, save_path, parent, exit);
+    this->enqueue(client, save_time - this->time);
+  }
+}
+
+void vp::time_engine::stats_init()
+{
+  vp::stats_engine *stats = (vp::stats_engine *)this->get_service("stats");
+  if (stats == NULL)
+    return;
+
+  stats->set_time_engine(this);
+
+  if (stats->get_period() > 0)
+  {
+    // Components of different groups would be read while they are executed
+    if (this->parallel)
+    {
+      this->engine_warning("Periodic stats are not supported in parallel mode, only dumping at the end\n");
+      return;
+    }
+
+    this->enqueue(new stats_client(this, stats), stats->get_period());
+  }
+}
+
+void vp::time_engine::power_init()
+{
+  vp::power_engine *power = (vp::power_engine *)this->get_service("power");
+  if (power == NULL)
+    return;
+
+  power->set_time_engine(this);
+
+  if (power->get_window() > 0)
+  {
+    if (this->parallel)
+    {
+      this->engine_warning("Power profile is not supported in parallel mode, only dumping the last window\n");
+      return;
+    }
+
+    this->enqueue(new power_client(this, power), power->get_window());
+  }
+}
+
 void vp::time_engine::wait_ready()
 {
   while (!first_client)
@@ -250,10 +793,25 @@ void vp::time_engine::run_loop()
       pthread_create(&sigint_thread, NULL, signal_routine, (void *)this);
 
       signal (SIGINT, sigint_handler);
+
+      pthread_mutex_unlock(&mutex);
+      this->checkpoint_init();
+      this->stats_init();
+      this->power_init();
+      pthread_mutex_lock(&mutex);
     }
 
     pthread_mutex_unlock(&mutex);
 
+    if (this->parallel)
+    {
+      if (!this->parallel_started)
+        this->parallel_init();
+
+      if (this->parallel)
+        this->run_parallel();
+    }
+
     time_engine_client *current = first_client;
 
     if (current)
@@ -405,7 +963,7 @@ void vp::time_engine::run_loop()
 
     running = false;
 
-    while(!first_client && retain_count && !locked)
+    while(!this->has_clients() && retain_count && !locked)
     {
 #ifdef __VP_USE_SYSTEMC
       pthread_mutex_unlock(&mutex);
@@ -418,7 +976,7 @@ void vp::time_engine::run_loop()
 
     current = first_client;
 
-    if (first_client == NULL && !locked && !retain_count)
+    if (!this->has_clients() && !locked && !retain_count)
     {
 #ifdef __VP_USE_SYSTEMC
       sc_stop();
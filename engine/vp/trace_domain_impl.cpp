@@ -21,7 +21,7 @@
 #include <vp/vp.hpp>
 #include <vp/itf/clk.hpp>
 #include <vp/trace/trace_engine.hpp>
-#include <regex.h>
+#include <vp/trace/trace_matcher.hpp>
 #include <vector>
 #include <thread>
 #include <string.h>
@@ -51,8 +51,9 @@ public:
 
 private:
 
-  std::vector<regex_t *> path_regex;
-  std::vector<regex_t *> events_path_regex;
+  vp::trace_matcher path_matcher;
+  vp::trace_matcher events_path_matcher;
+  int nb_paths = 0;
   std::vector<string> events_file;
   int max_path_len = 0;
   vp::trace_level_e trace_level = vp::TRACE;
@@ -66,14 +67,73 @@ vp::trace_engine::trace_engine(const char *config)
   pthread_mutex_init(&mutex, NULL);
   pthread_cond_init(&cond, NULL);
 
-  for (int i=0; i<TRACE_EVENT_NB_BUFFER; i++)
+  this->nb_rings = 0;
+  this->end = 0;
+  this->consumer_waiting = false;
+  this->next_pending_timestamp = INT64_MAX;
+
+  // Each producer thread gets a ring of this size, rounded to a power of 2
+  this->ring_size = TRACE_RING_SIZE;
+  js::config *ring_config = this->get_js_config("**/trace_ring/size");
+  if (ring_config)
   {
-    event_buffers.push_back(new char[TRACE_EVENT_BUFFER_SIZE]);
+    int size = ring_config->get_int();
+    this->ring_size = 1 << 16;
+    while (this->ring_size < size)
+      this->ring_size <<= 1;
+  }
+
+  ring_config = this->get_js_config("**/trace_ring/stats");
+  this->ring_stats = ring_config && ring_config->get_bool();
+
+  // The profiler must be enabled before the components are built so that
+  // their events get the profiler stub. The trace engine is the first
+  // component created, which makes it the right place.
+  js::config *profile_config = this->get_js_config("**/profile/enabled");
+  if (profile_config && profile_config->get_bool())
+  {
+    vp::profiler::enable();
+
+    profile_config = this->get_js_config("**/profile/report");
+    this->profile_report = profile_config ? profile_config->get_str() : "";
+    profile_config = this->get_js_config("**/profile/folded");
+    this->profile_folded = profile_config ? profile_config->get_str() : "profile.folded";
+  }
+
+  // Text traces can be written by the trace engine thread, to stdout or to
+  // a file which can be compressed and rotated
+  this->flush_requested = false;
+  js::config *sink_config = this->get_js_config("**/trace_sink/async");
+  this->text_async = sink_config && sink_config->get_bool();
+  if (this->text_async)
+  {
+    std::string path = "";
+    int64_t rotate_size = 0;
+    bool gzip = false;
+
+    sink_config = this->get_js_config("**/trace_sink/file");
+    if (sink_config)
+      path = sink_config->get_str();
+
+    sink_config = this->get_js_config("**/trace_sink/rotate_mb");
+    if (sink_config)
+      rotate_size = (int64_t)sink_config->get_int() << 20;
+
+    sink_config = this->get_js_config("**/trace_sink/compress");
+    if (sink_config)
+    {
+      std::string compress = sink_config->get_str();
+      if (compress == "gzip")
+        gzip = true;
+      else if (compress != "none")
+      {
+        fprintf(stderr, "Unknown trace compression (name: %s, available: none, gzip)\n", compress.c_str());
+        abort();
+      }
+    }
+
+    this->text_sink.open(path, rotate_size, gzip);
   }
-  current_buffer = event_buffers[0];
-  event_buffers.erase(event_buffers.begin());
-  current_buffer_size = 0;
-  this->first_pending_event = NULL;
   
   thread = new std::thread(&trace_engine::vcd_routine, this);
 }
@@ -81,7 +141,13 @@ vp::trace_engine::trace_engine(const char *config)
 trace_domain::trace_domain(const char *config)
 : vp::trace_engine(config)
 {
-
+  // Allows comparing with the regexec-only matching
+  js::config *regex_only = this->get_js_config("**/trace_match/regex_only");
+  if (regex_only && regex_only->get_bool())
+  {
+    this->path_matcher.set_regex_only(true);
+    this->events_path_matcher.set_regex_only(true);
+  }
 }
 
 
@@ -91,27 +157,26 @@ void trace_domain::reg_trace(vp::trace *trace, int event, string path, string na
   int len = path.size() + name.size() + 1;
   if (len > max_path_len) max_path_len = len;
 
-  string full_path = path + "/" + name;
-  int index = 0;
-  for (auto& x: event ? events_path_regex : path_regex) {
-    if (regexec(x, full_path.c_str(), 0, NULL, 0) == 0)
+  std::vector<int> ids;
+  (event ? events_path_matcher : path_matcher).match(path, name, ids);
+
+  for (int index: ids)
+  {
+    if (event)
     {
-      if (event)
-      {
-        vp::Event_trace *event_trace;
-        if (trace->is_real)
-          event_trace = event_dumper.get_trace_real(full_path, this->events_file[index]);
-        else if (trace->is_string)
-          event_trace = event_dumper.get_trace_string(full_path, this->events_file[index]);
-        else
-          event_trace = event_dumper.get_trace(full_path, this->events_file[index], trace->width);
-        trace->set_event_active(true);
-        trace->event_trace = event_trace;
-      }
+      string full_path = path + "/" + name;
+      vp::Event_trace *event_trace;
+      if (trace->is_real)
+        event_trace = event_dumper.get_trace_real(full_path, this->events_file[index]);
+      else if (trace->is_string)
+        event_trace = event_dumper.get_trace_string(full_path, this->events_file[index]);
       else
-        trace->set_active(true);
+        event_trace = event_dumper.get_trace(full_path, this->events_file[index], trace->width);
+      trace->set_event_active(true);
+      trace->event_trace = event_trace;
     }
-    index++;
+    else
+      trace->set_active(true);
   }
 }
 
@@ -123,7 +188,6 @@ int trace_domain::build()
 
 void trace_domain::add_path(int events, const char *path)
 {
-  regex_t *regex = new regex_t();
   if (events)
   {
     const char *file_path = "all.vcd";
@@ -133,12 +197,13 @@ void trace_domain::add_path(int events, const char *path)
       *delim = 0;
       file_path = delim + 1;
     }
-    events_path_regex.push_back(regex);
+    events_path_matcher.add(path, events_file.size());
     events_file.push_back((char *)file_path);
   }
   else
-    path_regex.push_back(regex);
-  regcomp(regex, path, 0);
+  {
+    path_matcher.add(path, nb_paths++);
+  }
 }
 
 void trace_domain::add_paths(int events, int nb_path, const char **paths)
@@ -28,8 +28,23 @@ typedef enum {
   GV_CONF_NO_TIMING = 0
 } gv_conf_timing_e;
 
+// Transport of the io requests between the launcher and the injectors of
+// the platform. With the shared-memory transport, the requests and their
+// payloads are exchanged through rings in a memory region shared with the
+// platform, and requests bigger than a slot payload are split into several
+// slots. The pipe transport is the default.
+typedef enum {
+  GV_CONF_TRANSPORT_PIPE = 0,
+  GV_CONF_TRANSPORT_SHM = 1
+} gv_conf_transport_e;
+
 typedef struct {
   gv_conf_timing_e timing;
+  gv_conf_transport_e transport;
+  // Number of requests each side can have in flight, and maximum payload
+  // size of each request, for the shared-memory transport
+  int shm_nb_slots;
+  int shm_slot_size;
 } gv_conf_t;
 
 #ifdef __cplusplus
@@ -66,6 +81,30 @@ typedef struct {
 typedef void (*gv_ioreq_response_t)(void *context, gv_ioreq_t *req);
 typedef void (*gv_ioreq_request_t)(void *context, void *data, void *addr, size_t size, int is_write, gv_ioreq_response_t callback, void *cb_context);
 
+// Asynchronous vectored requests. A request covers a contiguous range of the
+// platform starting at addr, whose data is scattered over several buffers.
+// Requests are submitted in batches and identified by their tag in the
+// completions, which are retrieved with gv_ioreq_poll or gv_ioreq_wait.
+typedef struct {
+  void   *data;
+  size_t  size;
+} gv_iovec_t;
+
+typedef struct {
+  uint64_t          addr;
+  const gv_iovec_t *iov;
+  int               iovcnt;
+  int               is_write;
+  int64_t           timestamp;
+  uint64_t          tag;
+} gv_ioreq_vec_t;
+
+typedef struct {
+  uint64_t         tag;
+  gv_ioreq_state_e state;
+  int              latency;
+} gv_ioreq_completion_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -74,6 +113,25 @@ void *gv_ioreq_binding(void *handle, char *path, void *base, size_t size, gv_ior
 
 int gv_ioreq(void *binding, int64_t timestamp, void *data, void *addr, size_t size, int is_write, gv_ioreq_response_t callback, void *context);
 
+// Submits the requests, and only wakes the platform once for all of them.
+// Returns the number of submitted requests, which is less than nb_reqs if
+// the transport failed. A request which could only be partly sent gets an
+// error completion and is counted as submitted.
+int gv_ioreq_submit(void *binding, const gv_ioreq_vec_t *reqs, int nb_reqs);
+
+// Retrieves up to max completions, without blocking for gv_ioreq_poll, or
+// blocking until at least min are available for gv_ioreq_wait. Returns the
+// number of completions.
+int gv_ioreq_poll(void *binding, gv_ioreq_completion_t *completions, int max);
+
+int gv_ioreq_wait(void *binding, gv_ioreq_completion_t *completions, int min, int max);
+
+// Bulk memory load and dump, which return once the whole range is done.
+// Return 0 on success, or -1.
+int gv_ioreq_load(void *binding, void *addr, const void *data, size_t size);
+
+int gv_ioreq_dump(void *binding, void *addr, void *data, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,9 @@
 
 #include "vp/launcher.h"
 #include <stdint.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #define GV_IOREQ_DESC_TYPE_REQUEST  0
 #define GV_IOREQ_DESC_TYPE_RESPONSE 1
@@ -42,4 +45,157 @@ typedef struct {
   void                *data;
 } gv_ioreq_desc_t;
 
+
+// Shared-memory transport.
+// The region holds two pools of slots, one for the requests sent by the
+// launcher and one for the requests sent by the injector. A slot is a
+// request descriptor followed by its payload, which the receiver accesses in
+// place. Slot indexes are exchanged through two single-producer
+// single-consumer rings, one per direction. A slot goes to the other side
+// with its request and comes back with its response, so each ring has room
+// for both pools and can never be full.
+// The consumer of a ring drains all the available indexes at once, and
+// sleeps on a futex on the ring tail when it is empty. The producer publishes
+// each index and only wakes it up once per batch.
+
+#define GV_SHM_MAGIC       0x67767368
+#define GV_SHM_TO_FABRIC   0
+#define GV_SHM_TO_HOST     1
+// Set in the index of the slots of the injector pool
+#define GV_SHM_SLOT_FABRIC (1U<<31)
+#define GV_SHM_SPIN        1024
+
+typedef struct {
+  uint32_t head __attribute__((aligned(64)));
+  uint32_t tail __attribute__((aligned(64)));
+  uint32_t waiting;
+} gv_shm_ring_t;
+
+typedef struct {
+  uint32_t      magic;
+  uint32_t      nb_slots;
+  uint32_t      slot_size;
+  uint32_t      ring_size;
+  gv_shm_ring_t rings[2];
+} gv_shm_header_t;
+
+static inline size_t gv_shm_slot_stride(uint32_t slot_size)
+{
+  return (sizeof(gv_ioreq_desc_t) + slot_size + 63) & ~(size_t)63;
+}
+
+static inline size_t gv_shm_slots_offset(uint32_t ring_size)
+{
+  return (sizeof(gv_shm_header_t) + 2 * ring_size * sizeof(uint32_t) + 63) & ~(size_t)63;
+}
+
+static inline uint32_t gv_shm_ring_size(uint32_t nb_slots)
+{
+  uint32_t size = 1;
+  while (size < 2 * nb_slots)
+    size <<= 1;
+  return size;
+}
+
+static inline size_t gv_shm_size(uint32_t nb_slots, uint32_t slot_size)
+{
+  return gv_shm_slots_offset(gv_shm_ring_size(nb_slots)) + 2 * nb_slots * gv_shm_slot_stride(slot_size);
+}
+
+static inline void gv_shm_init(gv_shm_header_t *shm, uint32_t nb_slots, uint32_t slot_size)
+{
+  shm->nb_slots = nb_slots;
+  shm->slot_size = slot_size;
+  shm->ring_size = gv_shm_ring_size(nb_slots);
+  for (int i=0; i<2; i++)
+  {
+    shm->rings[i].head = 0;
+    shm->rings[i].tail = 0;
+    shm->rings[i].waiting = 0;
+  }
+  __atomic_store_n(&shm->magic, GV_SHM_MAGIC, __ATOMIC_RELEASE);
+}
+
+static inline gv_ioreq_desc_t *gv_shm_slot(gv_shm_header_t *shm, uint32_t index)
+{
+  uint32_t slot = (index & ~GV_SHM_SLOT_FABRIC) + (index & GV_SHM_SLOT_FABRIC ? shm->nb_slots : 0);
+  return (gv_ioreq_desc_t *)((uint8_t *)shm + gv_shm_slots_offset(shm->ring_size) + slot * gv_shm_slot_stride(shm->slot_size));
+}
+
+static inline uint32_t gv_shm_slot_index(gv_shm_header_t *shm, gv_ioreq_desc_t *desc)
+{
+  uint32_t slot = ((uint8_t *)desc - ((uint8_t *)shm + gv_shm_slots_offset(shm->ring_size))) / gv_shm_slot_stride(shm->slot_size);
+  return slot >= shm->nb_slots ? (slot - shm->nb_slots) | GV_SHM_SLOT_FABRIC : slot;
+}
+
+static inline uint8_t *gv_shm_slot_data(gv_ioreq_desc_t *desc)
+{
+  return (uint8_t *)(desc + 1);
+}
+
+static inline uint32_t *gv_shm_ring_entries(gv_shm_header_t *shm, int ring)
+{
+  return (uint32_t *)(shm + 1) + ring * shm->ring_size;
+}
+
+// Called by the single producer of the ring, or under a lock if there are
+// several
+static inline void gv_shm_ring_push(gv_shm_header_t *shm, int ring, uint32_t index)
+{
+  gv_shm_ring_t *r = &shm->rings[ring];
+  uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+  gv_shm_ring_entries(shm, ring)[tail & (shm->ring_size - 1)] = index;
+  __atomic_store_n(&r->tail, tail + 1, __ATOMIC_SEQ_CST);
+}
+
+// Wakes the consumer up if it is sleeping, once a batch has been pushed
+static inline void gv_shm_ring_notify(gv_shm_header_t *shm, int ring)
+{
+  gv_shm_ring_t *r = &shm->rings[ring];
+  if (__atomic_load_n(&r->waiting, __ATOMIC_SEQ_CST))
+  {
+    __atomic_store_n(&r->waiting, 0, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &r->tail, FUTEX_WAKE, 1, NULL, NULL, 0);
+  }
+}
+
+// Pops all the available indexes, up to max, without blocking
+static inline int gv_shm_ring_pop(gv_shm_header_t *shm, int ring, uint32_t *indexes, int max)
+{
+  gv_shm_ring_t *r = &shm->rings[ring];
+  uint32_t head = r->head;
+  uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+  int count = 0;
+  uint32_t *entries = gv_shm_ring_entries(shm, ring);
+
+  while (head != tail && count < max)
+  {
+    indexes[count++] = entries[head & (shm->ring_size - 1)];
+    head++;
+  }
+
+  __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+
+  return count;
+}
+
+// Spins for a while and then sleeps until the ring is not empty
+static inline void gv_shm_ring_wait(gv_shm_header_t *shm, int ring)
+{
+  gv_shm_ring_t *r = &shm->rings[ring];
+  uint32_t head = r->head;
+
+  for (int i=0; i<GV_SHM_SPIN; i++)
+  {
+    if (__atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) != head)
+      return;
+  }
+
+  __atomic_store_n(&r->waiting, 1, __ATOMIC_SEQ_CST);
+  uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST);
+  if (tail == head)
+    syscall(SYS_futex, &r->tail, FUTEX_WAIT, tail, NULL, NULL, 0);
+  __atomic_store_n(&r->waiting, 0, __ATOMIC_SEQ_CST);
+}
+
 #endif
\ No newline at end of file
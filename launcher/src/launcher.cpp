@@ -28,9 +28,11 @@
 #include <string.h>
 #include <pthread.h>
 #include <string>
+#include <deque>
 #include <sys/types.h>
 #include <signal.h>
 #include <sys/prctl.h>
+#include <sys/mman.h>
 #include <signal.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -40,6 +42,9 @@ typedef struct {
   char **opts;
   int nb_opt;
   char *config_file;
+  gv_conf_transport_e transport;
+  int shm_nb_slots;
+  int shm_slot_size;
 } gv_launcher_t;
 
 typedef struct {
@@ -50,13 +55,83 @@ typedef struct {
   FILE *snd_file;
   gv_ioreq_request_t callback;
   void *context;
+
+  // Shared-memory transport
+  gv_shm_header_t *shm;
+  // Serializes the producers of the ring to the platform, which are the
+  // requests and the responses to the platform requests
+  pthread_mutex_t shm_lock;
+  // Free slots of the launcher pool
+  pthread_mutex_t slots_lock;
+  pthread_cond_t slots_cond;
+  uint32_t *free_slots;
+  int nb_free_slots;
+  // Requests sent by the callbacks of the binding thread while no slot was
+  // free, which are sent by the same thread once slots are released, as it
+  // is the one releasing them and cannot wait
+  std::deque<struct gv_shm_send_s> *pending_sends;
+
+  // Completions of the vectored requests
+  pthread_mutex_t completions_lock;
+  pthread_cond_t completions_cond;
+  std::deque<gv_ioreq_completion_t> *completions;
 } gv_ioreq_binding_t;
 
+// Request split into several slots, completed once all of them are
+typedef struct {
+  int remaining;
+  gv_ioreq_t user_req;
+} gv_ioreq_split_t;
+
+// Requests are split into chunks of this size on the pipe transport, as the
+// platform side receives each of them at once
+#define GV_IOREQ_PIPE_CHUNK_SIZE (64*1024)
+
+static gv_ioreq_split_t *ioreq_split_new(size_t nb_chunks)
+{
+  gv_ioreq_split_t *split = (gv_ioreq_split_t *)malloc(sizeof(gv_ioreq_split_t));
+  if (split == NULL) return NULL;
+  split->remaining = nb_chunks;
+  split->user_req.state = GV_IOREQ_DONE;
+  split->user_req.latency = 0;
+  return split;
+}
+
+// Accounts the response of a chunk, returns true and the response of the
+// whole request once all chunks are done
+static bool ioreq_split_done(gv_ioreq_split_t *split, gv_ioreq_t *user_req)
+{
+  if (user_req->state == GV_IOREQ_DONE_ERROR) split->user_req.state = GV_IOREQ_DONE_ERROR;
+  if (user_req->latency > split->user_req.latency) split->user_req.latency = user_req->latency;
+  if (--split->remaining != 0) return false;
+  *user_req = split->user_req;
+  free(split);
+  return true;
+}
+
+// Request being sent through the shared-memory transport, one slot after the
+// other
+typedef struct gv_shm_send_s {
+  int64_t timestamp;
+  uint8_t *data;
+  uint64_t addr;
+  size_t size;
+  int is_write;
+  gv_ioreq_response_t callback;
+  void *context;
+  gv_ioreq_split_t *split;
+  size_t nb_chunks;
+  size_t chunk;
+} gv_shm_send_t;
+
 static pid_t child_id = -1;
 
 void gv_init(gv_conf_t *gv_conf)
 {
   gv_conf->timing = GV_CONF_NO_TIMING;
+  gv_conf->transport = GV_CONF_TRANSPORT_PIPE;
+  gv_conf->shm_nb_slots = 256;
+  gv_conf->shm_slot_size = 4096;
 }
 
 static void add_option(gv_launcher_t *gv, char *opt) {
@@ -73,6 +148,9 @@ void *gv_create(gv_conf_t *gv_conf, char *config_file)
   gv->opts = NULL;
   gv->nb_opt = 0;
   gv->config_file = strdup(config_file);
+  gv->transport = gv_conf ? gv_conf->transport : GV_CONF_TRANSPORT_PIPE;
+  gv->shm_nb_slots = gv_conf ? gv_conf->shm_nb_slots : 0;
+  gv->shm_slot_size = gv_conf ? gv_conf->shm_slot_size : 0;
 
   add_option(gv, (char *)"pulp-run");
 
@@ -160,6 +238,8 @@ static void *ioreq_routine(void *arg)
     {
       // Fabric side sent us a response fro a host->fabric request
       if (!req->is_write && fread(req->data, req->size, 1, f) != 1) return NULL;
+      gv_ioreq_split_t *split = (gv_ioreq_split_t *)req->req;
+      if (split != NULL && !ioreq_split_done(split, &req->user_req)) continue;
       if (req->response_cb != NULL) {
         req->response_cb(req->response_context, &req->user_req);
       }
@@ -181,6 +261,187 @@ static void *ioreq_routine(void *arg)
 }
 
 
+// Returns -1 if no slot is free and wait is false
+static int64_t shm_slot_alloc(gv_ioreq_binding_t *binding, bool wait)
+{
+  pthread_mutex_lock(&binding->slots_lock);
+  while (binding->nb_free_slots == 0)
+  {
+    if (!wait)
+    {
+      pthread_mutex_unlock(&binding->slots_lock);
+      return -1;
+    }
+
+    // The requests already pushed must be seen by the platform for slots to
+    // come back
+    gv_shm_ring_notify(binding->shm, GV_SHM_TO_FABRIC);
+    pthread_cond_wait(&binding->slots_cond, &binding->slots_lock);
+  }
+  uint32_t index = binding->free_slots[--binding->nb_free_slots];
+  pthread_mutex_unlock(&binding->slots_lock);
+  return index;
+}
+
+static void shm_slot_free(gv_ioreq_binding_t *binding, uint32_t index)
+{
+  pthread_mutex_lock(&binding->slots_lock);
+  binding->free_slots[binding->nb_free_slots++] = index;
+  pthread_cond_signal(&binding->slots_cond);
+  pthread_mutex_unlock(&binding->slots_lock);
+}
+
+static void shm_push(gv_ioreq_binding_t *binding, uint32_t index)
+{
+  pthread_mutex_lock(&binding->shm_lock);
+  gv_shm_ring_push(binding->shm, GV_SHM_TO_FABRIC, index);
+  pthread_mutex_unlock(&binding->shm_lock);
+}
+
+// Pushes the remaining slots of the request, returns false if it had to stop
+// because no slot was free
+static bool shm_send_chunks(gv_ioreq_binding_t *binding, gv_shm_send_t *send, bool wait)
+{
+  gv_shm_header_t *shm = binding->shm;
+
+  for (; send->chunk<send->nb_chunks; send->chunk++)
+  {
+    size_t offset = send->chunk * shm->slot_size;
+    size_t chunk_size = send->size - offset < shm->slot_size ? send->size - offset : shm->slot_size;
+
+    int64_t index = shm_slot_alloc(binding, wait);
+    if (index == -1) return false;
+
+    gv_ioreq_desc_t *desc = gv_shm_slot(shm, index);
+
+    desc->type = GV_IOREQ_DESC_TYPE_REQUEST;
+    desc->addr = send->addr + offset;
+    desc->size = chunk_size;
+    desc->is_write = send->is_write;
+    desc->timestamp = send->timestamp;
+    desc->response_cb = send->callback;
+    desc->response_context = send->context;
+    desc->binding = (void *)binding;
+    desc->req = (void *)send->split;
+    desc->data = send->data + offset;
+
+    if (send->is_write) memcpy(gv_shm_slot_data(desc), desc->data, chunk_size);
+
+    shm_push(binding, index);
+  }
+
+  return true;
+}
+
+// Sends the requests which were waiting for free slots, from the binding
+// thread
+static void shm_send_pending(gv_ioreq_binding_t *binding)
+{
+  std::deque<gv_shm_send_t> *pending = binding->pending_sends;
+
+  if (pending->empty()) return;
+
+  while (!pending->empty() && shm_send_chunks(binding, &pending->front(), false))
+    pending->pop_front();
+
+  gv_shm_ring_notify(binding->shm, GV_SHM_TO_FABRIC);
+}
+
+static void ioreq_shm_response(void *context, gv_ioreq_t *req)
+{
+  gv_ioreq_desc_t *desc = (gv_ioreq_desc_t *)context;
+  gv_ioreq_binding_t *binding = (gv_ioreq_binding_t *)desc->binding;
+  desc->type = GV_IOREQ_DESC_TYPE_RESPONSE;
+  desc->latency = req->latency;
+  desc->timestamp += req->latency;
+  shm_push(binding, gv_shm_slot_index(binding->shm, desc));
+  gv_shm_ring_notify(binding->shm, GV_SHM_TO_FABRIC);
+}
+
+static void *ioreq_shm_routine(void *arg)
+{
+  gv_ioreq_binding_t *binding = (gv_ioreq_binding_t *)arg;
+  gv_shm_header_t *shm = binding->shm;
+  uint32_t indexes[64];
+
+  while(1) {
+    int count = gv_shm_ring_pop(shm, GV_SHM_TO_HOST, indexes, 64);
+    if (count == 0)
+    {
+      gv_shm_ring_wait(shm, GV_SHM_TO_HOST);
+      continue;
+    }
+
+    for (int i=0; i<count; i++)
+    {
+      gv_ioreq_desc_t *desc = gv_shm_slot(shm, indexes[i]);
+
+      if (indexes[i] & GV_SHM_SLOT_FABRIC)
+      {
+        // Request from the platform, whose payload is accessed in place
+        if (binding->callback != NULL) {
+          binding->callback(binding->context, (void *)gv_shm_slot_data(desc), (void *)desc->addr, desc->size, desc->is_write,
+            ioreq_shm_response, (void *)desc);
+        } else {
+          gv_ioreq_t req = { .state=GV_IOREQ_DONE_ERROR, .latency=0 };
+          ioreq_shm_response((void *)desc, &req);
+        }
+      }
+      else
+      {
+        // Response to one of our requests, the slot is released before the
+        // callback so that it can send new requests
+        if (!desc->is_write) memcpy(desc->data, gv_shm_slot_data(desc), desc->size);
+
+        gv_ioreq_response_t callback = desc->response_cb;
+        void *callback_context = desc->response_context;
+        gv_ioreq_split_t *split = (gv_ioreq_split_t *)desc->req;
+        gv_ioreq_t user_req = desc->user_req;
+
+        shm_slot_free(binding, indexes[i]);
+
+        if (split != NULL && !ioreq_split_done(split, &user_req)) continue;
+
+        if (callback != NULL) {
+          callback(callback_context, &user_req);
+        }
+      }
+    }
+
+    shm_send_pending(binding);
+  }
+}
+
+static int shm_binding_init(gv_ioreq_binding_t *binding, gv_launcher_t *gv, int *fd)
+{
+  size_t size = gv_shm_size(gv->shm_nb_slots, gv->shm_slot_size);
+
+  *fd = memfd_create("gvsoc-ioreq", 0);
+  if (*fd == -1) return -1;
+  if (ftruncate(*fd, size) == -1) return -1;
+
+  binding->shm = (gv_shm_header_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+  if (binding->shm == MAP_FAILED) return -1;
+
+  binding->free_slots = (uint32_t *)malloc(sizeof(uint32_t) * gv->shm_nb_slots);
+  if (binding->free_slots == NULL) return -1;
+  for (int i=0; i<gv->shm_nb_slots; i++)
+  {
+    binding->free_slots[i] = i;
+  }
+  binding->nb_free_slots = gv->shm_nb_slots;
+
+  binding->pending_sends = new std::deque<gv_shm_send_t>;
+
+  pthread_mutex_init(&binding->shm_lock, NULL);
+  pthread_mutex_init(&binding->slots_lock, NULL);
+  pthread_cond_init(&binding->slots_cond, NULL);
+
+  gv_shm_init(binding->shm, gv->shm_nb_slots, gv->shm_slot_size);
+
+  return 0;
+}
+
 void *gv_ioreq_binding(void *handle, char *path, void *base, size_t size, gv_ioreq_request_t callback, void *context)
 {
   gv_launcher_t *gv = (gv_launcher_t *)handle;
@@ -190,15 +451,35 @@ void *gv_ioreq_binding(void *handle, char *path, void *base, size_t size, gv_ior
 
   binding->callback = callback;
   binding->context = context;
+  binding->shm = NULL;
+  binding->snd_file = NULL;
+  binding->gv = (gv_launcher_t *)handle;
 
-  if(pipe(binding->snd_pipe) == -1) return NULL;
-  if(pipe(binding->rcv_pipe) == -1) return NULL;
+  pthread_mutex_init(&binding->completions_lock, NULL);
+  pthread_cond_init(&binding->completions_cond, NULL);
+  binding->completions = new std::deque<gv_ioreq_completion_t>;
 
-  std::string str = "--config-opt=**/" + std::string(path) + "/rcv_fd=" + std::to_string(binding->snd_pipe[0]);
-  add_option(gv, strdup((char *)str.c_str()));
+  std::string str;
 
-  str = "--config-opt=**/" + std::string(path) + "/snd_fd=" + std::to_string(binding->rcv_pipe[1]);
-  add_option(gv, strdup((char *)str.c_str()));
+  if (gv->transport == GV_CONF_TRANSPORT_SHM)
+  {
+    int fd;
+    if (shm_binding_init(binding, gv, &fd)) return NULL;
+
+    str = "--config-opt=**/" + std::string(path) + "/shm_fd=" + std::to_string(fd);
+    add_option(gv, strdup((char *)str.c_str()));
+  }
+  else
+  {
+    if(pipe(binding->snd_pipe) == -1) return NULL;
+    if(pipe(binding->rcv_pipe) == -1) return NULL;
+
+    str = "--config-opt=**/" + std::string(path) + "/rcv_fd=" + std::to_string(binding->snd_pipe[0]);
+    add_option(gv, strdup((char *)str.c_str()));
+
+    str = "--config-opt=**/" + std::string(path) + "/snd_fd=" + std::to_string(binding->rcv_pipe[1]);
+    add_option(gv, strdup((char *)str.c_str()));
+  }
 
   str = "--config-opt=**/" + std::string(path) + "/external_binding/base=" + std::to_string((int64_t)base);
   add_option(gv, strdup((char *)str.c_str()));
@@ -209,27 +490,279 @@ void *gv_ioreq_binding(void *handle, char *path, void *base, size_t size, gv_ior
   str = "--config-opt=**/" + std::string(path) + "/context=" + std::to_string((int64_t)binding);
   add_option(gv, strdup((char *)str.c_str()));
 
-  binding->gv = (gv_launcher_t *)handle;
-  binding->snd_file = fdopen(binding->snd_pipe[1], "w");
-  if (binding->snd_file == NULL) return NULL;
+  if (binding->shm)
+  {
+    pthread_create(&binding->thread, NULL, ioreq_shm_routine, (void *)binding);
+  }
+  else
+  {
+    binding->snd_file = fdopen(binding->snd_pipe[1], "w");
+    if (binding->snd_file == NULL) return NULL;
 
-  pthread_create(&binding->thread, NULL, ioreq_routine, (void *)binding);
+    pthread_create(&binding->thread, NULL, ioreq_routine, (void *)binding);
+  }
   
   return (gv_ioreq_binding_t *)binding;
 }
 
+// Sends a request, which the platform only sees after ioreq_flush, so that
+// batches of requests are sent at once
+static int ioreq_send_shm(gv_ioreq_binding_t *binding, int64_t timestamp, void *data, void *addr, size_t size, int is_write, gv_ioreq_response_t callback, void *context)
+{
+  gv_shm_header_t *shm = binding->shm;
+  size_t nb_chunks = size == 0 ? 1 : (size + shm->slot_size - 1) / shm->slot_size;
+  gv_ioreq_split_t *split = NULL;
+
+  if (nb_chunks > 1)
+  {
+    split = ioreq_split_new(nb_chunks);
+    if (split == NULL) return -1;
+  }
+
+  gv_shm_send_t send = { .timestamp=timestamp, .data=(uint8_t *)data, .addr=(uint64_t)addr, .size=size,
+    .is_write=is_write, .callback=callback, .context=context, .split=split, .nb_chunks=nb_chunks, .chunk=0
+  };
+
+  // The binding thread is the one releasing the slots, so it cannot wait for
+  // them, and its requests are queued instead, in order
+  if (pthread_equal(pthread_self(), binding->thread))
+  {
+    if (!binding->pending_sends->empty() || !shm_send_chunks(binding, &send, false))
+      binding->pending_sends->push_back(send);
+    return 0;
+  }
+
+  shm_send_chunks(binding, &send, true);
+
+  return 0;
+}
+
+static int ioreq_send(gv_ioreq_binding_t *binding, int64_t timestamp, void *data, void *addr, size_t size, int is_write, gv_ioreq_response_t callback, void *context)
+{
+  if (binding->shm)
+    return ioreq_send_shm(binding, timestamp, data, addr, size, is_write, callback, context);
+
+  size_t nb_chunks = size == 0 ? 1 : (size + GV_IOREQ_PIPE_CHUNK_SIZE - 1) / GV_IOREQ_PIPE_CHUNK_SIZE;
+  gv_ioreq_split_t *split = NULL;
+
+  if (nb_chunks > 1)
+  {
+    split = ioreq_split_new(nb_chunks);
+    if (split == NULL) return -1;
+  }
+
+  size_t offset = 0;
+  for (size_t chunk=0; chunk<nb_chunks; chunk++)
+  {
+    size_t chunk_size = size - offset < GV_IOREQ_PIPE_CHUNK_SIZE ? size - offset : GV_IOREQ_PIPE_CHUNK_SIZE;
+
+    gv_ioreq_desc_t desc = { .type=GV_IOREQ_DESC_TYPE_REQUEST, .addr=(uint64_t)addr + offset, .size=(uint64_t)chunk_size,
+      .is_write=(int64_t)is_write, .timestamp=timestamp, .response_cb=callback, .response_context=context
+    };
+    desc.data = (uint8_t *)data + offset;
+    desc.req = (void *)split;
+
+    // The pipe is broken at this point, the chunks already sent never get
+    // their response and the split can be freed
+    if (fwrite((void *)&desc, sizeof(desc), 1, binding->snd_file) != 1 ||
+      (is_write && fwrite(desc.data, chunk_size, 1, binding->snd_file) != 1))
+    {
+      free(split);
+      return -1;
+    }
+
+    offset += chunk_size;
+  }
+
+  return 0;
+}
+
+static void ioreq_flush(gv_ioreq_binding_t *binding)
+{
+  if (binding->shm)
+    gv_shm_ring_notify(binding->shm, GV_SHM_TO_FABRIC);
+  else
+    fflush(binding->snd_file);
+}
+
 int gv_ioreq(void *_binding, int64_t timestamp, void *data, void *addr, size_t size, int is_write, gv_ioreq_response_t callback, void *context)
 {
   gv_ioreq_binding_t *binding = (gv_ioreq_binding_t *)_binding;
 
-  gv_ioreq_desc_t desc = { .type=GV_IOREQ_DESC_TYPE_REQUEST, .addr=(uint64_t)addr, .size=(uint64_t)size, .is_write=(int64_t)is_write, .timestamp=timestamp,
-    .response_cb=callback, .response_context=context
-  };
-  desc.data = data;
-  if (fwrite((void *)&desc, sizeof(desc), 1, binding->snd_file) != 1) return -1;
-  if (is_write && fwrite(data, size, 1, binding->snd_file) != 1) return -1;
+  if (ioreq_send(binding, timestamp, data, addr, size, is_write, callback, context)) return -1;
 
-  fflush(binding->snd_file);
+  ioreq_flush(binding);
 
   return 0;
 }
+
+
+// Vectored request, completed once the requests of all its buffers are
+typedef struct {
+  gv_ioreq_binding_t *binding;
+  int remaining;
+  // Set by the binding thread and by the submitting thread, and only copied
+  // to the completion when it is done
+  int error;
+  gv_ioreq_completion_t completion;
+} gv_ioreq_vec_state_t;
+
+static void ioreq_complete(gv_ioreq_binding_t *binding, gv_ioreq_vec_state_t *state)
+{
+  gv_ioreq_completion_t *completion = &state->completion;
+  completion->state = __atomic_load_n(&state->error, __ATOMIC_SEQ_CST) ? GV_IOREQ_DONE_ERROR : GV_IOREQ_DONE;
+
+  pthread_mutex_lock(&binding->completions_lock);
+  binding->completions->push_back(*completion);
+  pthread_cond_broadcast(&binding->completions_cond);
+  pthread_mutex_unlock(&binding->completions_lock);
+}
+
+static void ioreq_vec_response(void *context, gv_ioreq_t *req)
+{
+  gv_ioreq_vec_state_t *state = (gv_ioreq_vec_state_t *)context;
+
+  if (req->state == GV_IOREQ_DONE_ERROR) __atomic_store_n(&state->error, 1, __ATOMIC_SEQ_CST);
+  if (req->latency > state->completion.latency) state->completion.latency = req->latency;
+
+  if (__atomic_sub_fetch(&state->remaining, 1, __ATOMIC_SEQ_CST) == 0)
+  {
+    ioreq_complete(state->binding, state);
+    free(state);
+  }
+}
+
+int gv_ioreq_submit(void *_binding, const gv_ioreq_vec_t *reqs, int nb_reqs)
+{
+  gv_ioreq_binding_t *binding = (gv_ioreq_binding_t *)_binding;
+  int submitted = 0;
+
+  for (; submitted<nb_reqs; submitted++)
+  {
+    const gv_ioreq_vec_t *req = &reqs[submitted];
+    int nb_buffers = req->iovcnt > 0 ? req->iovcnt : 1;
+
+    gv_ioreq_vec_state_t *state = (gv_ioreq_vec_state_t *)malloc(sizeof(gv_ioreq_vec_state_t));
+    if (state == NULL) break;
+
+    state->binding = binding;
+    state->remaining = nb_buffers;
+    state->error = 0;
+    state->completion.tag = req->tag;
+    state->completion.state = GV_IOREQ_DONE;
+    state->completion.latency = 0;
+
+    // The buffers are consecutive in the platform
+    uint64_t addr = req->addr;
+    int sent = 0;
+    for (; sent<nb_buffers; sent++)
+    {
+      void *data = req->iovcnt > 0 ? req->iov[sent].data : NULL;
+      size_t size = req->iovcnt > 0 ? req->iov[sent].size : 0;
+      if (ioreq_send(binding, req->timestamp, data, (void *)addr, size, req->is_write, ioreq_vec_response, (void *)state)) break;
+      addr += size;
+    }
+
+    if (sent == nb_buffers) continue;
+
+    // The buffers which could not be sent are accounted as done with an
+    // error, so that the request completes with the ones already sent
+    __atomic_store_n(&state->error, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_sub_fetch(&state->remaining, nb_buffers - sent, __ATOMIC_SEQ_CST) == 0)
+    {
+      if (sent != 0)
+        ioreq_complete(binding, state);
+      free(state);
+    }
+
+    if (sent != 0)
+      submitted++;
+
+    break;
+  }
+
+  ioreq_flush(binding);
+
+  return submitted;
+}
+
+static int ioreq_get_completions(gv_ioreq_binding_t *binding, gv_ioreq_completion_t *completions, int min, int max)
+{
+  pthread_mutex_lock(&binding->completions_lock);
+
+  while ((int)binding->completions->size() < min)
+    pthread_cond_wait(&binding->completions_cond, &binding->completions_lock);
+
+  int count = 0;
+  while (count < max && !binding->completions->empty())
+  {
+    completions[count++] = binding->completions->front();
+    binding->completions->pop_front();
+  }
+
+  pthread_mutex_unlock(&binding->completions_lock);
+
+  return count;
+}
+
+int gv_ioreq_poll(void *binding, gv_ioreq_completion_t *completions, int max)
+{
+  return ioreq_get_completions((gv_ioreq_binding_t *)binding, completions, 0, max);
+}
+
+int gv_ioreq_wait(void *binding, gv_ioreq_completion_t *completions, int min, int max)
+{
+  return ioreq_get_completions((gv_ioreq_binding_t *)binding, completions, min < max ? min : max, max);
+}
+
+
+// Bulk requests are sent at once and split by the transport, and their
+// completion is waited for separately from the vectored requests
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  bool done;
+  gv_ioreq_state_e state;
+} gv_ioreq_bulk_t;
+
+static void ioreq_bulk_response(void *context, gv_ioreq_t *req)
+{
+  gv_ioreq_bulk_t *bulk = (gv_ioreq_bulk_t *)context;
+  pthread_mutex_lock(&bulk->lock);
+  bulk->done = true;
+  bulk->state = req->state;
+  pthread_cond_signal(&bulk->cond);
+  pthread_mutex_unlock(&bulk->lock);
+}
+
+static int ioreq_bulk(gv_ioreq_binding_t *binding, void *addr, void *data, size_t size, int is_write)
+{
+  gv_ioreq_bulk_t bulk;
+  pthread_mutex_init(&bulk.lock, NULL);
+  pthread_cond_init(&bulk.cond, NULL);
+  bulk.done = false;
+  bulk.state = GV_IOREQ_DONE_ERROR;
+
+  if (ioreq_send(binding, 0, data, addr, size, is_write, ioreq_bulk_response, (void *)&bulk)) return -1;
+  ioreq_flush(binding);
+
+  pthread_mutex_lock(&bulk.lock);
+  while (!bulk.done)
+    pthread_cond_wait(&bulk.cond, &bulk.lock);
+  pthread_mutex_unlock(&bulk.lock);
+
+  pthread_mutex_destroy(&bulk.lock);
+  pthread_cond_destroy(&bulk.cond);
+
+  return bulk.state == GV_IOREQ_DONE ? 0 : -1;
+}
+
+int gv_ioreq_load(void *binding, void *addr, const void *data, size_t size)
+{
+  return ioreq_bulk((gv_ioreq_binding_t *)binding, addr, (void *)data, size, 1);
+}
+
+int gv_ioreq_dump(void *binding, void *addr, void *data, size_t size)
+{
+  return ioreq_bulk((gv_ioreq_binding_t *)binding, addr, data, size, 0);
+}
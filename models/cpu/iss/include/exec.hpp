@@ -109,7 +109,11 @@ static inline int iss_exec_step(iss_t *iss)
 
 static inline int iss_exec_switch_to_fast(iss_t *iss)
 {
-#ifdef VP_TRACE_ACTIVE
+#if defined(VP_TRACE_RUNTIME)
+  if (iss_trace_active(iss))
+    return false;
+  return !iss->cpu.state.hw_counter_en && !(iss->cpu.csr.pcmr & CSR_PCMR_ACTIVE) && !iss->cpu.csr.stack_conf;
+#elif defined(VP_TRACE_ACTIVE)
   return false;
 #else
   return !iss->cpu.state.hw_counter_en && !(iss->cpu.csr.pcmr & CSR_PCMR_ACTIVE) && !iss->cpu.csr.stack_conf;
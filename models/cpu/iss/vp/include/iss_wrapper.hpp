@@ -25,6 +25,11 @@
 #include <vp/itf/io.hpp>
 #include <vp/itf/wire.hpp>
 
+// Phases of the sampled simulation
+#define SAMPLING_FAST_FORWARD 0
+#define SAMPLING_WARMUP       1
+#define SAMPLING_DETAILED     2
+
 #ifdef USE_TRDB
 #define HAVE_DECL_BASENAME 1
 #include "trace_debugger.h"
@@ -41,6 +46,7 @@ public:
   void start();
   void pre_reset();
   void reset(bool active);
+  void stop();
 
   static void data_grant(void *_this, vp::io_req *req);
   static void data_response(void *_this, vp::io_req *req);
@@ -52,6 +58,7 @@ public:
   static void exec_first_instr(void *__this, vp::clock_event *event);
   void exec_first_instr(vp::clock_event *event);
   static void exec_instr_check_all(void *__this, vp::clock_event *event);
+  static void exec_instr_sampled(void *__this, vp::clock_event *event);
   static inline void exec_misaligned(void *__this, vp::clock_event *event);
 
   static void irq_req_sync(void *__this, int irq);
@@ -70,6 +77,10 @@ public:
 
   void dump_debug_traces();
 
+  void save(vp::checkpoint *checkpoint);
+  void restore(vp::checkpoint *checkpoint);
+  void post_restore();
+
   inline void trigger_check_all() { current_event = check_all_event; }
 
   vp::io_master data;
@@ -114,6 +125,7 @@ public:
   vp::trace     line_trace_event;
   vp::trace     file_trace_event;
   vp::trace     pcer_trace_event[32];
+  vp::stat_scalar pcer_stats[16];
   vp::trace     insn_trace_event;
   vp::trace     misaligned_req_event;
   
@@ -140,6 +152,28 @@ private:
   iss_reg_t ppc;
   iss_reg_t npc;
 
+  // Sampled simulation. The core alternates between functional
+  // fast-forward, where instructions are executed in batch and take one
+  // cycle, and detailed windows preceded by a warm-up, whose CPI is used to
+  // extrapolate the cycles of the whole interval they represent.
+  bool          sampling = false;
+  bool          sampling_magic;
+  iss_opcode_t  sampling_magic_opcode;
+  int           sampling_phase;
+  int64_t       sampling_fast_forward;
+  int64_t       sampling_warmup;
+  int64_t       sampling_window;
+  int64_t       sampling_batch;
+  int64_t       sampling_insns;
+  int64_t       sampling_phase_end;
+  int64_t       sampling_interval_start;
+  int64_t       sampling_window_insn;
+  int64_t       sampling_window_cycles;
+  int           sampling_nb_windows;
+  double        sampling_cpi;
+  double        sampling_projected_cycles;
+  FILE         *sampling_file;
+
   int        misaligned_size;
   uint8_t   *misaligned_data;
   iss_addr_t misaligned_addr;
@@ -151,13 +185,33 @@ private:
   vp::wire_slave<bool>     halt_itf;
   vp::wire_master<bool>     halt_status_itf;
 
+  void save_insn(vp::checkpoint *checkpoint, iss_insn_t *insn);
+  iss_insn_t *restore_insn(vp::checkpoint *checkpoint);
+
   static void bootaddr_sync(void *_this, uint32_t value);
   static void fetchen_sync(void *_this, bool active);
   static void halt_sync(void *_this, bool active);
   inline void enqueue_next_instr(int64_t cycles);
   void halt_core();
+
+  void sampling_init();
+  int sampling_exec_functional(vp::clock_event *event, int64_t *nb_insns);
+  inline void sampling_account(int64_t nb_insns);
+  void sampling_next_phase();
+  void sampling_enter_phase(int phase, int64_t nb_insns);
 };
 \
+inline void iss_wrapper::sampling_account(int64_t nb_insns)
+{
+  this->sampling_insns += nb_insns;
+
+  if (this->sampling_insns >= this->sampling_phase_end ||
+    (this->sampling_magic && this->cpu.prev_insn && this->cpu.prev_insn->opcode == this->sampling_magic_opcode))
+  {
+    this->sampling_next_phase();
+  }
+}
+
 inline void iss_wrapper::enqueue_next_instr(int64_t cycles)
 {
   if (is_active_reg.get())
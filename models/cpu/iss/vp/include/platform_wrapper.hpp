@@ -76,6 +76,13 @@ static inline bool iss_insn_trace_active(iss_t *iss)
   return iss->insn_trace.get_active();
 }
 
+// Whether the core has traces enabled, which are only dumped by the slow
+// instruction handler
+static inline bool iss_trace_active(iss_t *iss)
+{
+  return iss->trace.get_active() || iss->insn_trace.get_active() || iss->insn_trace_event.get_event_active();
+}
+
 static bool iss_csr_ext_counter_is_bound(iss_t *iss, int id)
 {
   return iss->ext_counter[id].is_bound();
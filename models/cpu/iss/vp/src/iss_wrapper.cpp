@@ -65,6 +65,20 @@ static inline void trdb_record_instruction(iss_wrapper *_this, iss_insn_t *insn)
 #endif
 
 
+#define EXEC_INSTR_STALL(_this) \
+do { \
+  if (_this->misaligned_access.get()) \
+  { \
+    _this->event_enqueue(_this->misaligned_event, _this->misaligned_latency); \
+  } \
+  else \
+  { \
+    _this->is_active_reg.set(false); \
+    _this->stalled.set(true);     \
+  } \
+} while(0)
+
+
 #define EXEC_INSTR_COMMON(_this, event, func) \
 do { \
   \
@@ -91,15 +105,7 @@ do { \
   } \
   else \
   { \
-    if (_this->misaligned_access.get()) \
-    { \
-      _this->event_enqueue(_this->misaligned_event, _this->misaligned_latency); \
-    } \
-    else \
-    { \
-      _this->is_active_reg.set(false); \
-      _this->stalled.set(true);     \
-    } \
+    EXEC_INSTR_STALL(_this); \
   } \
 } while(0)
 
@@ -136,6 +142,10 @@ void iss_wrapper::exec_instr_check_all(void *__this, vp::clock_event *event)
   }
 
   EXEC_INSTR_COMMON(_this, event, iss_exec_step_nofetch_perf);
+  if (_this->sampling)
+  {
+    _this->sampling_account(1);
+  }
   if (_this->step_mode.get())
   {
     _this->do_step.set(false);
@@ -145,11 +155,38 @@ void iss_wrapper::exec_instr_check_all(void *__this, vp::clock_event *event)
   }
 }
 
+void iss_wrapper::exec_instr_sampled(void *__this, vp::clock_event *event)
+{
+  iss_t *_this = (iss_t *)__this;
+
+  if (_this->sampling_phase != SAMPLING_FAST_FORWARD)
+  {
+    EXEC_INSTR_COMMON(_this, event, iss_exec_step_nofetch);
+    _this->sampling_account(1);
+  }
+  else
+  {
+    int64_t nb_insns;
+    int cycles = _this->sampling_exec_functional(event, &nb_insns);
+
+    _this->sampling_account(nb_insns);
+
+    if (cycles >= 0)
+    {
+      _this->enqueue_next_instr(cycles);
+    }
+    else
+    {
+      EXEC_INSTR_STALL(_this);
+    }
+  }
+}
+
 void iss_wrapper::exec_first_instr(vp::clock_event *event)
 {
-  current_event = event_new(iss_wrapper::exec_instr);
+  current_event = event_new(this->sampling ? iss_wrapper::exec_instr_sampled : iss_wrapper::exec_instr);
   iss_start(this);
-  exec_instr((void *)this, event);
+  (this->sampling ? exec_instr_sampled : exec_instr)((void *)this, event);
 }
 
 void iss_wrapper::exec_first_instr(void *__this, vp::clock_event *event)
@@ -540,6 +577,17 @@ int iss_wrapper::build()
   traces.new_trace_event("pcer_st_ext_cycles", &pcer_trace_event[14], 1);
   traces.new_trace_event("pcer_tcdm_cont", &pcer_trace_event[15], 1);
 
+  // The counters are already maintained by the core for the PCCR CSRs, so
+  // the stats just read them when they are dumped
+  static const char *pcer_names[] = { "cycles", "instr", "ld_stall", "jmp_stall", "imiss",
+    "ld", "st", "jump", "branch", "taken_branch", "rvc", "ld_ext", "st_ext",
+    "ld_ext_cycles", "st_ext_cycles", "tcdm_cont" };
+  for (int i=0; i<16; i++)
+  {
+    this->pcer_stats[i].set_sampler([this, i]() { return (int64_t)this->cpu.csr.pccr[i]; });
+    stats.new_stat(std::string("pcer_") + pcer_names[i], &this->pcer_stats[i]);
+  }
+
   power.new_trace("power_trace", &power_trace);
 
   this->new_reg("bootaddr", &this->bootaddr_reg, get_config_int("boot_addr"));
@@ -552,9 +600,9 @@ int iss_wrapper::build()
   this->new_reg("step_mode", &this->step_mode, false);
   this->new_reg("do_step", &this->do_step, false);
 
-  power.new_event("power_insn", &insn_power, this->get_js_config()->get("**/insn"), &power_trace);
-  power.new_event("power_clock_gated", &clock_gated_power, this->get_js_config()->get("**/clock_gated"), &power_trace);
-  power.new_leakage_event("leakage", &leakage_power, this->get_js_config()->get("**/leakage"), &power_trace);
+  power.new_event("power_insn", &insn_power, this->get_js_config("**/insn"), &power_trace);
+  power.new_event("power_clock_gated", &clock_gated_power, this->get_js_config("**/clock_gated"), &power_trace);
+  power.new_leakage_event("leakage", &leakage_power, this->get_js_config("**/leakage"), &power_trace);
 
   data.set_resp_meth(&iss_wrapper::data_response);
   data.set_grant_meth(&iss_wrapper::data_grant);
@@ -587,8 +635,10 @@ int iss_wrapper::build()
     new_master_port("ext_counter[" + std::to_string(i) + "]", &ext_counter[i]);
   }
 
+  this->sampling_init();
+
   current_event = event_new(iss_wrapper::exec_first_instr);
-  instr_event = event_new(iss_wrapper::exec_instr);
+  instr_event = event_new(this->sampling ? iss_wrapper::exec_instr_sampled : iss_wrapper::exec_instr);
   check_all_event = event_new(iss_wrapper::exec_instr_check_all);
   misaligned_event = event_new(iss_wrapper::exec_misaligned);
 
@@ -614,7 +664,7 @@ void iss_wrapper::start()
 
   if (iss_open(this)) throw logic_error("Error while instantiating the ISS");
 
-  for (auto x:this->get_js_config()->get("**/debug_binaries")->get_elems())
+  for (auto x:this->get_js_config("**/debug_binaries")->get_elems())
   {
     iss_register_debug_info(this, x->get_str().c_str());
   }
@@ -663,6 +713,300 @@ void iss_wrapper::reset(bool active)
 }
 
 
+// Instructions are saved as their address as the decode cache is not saved.
+// They are allocated again in the cache when restored, and decoded when
+// executed.
+void iss_wrapper::save_insn(vp::checkpoint *checkpoint, iss_insn_t *insn)
+{
+  checkpoint->write<uint8_t>(insn != NULL);
+  checkpoint->write<uint64_t>(insn ? insn->addr : 0);
+}
+
+iss_insn_t *iss_wrapper::restore_insn(vp::checkpoint *checkpoint)
+{
+  bool valid = checkpoint->read<uint8_t>();
+  iss_addr_t addr = checkpoint->read<uint64_t>();
+  return valid ? insn_cache_get(this, addr) : NULL;
+}
+
+void iss_wrapper::save(vp::checkpoint *checkpoint)
+{
+  checkpoint->write(&this->cpu.regfile, sizeof(this->cpu.regfile));
+  checkpoint->write(&this->cpu.csr, sizeof(this->cpu.csr));
+  checkpoint->write(&this->cpu.pulpv2, sizeof(this->cpu.pulpv2));
+
+  checkpoint->write<uint64_t>(this->cpu.state.bootaddr);
+  checkpoint->write<int32_t>(this->cpu.state.insn_cycles);
+  checkpoint->write<int32_t>(this->cpu.state.saved_insn_cycles);
+  checkpoint->write<int32_t>(this->cpu.state.hw_counter_en);
+  checkpoint->write<uint64_t>(this->cpu.state.vf0);
+  checkpoint->write<uint64_t>(this->cpu.state.vf1);
+  checkpoint->write<uint64_t>(this->cpu.state.fcsr.raw);
+
+  checkpoint->write<int32_t>(this->cpu.irq.irq_enable);
+  checkpoint->write<int32_t>(this->cpu.irq.saved_irq_enable);
+  checkpoint->write<int32_t>(this->cpu.irq.req_irq);
+
+  this->save_insn(checkpoint, this->cpu.current_insn);
+  this->save_insn(checkpoint, this->cpu.prev_insn);
+  this->save_insn(checkpoint, this->cpu.stall_insn);
+  this->save_insn(checkpoint, this->cpu.state.elw_insn);
+  for (int i=0; i<2; i++)
+  {
+    this->save_insn(checkpoint, this->cpu.state.hwloop_start_insn[i]);
+  }
+  for (int i=0; i<35; i++)
+  {
+    this->save_insn(checkpoint, this->cpu.irq.vectors[i]);
+  }
+
+  checkpoint->write<int32_t>(this->irq_req);
+  checkpoint->write<int32_t>(this->halt_cause);
+  checkpoint->write<int64_t>(this->wakeup_latency);
+  checkpoint->write<uint64_t>(this->hit_reg);
+  checkpoint->write<uint64_t>(this->ppc);
+  checkpoint->write<uint64_t>(this->npc);
+
+  // The instruction event is allocated when the first instruction is
+  // executed, so the current one is saved as its index, and the number of
+  // events tells if the first instruction was executed
+  checkpoint->write<uint32_t>(this->events.size());
+  checkpoint->write<uint32_t>(std::find(this->events.begin(), this->events.end(), this->current_event) - this->events.begin());
+}
+
+void iss_wrapper::restore(vp::checkpoint *checkpoint)
+{
+  checkpoint->read(&this->cpu.regfile, sizeof(this->cpu.regfile));
+  checkpoint->read(&this->cpu.csr, sizeof(this->cpu.csr));
+  checkpoint->read(&this->cpu.pulpv2, sizeof(this->cpu.pulpv2));
+
+  this->cpu.state.bootaddr = checkpoint->read<uint64_t>();
+  this->cpu.state.insn_cycles = checkpoint->read<int32_t>();
+  this->cpu.state.saved_insn_cycles = checkpoint->read<int32_t>();
+  this->cpu.state.hw_counter_en = checkpoint->read<int32_t>();
+  this->cpu.state.vf0 = checkpoint->read<uint64_t>();
+  this->cpu.state.vf1 = checkpoint->read<uint64_t>();
+  this->cpu.state.fcsr.raw = checkpoint->read<uint64_t>();
+
+  this->cpu.irq.irq_enable = checkpoint->read<int32_t>();
+  this->cpu.irq.saved_irq_enable = checkpoint->read<int32_t>();
+  this->cpu.irq.req_irq = checkpoint->read<int32_t>();
+
+  // The decode cache may contain instructions decoded from the memory
+  // content before the restore
+  this->cpu.current_insn = NULL;
+  iss_cache_flush(this);
+
+  this->cpu.current_insn = this->restore_insn(checkpoint);
+  this->cpu.prev_insn = this->restore_insn(checkpoint);
+  this->cpu.stall_insn = this->restore_insn(checkpoint);
+  this->cpu.state.elw_insn = this->restore_insn(checkpoint);
+  for (int i=0; i<2; i++)
+  {
+    this->cpu.state.hwloop_start_insn[i] = this->restore_insn(checkpoint);
+  }
+  for (int i=0; i<35; i++)
+  {
+    this->cpu.irq.vectors[i] = this->restore_insn(checkpoint);
+  }
+
+  this->irq_req = checkpoint->read<int32_t>();
+  this->halt_cause = checkpoint->read<int32_t>();
+  this->wakeup_latency = checkpoint->read<int64_t>();
+  this->hit_reg = checkpoint->read<uint64_t>();
+  this->ppc = checkpoint->read<uint64_t>();
+  this->npc = checkpoint->read<uint64_t>();
+
+  uint32_t nb_events = checkpoint->read<uint32_t>();
+  uint32_t current_event = checkpoint->read<uint32_t>();
+
+  if (nb_events > this->events.size())
+  {
+    this->current_event = event_new(this->sampling ? iss_wrapper::exec_instr_sampled : iss_wrapper::exec_instr);
+  }
+
+  if (current_event < this->events.size())
+  {
+    this->current_event = this->events[current_event];
+  }
+}
+
+void iss_wrapper::post_restore()
+{
+  // The end of HW loops is detected by patching the handler of the last
+  // instruction, which requires decoding it, so this is done once memories
+  // are restored
+  if (this->cpu.pulpv2.hwloop)
+  {
+    for (int i=0; i<2; i++)
+    {
+      if (this->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPCOUNT(i)])
+      {
+        hwloop_set_end(this, NULL, i, this->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND(i)]);
+      }
+    }
+  }
+}
+
+
+// Sampling is configured through the sampling node of the core:
+// enabled, trigger ("insn" or "magic"), magic_opcode, fast_forward, warmup,
+// window (in instructions), batch (instructions executed per event when
+// fast-forwarding) and report (CSV file).
+void iss_wrapper::sampling_init()
+{
+  js::config *config = this->get_js_config()->get("sampling");
+  js::config *enabled = config != NULL ? config->get("enabled") : NULL;
+
+  this->sampling = enabled != NULL && enabled->get_bool();
+  if (!this->sampling)
+    return;
+
+  js::config *trigger = config->get("trigger");
+  this->sampling_magic = trigger != NULL && trigger->get_str() == "magic";
+  this->sampling_magic_opcode = config->get_child_int("magic_opcode");
+  this->sampling_fast_forward = config->get_child_int("fast_forward");
+  this->sampling_warmup = config->get_child_int("warmup");
+  this->sampling_window = config->get_child_int("window");
+  this->sampling_batch = config->get_child_int("batch");
+  if (this->sampling_batch <= 0)
+    this->sampling_batch = 1;
+
+  js::config *report = config->get("report");
+  std::string path = report != NULL ? report->get_str() : "";
+  if (path == "")
+  {
+    path = "sampling" + this->get_path() + ".csv";
+    std::replace(path.begin() + 8, path.end() - 4, '/', '_');
+  }
+
+  this->sampling_file = fopen(path.c_str(), "w");
+  if (this->sampling_file == NULL)
+  {
+    this->trace.fatal("Unable to open sampling report: %s, %s\n", path.c_str(), strerror(errno));
+    return;
+  }
+
+  fprintf(this->sampling_file, "window,first_insn,interval_insns,insns,cycles,cpi,projected_cycles\n");
+
+  this->sampling_insns = 0;
+  this->sampling_interval_start = 0;
+  this->sampling_nb_windows = 0;
+  this->sampling_cpi = 0;
+  this->sampling_projected_cycles = 0;
+  this->sampling_enter_phase(SAMPLING_FAST_FORWARD, this->sampling_magic ? -1 : this->sampling_fast_forward);
+}
+
+void iss_wrapper::sampling_enter_phase(int phase, int64_t nb_insns)
+{
+  this->sampling_phase = phase;
+  this->sampling_phase_end = nb_insns < 0 ? INT64_MAX : this->sampling_insns + nb_insns;
+
+  if (phase == SAMPLING_DETAILED)
+  {
+    this->sampling_window_insn = this->sampling_insns;
+    this->sampling_window_cycles = this->get_cycles();
+  }
+
+  // Empty phases are skipped, a detailed window contains at least one
+  // instruction
+  if (nb_insns == 0 && phase != SAMPLING_DETAILED)
+    this->sampling_next_phase();
+}
+
+void iss_wrapper::sampling_next_phase()
+{
+  if (this->sampling_phase == SAMPLING_FAST_FORWARD)
+  {
+    this->sampling_enter_phase(SAMPLING_WARMUP, this->sampling_warmup);
+  }
+  else if (this->sampling_phase == SAMPLING_WARMUP)
+  {
+    this->sampling_enter_phase(SAMPLING_DETAILED, this->sampling_window);
+  }
+  else
+  {
+    // The window CPI is applied to all instructions executed since the end
+    // of the previous window
+    int64_t insns = this->sampling_insns - this->sampling_window_insn;
+    int64_t cycles = this->get_cycles() - this->sampling_window_cycles;
+    int64_t interval_insns = this->sampling_insns - this->sampling_interval_start;
+
+    if (insns > 0)
+    {
+      this->sampling_cpi = (double)cycles / insns;
+    }
+    this->sampling_projected_cycles += this->sampling_cpi * interval_insns;
+
+    fprintf(this->sampling_file, "%d,%ld,%ld,%ld,%ld,%f,%.0f\n", this->sampling_nb_windows,
+      this->sampling_window_insn, interval_insns, insns, cycles, this->sampling_cpi,
+      this->sampling_projected_cycles);
+
+    this->sampling_nb_windows++;
+    this->sampling_interval_start = this->sampling_insns;
+
+    this->sampling_enter_phase(SAMPLING_FAST_FORWARD, this->sampling_magic ? -1 : this->sampling_fast_forward);
+  }
+}
+
+// Functional execution of a batch of instructions without going through the
+// clock engine. Each instruction takes one cycle whatever its latency or the
+// latency of its memory accesses. The core does not account the energy of
+// these instructions, but the memories and peripherals it accesses still
+// account theirs, so power reports do not stand for the fast-forwarded
+// intervals.
+int iss_wrapper::sampling_exec_functional(vp::clock_event *event, int64_t *nb_insns)
+{
+  int64_t max_insns = this->sampling_phase_end - this->sampling_insns;
+  if (max_insns > this->sampling_batch)
+    max_insns = this->sampling_batch;
+
+  int64_t insns = 0;
+  int cycles = 0;
+
+  while (insns < max_insns)
+  {
+    int insn_cycles = iss_exec_step_nofetch(this);
+    insns++;
+
+    if (insn_cycles < 0)
+    {
+      cycles = -1;
+      break;
+    }
+
+    cycles++;
+
+    // Stop the batch when the core state changed, for example because of
+    // an interrupt, or when the magic instruction is found
+    if (this->current_event != event || !this->is_active_reg.get() ||
+      (this->sampling_magic && this->cpu.prev_insn->opcode == this->sampling_magic_opcode))
+      break;
+  }
+
+  *nb_insns = insns;
+
+  return cycles;
+}
+
+void iss_wrapper::stop()
+{
+  if (this->sampling && this->sampling_file)
+  {
+    // Instructions executed after the last window are extrapolated with
+    // its CPI
+    double projected_cycles = this->sampling_projected_cycles +
+      this->sampling_cpi * (this->sampling_insns - this->sampling_interval_start);
+
+    fclose(this->sampling_file);
+    this->sampling_file = NULL;
+
+    printf("%s: sampling (instructions: %ld, windows: %d, projected cycles: %.0f)\n",
+      this->get_path().c_str(), this->sampling_insns, this->sampling_nb_windows, projected_cycles);
+  }
+}
+
+
 iss_wrapper::iss_wrapper(const char *config)
 : vp::component(config)
 {
@@ -23,6 +23,7 @@
 #include <string.h>
 #include "vp/itf/hyper.hpp"
 #include "vp/itf/wire.hpp"
+#include "vp/itf/io.hpp"
 #include "archi/utils.h"
 #include "archi/udma/hyper/udma_hyper_v1.h"
 
@@ -78,6 +79,8 @@ protected:
 
 class Hyperram
 {
+  friend class hyperchip;
+
 public:
   Hyperram(hyperchip *top, int size);
 
@@ -112,11 +115,21 @@ public:
   static void sync_cycle(void *_this, int data);
   static void cs_sync(void *__this, bool value);
 
+  static uint8_t *ram_backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write);
+  static uint8_t *flash_backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write);
+  static vp::io_req_status_e ram_debug_req(void *__this, vp::io_req *req);
+  static vp::io_req_status_e flash_debug_req(void *__this, vp::io_req *req);
+
 protected:
   vp::trace     trace;
   vp::hyper_slave   in_itf;
   vp::wire_slave<bool> cs_itf;
 
+  // Zero-time accesses to the ram and flash contents for debuggers and
+  // loaders, outside of the hyperbus protocol
+  vp::io_slave ram_debug_itf;
+  vp::io_slave flash_debug_itf;
+
 private:
   Hyperflash *flash;
   Hyperram *ram;
@@ -382,6 +395,32 @@ void hyperchip::cs_sync(void *__this, bool value)
   }
 }
 
+uint8_t *hyperchip::ram_backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write)
+{
+  hyperchip *_this = (hyperchip *)__this;
+  if (offset + size > (uint64_t)_this->ram->size) return NULL;
+  return &_this->ram->data[offset];
+}
+
+uint8_t *hyperchip::flash_backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write)
+{
+  hyperchip *_this = (hyperchip *)__this;
+  if (offset + size > (uint64_t)_this->flash->size) return NULL;
+  return &_this->flash->data[offset];
+}
+
+vp::io_req_status_e hyperchip::ram_debug_req(void *__this, vp::io_req *req)
+{
+  hyperchip *_this = (hyperchip *)__this;
+  return vp::io_master::debug(&_this->ram_debug_itf, req->get_addr(), req->get_size(), req->get_is_write(), req->get_data());
+}
+
+vp::io_req_status_e hyperchip::flash_debug_req(void *__this, vp::io_req *req)
+{
+  hyperchip *_this = (hyperchip *)__this;
+  return vp::io_master::debug(&_this->flash_debug_itf, req->get_addr(), req->get_size(), req->get_is_write(), req->get_data());
+}
+
 int hyperchip::build()
 {
 
@@ -393,6 +432,14 @@ int hyperchip::build()
   cs_itf.set_sync_meth(&hyperchip::cs_sync);
   new_slave_port("cs", &cs_itf);
 
+  ram_debug_itf.set_req_meth(&hyperchip::ram_debug_req);
+  ram_debug_itf.set_backdoor_meth(&hyperchip::ram_backdoor);
+  new_slave_port("ram_debug", &ram_debug_itf);
+
+  flash_debug_itf.set_req_meth(&hyperchip::flash_debug_req);
+  flash_debug_itf.set_backdoor_meth(&hyperchip::flash_backdoor);
+  new_slave_port("flash_debug", &flash_debug_itf);
+
   int ram_size = 0;
   int flash_size = 0;
 
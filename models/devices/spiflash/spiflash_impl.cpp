@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <vp/itf/qspim.hpp>
+#include <vp/itf/io.hpp>
 
 #define CMD_READ_ID       0x9f
 #define CMD_RDCR          0x35
@@ -89,10 +90,17 @@ public:
   static void single_read(void *__this, int data_0, int data_1, int data_2, int data_3);
   static void write_any_register(void *__this, int data_0, int data_1, int data_2, int data_3);
 
+  static uint8_t *backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write);
+  static vp::io_req_status_e debug_req(void *__this, vp::io_req *req);
+
 protected:
   vp::qspim_slave   in_itf;
   vp::wire_slave<bool> cs_itf;
 
+  // Zero-time access to the flash content for debuggers and loaders, outside
+  // of the SPI protocol
+  vp::io_slave debug_itf;
+
 private:
 
   static void sync(void *__this, int sck, int data_0, int data_1, int data_2, int data_3, int mask);
@@ -352,6 +360,24 @@ void spiflash::cs_sync(void *__this, bool active)
 
 }
   
+uint8_t *spiflash::backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write)
+{
+  spiflash *_this = (spiflash *)__this;
+
+  if (offset + size > (uint64_t)_this->size) return NULL;
+
+  return &_this->mem_data[offset];
+}
+
+vp::io_req_status_e spiflash::debug_req(void *__this, vp::io_req *req)
+{
+  spiflash *_this = (spiflash *)__this;
+
+  _this->trace.msg("Debug access (offset: 0x%lx, size: 0x%lx, is_write: %d)\n", req->get_addr(), req->get_size(), req->get_is_write());
+
+  return vp::io_master::debug(&_this->debug_itf, req->get_addr(), req->get_size(), req->get_is_write(), req->get_data());
+}
+
 int spiflash::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
@@ -363,6 +389,10 @@ int spiflash::build()
   this->cs_itf.set_sync_meth(&spiflash::cs_sync);
   this->new_slave_port("cs", &this->cs_itf);
 
+  this->debug_itf.set_req_meth(&spiflash::debug_req);
+  this->debug_itf.set_backdoor_meth(&spiflash::backdoor);
+  this->new_slave_port("debug", &this->debug_itf);
+
   memset((void *)this->commands, 0, sizeof(commands));
 
   for (unsigned int i=0; i<sizeof(commands_descs)/sizeof(command_t) ; i++)
@@ -33,6 +33,7 @@ public:
   int build();
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
+  static vp::io_req_status_e debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data);
 
 
   static void grant(void *_this, vp::io_req *req);
@@ -115,6 +116,44 @@ vp::io_req_status_e interleaver::req(void *__this, vp::io_req *req)
   return vp::IO_REQ_OK;
 }
 
+// Same splitting as normal requests, each chunk being forwarded as a debug
+// access to its slave
+vp::io_req_status_e interleaver::debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data)
+{
+  interleaver *_this = (interleaver *)__this;
+
+  _this->trace.msg("Debug access (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, is_write);
+
+  int port_size = 1<<_this->interleaving_bits;
+  int align_size = offset & (port_size - 1);
+  if (align_size) align_size = port_size - align_size;
+
+  offset -= _this->remove_offset;
+
+  while(size) {
+
+    uint64_t loop_size = port_size;
+    if (align_size) {
+      loop_size = align_size;
+      align_size = 0;
+    }
+    if (loop_size > size) loop_size = size;
+
+    int output_id = (offset >> _this->interleaving_bits) & ((1 << _this->stage_bits) - 1);
+    uint64_t new_offset = ((offset & _this->offset_mask) >> _this->stage_bits) + (offset & ((1<<_this->interleaving_bits)-1));
+
+    if (!_this->out[output_id]) return vp::IO_REQ_INVALID;
+
+    if (_this->out[output_id]->debug(new_offset, loop_size, is_write, data)) return vp::IO_REQ_INVALID;
+
+    size -= loop_size;
+    offset += loop_size;
+    data += loop_size;
+  }
+
+  return vp::IO_REQ_OK;
+}
+
 void interleaver::grant(void *_this, vp::io_req *req)
 {
 
@@ -129,11 +168,15 @@ int interleaver::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&interleaver::req);
+  in.set_debug_meth(&interleaver::debug);
   new_slave_port("input", &in);
 
   nb_slaves = get_config_int("nb_slaves");
   nb_masters = get_config_int("nb_masters");
   stage_bits = get_config_int("stage_bits");
+  // Also done by the python class, but not when launched natively
+  if (stage_bits == 0)
+    stage_bits = ceil(log2(nb_slaves));
   interleaving_bits = get_config_int("interleaving_bits");
   remove_offset = get_config_int("remove_offset");
 
@@ -154,6 +197,7 @@ int interleaver::build()
   {
     masters_in[i] = new vp::io_slave();
     masters_in[i]->set_req_meth(&interleaver::req);
+    masters_in[i]->set_debug_meth(&interleaver::debug);
     new_slave_port("in_" + std::to_string(i), masters_in[i]);
   }
   return 0;
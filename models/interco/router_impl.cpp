@@ -26,12 +26,15 @@
 
 class router;
 
+// Counters of the accesses to an entry of the map. They are registered as
+// stats and can also be read and written by other components through the
+// wire interfaces.
 class Perf_counter {
 public:
-  int64_t nb_read;
-  int64_t nb_write;
-  int64_t read_stalls;
-  int64_t write_stalls;
+  vp::stat_scalar nb_read;
+  vp::stat_scalar nb_write;
+  vp::stat_scalar read_stalls;
+  vp::stat_scalar write_stalls;
 
   vp::wire_slave<uint32_t> nb_read_itf;
   vp::wire_slave<uint32_t> nb_write_itf;
@@ -93,6 +96,8 @@ public:
   int build();
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
+  static uint8_t *backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write);
+  static vp::io_req_status_e debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data);
 
 
   static void grant(void *_this, vp::io_req *req);
@@ -107,6 +112,7 @@ private:
   bool init = false;
 
   void init_entries();
+  MapEntry *get_entry(uint64_t offset, uint64_t size);
   MapEntry *firstMapEntry = NULL;
   MapEntry *defaultMapEntry = NULL;
   MapEntry *errorMapEntry = NULL;
@@ -157,22 +163,15 @@ void MapEntry::insert(router *router)
   }
 }
 
-vp::io_req_status_e router::req(void *__this, vp::io_req *req)
+MapEntry *router::get_entry(uint64_t offset, uint64_t size)
 {
-  router *_this = (router *)__this;
-  
-  if (!_this->init)
+  if (!this->init)
   {
-    _this->init = true;
-    _this->init_entries();
+    this->init = true;
+    this->init_entries();
   }
 
-  MapEntry *entry = _this->topMapEntry;
-  uint64_t offset = req->get_addr();
-  bool isRead = !req->get_is_write();
-  uint64_t size = req->get_size();  
-
-  _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
+  MapEntry *entry = this->topMapEntry;
 
   if (entry)
   {
@@ -190,12 +189,87 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
   }
 
   if (!entry) {
-    if (_this->errorMapEntry && offset >= _this->errorMapEntry->base && offset + size - 1 <= _this->errorMapEntry->base + _this->errorMapEntry->size - 1) {
+    if (this->errorMapEntry && offset >= this->errorMapEntry->base && offset + size - 1 <= this->errorMapEntry->base + this->errorMapEntry->size - 1) {
     } else {
-      entry = _this->defaultMapEntry;
+      entry = this->defaultMapEntry;
     }
   }
 
+  return entry;
+}
+
+uint8_t *router::backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write)
+{
+  router *_this = (router *)__this;
+
+  MapEntry *entry = _this->get_entry(offset, size);
+  if (!entry) return NULL;
+
+  // The area must be fully inside the entry to be contiguous on the target
+  if (entry != _this->defaultMapEntry && offset + size > entry->base + entry->size) return NULL;
+
+  _this->trace.msg("Backdoor access (offset: 0x%llx, size: 0x%llx, target: %s)\n", offset, size, entry->target_name.c_str());
+
+  if (entry->remove_offset) offset -= entry->remove_offset;
+  if (entry->add_offset) offset += entry->add_offset;
+
+  if (entry->port)
+    return vp::io_master::backdoor(entry->port, offset, size, is_write);
+  else if (entry->itf && entry->itf->is_bound())
+    return entry->itf->backdoor(offset, size, is_write);
+
+  return NULL;
+}
+
+// Debug accesses are split at the boundaries of the entries so that they can
+// cover several targets
+vp::io_req_status_e router::debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data)
+{
+  router *_this = (router *)__this;
+
+  _this->trace.msg("Debug access (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, is_write);
+
+  while (size)
+  {
+    MapEntry *entry = _this->get_entry(offset, size);
+    if (!entry) return vp::IO_REQ_INVALID;
+
+    uint64_t loop_size = size;
+    if (entry != _this->defaultMapEntry && offset + loop_size > entry->base + entry->size)
+      loop_size = entry->base + entry->size - offset;
+
+    uint64_t target_offset = offset;
+    if (entry->remove_offset) target_offset -= entry->remove_offset;
+    if (entry->add_offset) target_offset += entry->add_offset;
+
+    vp::io_req_status_e result = vp::IO_REQ_INVALID;
+    if (entry->port)
+      result = vp::io_master::debug(entry->port, target_offset, loop_size, is_write, data);
+    else if (entry->itf && entry->itf->is_bound())
+      result = entry->itf->debug(target_offset, loop_size, is_write, data);
+
+    if (result != vp::IO_REQ_OK) return result;
+
+    offset += loop_size;
+    size -= loop_size;
+    data += loop_size;
+  }
+
+  return vp::IO_REQ_OK;
+}
+
+vp::io_req_status_e router::req(void *__this, vp::io_req *req)
+{
+  router *_this = (router *)__this;
+
+  uint64_t offset = req->get_addr();
+  bool isRead = !req->get_is_write();
+  uint64_t size = req->get_size();  
+
+  _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
+
+  MapEntry *entry = _this->get_entry(offset, size);
+
   if (!entry) {
     //_this->trace.msg(&warning, "Invalid access (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
     return vp::IO_REQ_INVALID;
@@ -269,14 +343,14 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
     Perf_counter *counter = _this->counters[entry->id];
 
     if (isRead)
-      counter->read_stalls += latency;
+      counter->read_stalls.inc(latency);
     else
-      counter->write_stalls += latency;
+      counter->write_stalls.inc(latency);
   
     if (isRead)
-      counter->nb_read++;
+      counter->nb_read.inc();
     else
-      counter->nb_write++;
+      counter->nb_write.inc();
 
   }
 
@@ -308,6 +382,8 @@ int router::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&router::req);
+  in.set_backdoor_meth(&router::backdoor);
+  in.set_debug_meth(&router::debug);
   new_slave_port("input", &in);
 
   out.set_resp_meth(&router::response);
@@ -358,6 +434,12 @@ int router::build()
         Perf_counter *counter = new Perf_counter();
         this->counters[entry->id] = counter;
 
+        std::string suffix = "[" + std::to_string(entry->id) + "]";
+        stats.new_stat("nb_read" + suffix, &counter->nb_read);
+        stats.new_stat("nb_write" + suffix, &counter->nb_write);
+        stats.new_stat("read_stalls" + suffix, &counter->read_stalls);
+        stats.new_stat("write_stalls" + suffix, &counter->write_stalls);
+
         counter->nb_read_itf.set_sync_back_meth(&Perf_counter::nb_read_sync_back);
         counter->nb_read_itf.set_sync_meth(&Perf_counter::nb_read_sync);
         new_slave_port((void *)counter, "nb_read[" + std::to_string(entry->id) + "]", &counter->nb_read_itf);
@@ -482,61 +564,61 @@ inline void io_master_map::bind_to(vp::port *_port, vp::config *config)
 void Perf_counter::nb_read_sync_back(void *__this, uint32_t *value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  *value = _this->nb_read;
+  *value = _this->nb_read.get();
 }
 
 void Perf_counter::nb_read_sync(void *__this, uint32_t value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  _this->nb_read = value;
+  _this->nb_read.set(value);
 }
 
 void Perf_counter::nb_write_sync_back(void *__this, uint32_t *value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  *value = _this->nb_write;
+  *value = _this->nb_write.get();
 }
 
 void Perf_counter::nb_write_sync(void *__this, uint32_t value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  _this->nb_write = value;
+  _this->nb_write.set(value);
 }
 
 void Perf_counter::read_stalls_sync_back(void *__this, uint32_t *value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  *value = _this->read_stalls;
+  *value = _this->read_stalls.get();
 }
 
 void Perf_counter::read_stalls_sync(void *__this, uint32_t value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  _this->read_stalls = value;
+  _this->read_stalls.set(value);
 }
 
 void Perf_counter::write_stalls_sync_back(void *__this, uint32_t *value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  *value = _this->write_stalls;
+  *value = _this->write_stalls.get();
 }
 
 void Perf_counter::write_stalls_sync(void *__this, uint32_t value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  _this->write_stalls = value;
+  _this->write_stalls.set(value);
 }
 
 void Perf_counter::stalls_sync_back(void *__this, uint32_t *value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
 
-  *value = _this->read_stalls + _this->write_stalls;
+  *value = _this->read_stalls.get() + _this->write_stalls.get();
 }
 
 void Perf_counter::stalls_sync(void *__this, uint32_t value)
 {
   Perf_counter *_this = (Perf_counter *)__this;
-  _this->read_stalls = value;
-  _this->write_stalls = value;
+  _this->read_stalls.set(value);
+  _this->write_stalls.set(value);
 }
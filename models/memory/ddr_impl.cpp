@@ -23,10 +23,31 @@
 #include <stdio.h>
 #include <string.h>
 
-class ddr : public vp::component
+#define MAX(a,b) (((a)>(b))?(a):(b))
+
+// Event-driven DDR timing model.
+// Requests are queued into the controller and scheduled with an FR-FCFS
+// policy (oldest request hitting an open row first, otherwise oldest request).
+// Each bank keeps its open row, and the timing of each request is computed
+// analytically from the bank state, the shared data bus and the refresh
+// schedule, so that only one event per scheduling decision and one per
+// response are needed. All timings are expressed in cycles of the ddr clock.
+
+class ddr_bank
 {
+public:
+  // Row currently opened in the row buffer, -1 if the bank is precharged
+  int64_t open_row = -1;
 
-  friend class ddr_module;
+  // Cycle where the current row was activated, used for tRAS
+  int64_t act_cycle = 0;
+
+  // Cycle where the bank can accept a new command
+  int64_t ready_cycle = 0;
+};
+
+class ddr : public vp::component
+{
 
 public:
 
@@ -34,23 +55,85 @@ public:
 
   int build();
   void start();
+  void stop();
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
-
-protected:
-  vp::io_req *first_pending_reqs = NULL;
-  vp::io_req *first_stalled_req = NULL;
+  static uint8_t *backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write);
+  static vp::io_req_status_e debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data);
 
 private:
 
+  static void sched_handler(void *__this, vp::clock_event *event);
+  static void resp_handler(void *__this, vp::clock_event *event);
+
+  int get_timing(js::config *config, std::string name, int default_value);
+  vp::io_req *pick_req();
+  int64_t check_refresh(int64_t cycle);
+  int64_t issue_req(vp::io_req *req, int64_t cycle);
+  void push_req(vp::io_req **first, vp::io_req **last, vp::io_req *req);
+
   vp::trace     trace;
   vp::io_slave in;
 
   uint64_t size = 0;
-  int max_reqs = 4;
+  uint8_t *mem_data;
+
+  // DDR timings
+  int t_rcd;
+  int t_rp;
+  int t_cas;
+  int t_ras;
+  int t_refi;
+  int t_rfc;
+
+  // DDR geometry
+  int nb_banks;
+  int row_size;
+  int bus_width;
+
+  // Maximum number of requests accepted by the controller before they
+  // get denied
+  int queue_size;
+
+  // Number of cycles before the data bus becomes free where the scheduler
+  // issues the next requests, so that the bus stays busy
+  int lookahead;
+
+  ddr_bank *banks;
+  int64_t bus_free_cycle = 0;
+  int64_t next_refresh_cycle;
+
+  // Number of requests currently owned by the controller, pending or issued
   int current_reqs = 0;
-  int count = 0;
-  vp::io_req *last_pending_reqs = NULL;
+
+  // Requests waiting to be scheduled, in arrival order
+  vp::io_req *first_pending_req = NULL;
+  vp::io_req *last_pending_req = NULL;
+
+  // Requests scheduled and waiting for their data transfer to finish.
+  // As the data bus is shared, they complete in issue order.
+  vp::io_req *first_issued_req = NULL;
+  vp::io_req *last_issued_req = NULL;
+
+  // Requests which were denied and will be granted once a slot is free
+  vp::io_req *first_stalled_req = NULL;
+  vp::io_req *last_stalled_req = NULL;
+
+  vp::clock_event *sched_event;
+  vp::clock_event *resp_event;
+
+  // Statistics, dumped by the stats engine
+  vp::stat_scalar nb_reqs;
+  vp::stat_scalar nb_denied;
+  vp::stat_scalar nb_row_hits;
+  vp::stat_scalar nb_row_misses;
+  vp::stat_scalar nb_row_conflicts;
+  vp::stat_scalar nb_refreshes;
+  vp::stat_scalar max_queue_depth;
+  vp::stat_histogram queue_depth;
+  // Cycles from the arrival of a request to its response
+  vp::stat_histogram latency;
+  vp::stat_rate bandwidth;
 };
 
 ddr::ddr(const char *config)
@@ -59,12 +142,21 @@ ddr::ddr(const char *config)
 
 }
 
+void ddr::push_req(vp::io_req **first, vp::io_req **last, vp::io_req *req)
+{
+  if (*first)
+    (*last)->set_next(req);
+  else
+    *first = req;
+  *last = req;
+  req->set_next(NULL);
+}
+
 vp::io_req_status_e ddr::req(void *__this, vp::io_req *req)
 {
   ddr *_this = (ddr *)__this;
 
   uint64_t offset = req->get_addr();
-  uint8_t *data = req->get_data();
   uint64_t size = req->get_size();
 
   _this->trace.msg("ddr access (offset: 0x%x, size: 0x%x, is_write: %d)\n", offset, size, req->get_is_write());
@@ -74,25 +166,238 @@ vp::io_req_status_e ddr::req(void *__this, vp::io_req *req)
     return vp::IO_REQ_INVALID;
   }
 
-  if (_this->first_pending_reqs)
-    _this->last_pending_reqs->set_next(req);
-  else
-    _this->first_pending_reqs = req;
-  _this->last_pending_reqs = req;
-  req->set_next(NULL);
-
   _this->current_reqs++;
+  _this->nb_reqs.inc();
+  _this->queue_depth.add(_this->current_reqs);
+  if (_this->current_reqs > _this->max_queue_depth.get())
+    _this->max_queue_depth.set(_this->current_reqs);
+
+  // Arrival cycle, for the latency
+  req->arg_push((void *)_this->get_cycles());
 
-  if (_this->current_reqs > _this->max_reqs)
+  if (_this->current_reqs > _this->queue_size)
   {
-    if (_this->first_stalled_req == NULL)
-      _this->first_stalled_req = _this->last_pending_reqs;
+    _this->nb_denied.inc();
+    _this->push_req(&_this->first_stalled_req, &_this->last_stalled_req, req);
     return vp::IO_REQ_DENIED;
   }
+
+  _this->push_req(&_this->first_pending_req, &_this->last_pending_req, req);
+
+  if (!_this->sched_event->is_enqueued())
+    _this->event_enqueue(_this->sched_event, 1);
+
+  return vp::IO_REQ_PENDING;
+}
+
+vp::io_req *ddr::pick_req()
+{
+  // First ready, first come first served: take the oldest request hitting
+  // an open row, or the oldest one if there is no row hit.
+  vp::io_req *prev = NULL;
+  vp::io_req *prev_hit = NULL;
+  vp::io_req *hit = NULL;
+
+  for (vp::io_req *req = this->first_pending_req; req; req = req->get_next())
+  {
+    int64_t row_index = req->get_addr() / this->row_size;
+    if (this->banks[row_index % this->nb_banks].open_row == row_index / this->nb_banks)
+    {
+      hit = req;
+      prev_hit = prev;
+      break;
+    }
+    prev = req;
+  }
+
+  if (hit == NULL)
+  {
+    hit = this->first_pending_req;
+    prev_hit = NULL;
+  }
+
+  if (prev_hit)
+    prev_hit->set_next(hit->get_next());
   else
+    this->first_pending_req = hit->get_next();
+
+  if (this->last_pending_req == hit)
+    this->last_pending_req = prev_hit;
+
+  return hit;
+}
+
+int64_t ddr::check_refresh(int64_t cycle)
+{
+  // Refreshes are applied lazily when a command is about to be issued.
+  // All refreshes which should have happened before are accounted at once,
+  // they close all rows and block the device during tRFC.
+  if (cycle < this->next_refresh_cycle)
+    return cycle;
+
+  int64_t nb_refreshes = (cycle - this->next_refresh_cycle) / this->t_refi + 1;
+  int64_t last_refresh_cycle = this->next_refresh_cycle + (nb_refreshes - 1) * this->t_refi;
+
+  this->nb_refreshes.inc(nb_refreshes);
+  this->next_refresh_cycle = last_refresh_cycle + this->t_refi;
+
+  for (int i=0; i<this->nb_banks; i++)
   {
-    return vp::IO_REQ_PENDING;
+    this->banks[i].open_row = -1;
   }
+
+  this->trace.msg("Refreshing (cycle: %ld, count: %ld)\n", last_refresh_cycle, nb_refreshes);
+
+  return MAX(cycle, last_refresh_cycle + this->t_rfc);
+}
+
+// Debug accesses directly work on the storage and do not see the requests
+// still queued in the controller, as their data is only copied when they are
+// issued
+uint8_t *ddr::backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write)
+{
+  ddr *_this = (ddr *)__this;
+
+  if (offset + size > _this->size) return NULL;
+
+  return &_this->mem_data[offset];
+}
+
+vp::io_req_status_e ddr::debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data)
+{
+  ddr *_this = (ddr *)__this;
+
+  if (offset + size > _this->size) return vp::IO_REQ_INVALID;
+
+  _this->trace.msg("Debug access (offset: 0x%lx, size: 0x%lx, is_write: %d)\n", offset, size, is_write);
+
+  if (is_write)
+    memcpy(&_this->mem_data[offset], data, size);
+  else
+    memcpy(data, &_this->mem_data[offset], size);
+
+  return vp::IO_REQ_OK;
+}
+
+int64_t ddr::issue_req(vp::io_req *req, int64_t cycle)
+{
+  uint64_t offset = req->get_addr();
+  uint64_t size = req->get_size();
+  int64_t row_index = offset / this->row_size;
+  int64_t row = row_index / this->nb_banks;
+  ddr_bank *bank = &this->banks[row_index % this->nb_banks];
+
+  int64_t start_cycle = this->check_refresh(MAX(cycle, bank->ready_cycle));
+  int64_t cas_cycle;
+
+  if (bank->open_row == row)
+  {
+    this->nb_row_hits.inc();
+    cas_cycle = start_cycle;
+  }
+  else
+  {
+    int64_t act_cycle = start_cycle;
+
+    if (bank->open_row != -1)
+    {
+      // Row conflict, the current row must be precharged first, which can
+      // only happen tRAS cycles after it was activated
+      this->nb_row_conflicts.inc();
+      act_cycle = MAX(start_cycle, bank->act_cycle + this->t_ras) + this->t_rp;
+    }
+    else
+    {
+      this->nb_row_misses.inc();
+    }
+
+    bank->open_row = row;
+    bank->act_cycle = act_cycle;
+    cas_cycle = act_cycle + this->t_rcd;
+  }
+
+  int64_t burst = (size + this->bus_width - 1) / this->bus_width;
+  int64_t data_cycle = MAX(cas_cycle + this->t_cas, this->bus_free_cycle);
+
+  this->bus_free_cycle = data_cycle + burst;
+  bank->ready_cycle = data_cycle - this->t_cas + burst;
+
+  this->trace.msg("Issuing request (offset: 0x%lx, size: 0x%lx, bank: %ld, row: %ld, data_cycle: %ld, end_cycle: %ld)\n",
+    offset, size, row_index % this->nb_banks, row, data_cycle, this->bus_free_cycle);
+
+  if (req->get_is_write())
+    memcpy(&this->mem_data[offset], req->get_data(), size);
+  else
+    memcpy(req->get_data(), &this->mem_data[offset], size);
+
+  return this->bus_free_cycle;
+}
+
+void ddr::sched_handler(void *__this, vp::clock_event *event)
+{
+  ddr *_this = (ddr *)__this;
+  int64_t cycle = _this->get_cycles();
+
+  // Issue requests until the data bus is booked far enough in the future.
+  // Requests issued in the same window get overlapped activations when they
+  // target different banks.
+  while (_this->first_pending_req && _this->bus_free_cycle <= cycle + _this->lookahead)
+  {
+    vp::io_req *req = _this->pick_req();
+    int64_t end_cycle = _this->issue_req(req, cycle);
+
+    req->arg_push((void *)end_cycle);
+    _this->push_req(&_this->first_issued_req, &_this->last_issued_req, req);
+
+    if (!_this->resp_event->is_enqueued())
+      _this->event_enqueue(_this->resp_event, end_cycle - cycle);
+  }
+
+  if (_this->first_pending_req)
+    _this->event_enqueue(_this->sched_event, MAX(1, _this->bus_free_cycle - _this->lookahead - cycle));
+}
+
+void ddr::resp_handler(void *__this, vp::clock_event *event)
+{
+  ddr *_this = (ddr *)__this;
+  int64_t cycle = _this->get_cycles();
+
+  while (_this->first_issued_req && (int64_t)*_this->first_issued_req->arg_get() <= cycle)
+  {
+    vp::io_req *req = _this->first_issued_req;
+    _this->first_issued_req = req->get_next();
+    req->arg_pop();
+    _this->latency.add(cycle - (int64_t)req->arg_pop());
+    _this->bandwidth.inc(req->get_size());
+
+    _this->current_reqs--;
+    req->get_resp_port()->resp(req);
+
+    // A slot is now free in the controller, accept one of the stalled
+    // requests
+    if (_this->first_stalled_req)
+    {
+      vp::io_req *stalled_req = _this->first_stalled_req;
+      _this->first_stalled_req = stalled_req->get_next();
+
+      _this->push_req(&_this->first_pending_req, &_this->last_pending_req, stalled_req);
+      stalled_req->get_resp_port()->grant(stalled_req);
+
+      if (!_this->sched_event->is_enqueued())
+        _this->event_enqueue(_this->sched_event, 1);
+    }
+  }
+
+  if (_this->first_issued_req)
+    _this->event_enqueue(_this->resp_event, (int64_t)*_this->first_issued_req->arg_get() - cycle);
+}
+
+int ddr::get_timing(js::config *config, std::string name, int default_value)
+{
+  js::config *value = config ? config->get(name) : NULL;
+  if (value == NULL)
+    return default_value;
+  return value->get_int();
 }
 
 int ddr::build()
@@ -100,8 +405,25 @@ int ddr::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&ddr::req);
+  in.set_backdoor_meth(&ddr::backdoor);
+  in.set_debug_meth(&ddr::debug);
   new_slave_port("input", &in);
 
+  sched_event = event_new(ddr::sched_handler);
+  resp_event = event_new(ddr::resp_handler);
+
+  stats.new_stat("nb_reqs", &nb_reqs);
+  stats.new_stat("nb_denied", &nb_denied);
+  stats.new_stat("nb_row_hits", &nb_row_hits);
+  stats.new_stat("nb_row_misses", &nb_row_misses);
+  stats.new_stat("nb_row_conflicts", &nb_row_conflicts);
+  stats.new_stat("nb_refreshes", &nb_refreshes);
+  stats.new_stat("max_queue_depth", &max_queue_depth);
+  stats.new_stat("queue_depth", &queue_depth, 8);
+  // Power-of-2 buckets, from 0 to 2048 cycles and more
+  stats.new_stat("latency", &latency, 13);
+  stats.new_stat("bandwidth", &bandwidth);
+
   return 0;
 }
 
@@ -111,12 +433,39 @@ void ddr::start()
 {
   size = get_config_int("size");
 
-  trace.msg("Building ddr (size: 0x%lx)\n", size);
+  // Default values are for a DDR3-1600 device with a 64 bits bus
+  js::config *timing = get_js_config()->get("timing");
+  t_rcd = get_timing(timing, "tRCD", 11);
+  t_rp = get_timing(timing, "tRP", 11);
+  t_cas = get_timing(timing, "tCAS", 11);
+  t_ras = get_timing(timing, "tRAS", 28);
+  t_refi = get_timing(timing, "tREFI", 6240);
+  t_rfc = get_timing(timing, "tRFC", 208);
+
+  nb_banks = get_timing(get_js_config(), "nb_banks", 8);
+  row_size = get_timing(get_js_config(), "row_size", 8192);
+  bus_width = get_timing(get_js_config(), "bus_width", 16);
+  queue_size = get_timing(get_js_config(), "queue_size", 16);
 
+  lookahead = t_rp + t_rcd + t_cas;
+  next_refresh_cycle = t_refi;
+
+  trace.msg("Building ddr (size: 0x%lx, banks: %d, row_size: 0x%x, tRCD: %d, tRP: %d, tCAS: %d, tRAS: %d, tREFI: %d, tRFC: %d)\n",
+    size, nb_banks, row_size, t_rcd, t_rp, t_cas, t_ras, t_refi, t_rfc);
+
+  banks = new ddr_bank[nb_banks];
+
+  mem_data = new uint8_t[size];
+  memset(mem_data, 0x57, size);
+}
+
+void ddr::stop()
+{
+  trace.msg("DDR statistics (requests: %ld, denied: %ld, row_hits: %ld, row_misses: %ld, row_conflicts: %ld, refreshes: %ld, max_queue_depth: %ld)\n",
+    nb_reqs.get(), nb_denied.get(), nb_row_hits.get(), nb_row_misses.get(), nb_row_conflicts.get(), nb_refreshes.get(), max_queue_depth.get());
 }
 
 extern "C" void *vp_constructor(const char *config)
 {
   return (void *)new ddr(config);
 }
-
@@ -23,6 +23,45 @@
 #include <stdio.h>
 #include <string.h>
 
+#define MAX(a,b) (((a)>(b))?(a):(b))
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
+// Each page of the checked memory has a summary bit telling if all its bytes
+// have been initialized, so that accesses to fully initialized areas can skip
+// the per-byte check.
+#define MEM_CHECK_PAGE_BITS 12
+#define MEM_CHECK_PAGE_SIZE (1<<MEM_CHECK_PAGE_BITS)
+
+class memory_check
+{
+public:
+  memory_check(uint64_t size);
+
+  // Mark the specified range as initialized
+  inline void set(uint64_t offset, uint64_t size);
+
+  // Return true if all bytes of the specified range are initialized
+  inline bool check(uint64_t offset, uint64_t size);
+
+  void save(vp::checkpoint *checkpoint);
+  void restore(vp::checkpoint *checkpoint);
+
+private:
+  inline uint64_t word_mask(uint64_t word, uint64_t start, uint64_t end);
+  inline void set_page(uint64_t page, int nb_bytes);
+
+  uint64_t size;
+
+  // One bit per byte, 64 bytes per word
+  uint64_t *valid;
+
+  // One bit per page, set when the page is fully initialized
+  uint64_t *full_pages;
+
+  // Number of initialized bytes per page
+  uint32_t *page_count;
+};
+
 class memory : public vp::component
 {
 
@@ -35,6 +74,11 @@ public:
   void reset(bool active);
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
+  static uint8_t *backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write);
+  static vp::io_req_status_e debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data);
+
+  void save(vp::checkpoint *checkpoint);
+  void restore(vp::checkpoint *checkpoint);
 
 private:
 
@@ -48,7 +92,13 @@ private:
   int width_bits = 0;
 
   uint8_t *mem_data;
-  uint8_t *check_mem;
+  memory_check *check_mem;
+
+  // Pages written since the start, saved in full checkpoints, and pages
+  // written since the last checkpoint, saved in incremental ones
+  uint64_t *touched_pages;
+  uint64_t *dirty_pages;
+  bool checkpoint_enabled;
 
   int64_t next_packet_start;
 
@@ -66,8 +116,126 @@ private:
 
   vp::clock_event *power_event;
   int64_t last_access_timestamp;
+
+  vp::stat_scalar nb_read;
+  vp::stat_scalar nb_write;
+  vp::stat_scalar read_bytes;
+  vp::stat_scalar write_bytes;
+  vp::stat_scalar stall_cycles;
+  vp::stat_rate bandwidth;
+  vp::stat_histogram access_size;
 };
 
+memory_check::memory_check(uint64_t size) : size(size)
+{
+  uint64_t nb_pages = (size + MEM_CHECK_PAGE_SIZE - 1) >> MEM_CHECK_PAGE_BITS;
+
+  this->valid = new uint64_t[(size + 63) / 64]();
+  this->full_pages = new uint64_t[(nb_pages + 63) / 64]();
+  this->page_count = new uint32_t[nb_pages]();
+}
+
+void memory_check::save(vp::checkpoint *checkpoint)
+{
+  checkpoint->write(this->valid, (this->size + 63) / 64 * sizeof(uint64_t));
+}
+
+void memory_check::restore(vp::checkpoint *checkpoint)
+{
+  uint64_t nb_pages = (this->size + MEM_CHECK_PAGE_SIZE - 1) >> MEM_CHECK_PAGE_BITS;
+  uint64_t nb_words = (this->size + 63) / 64;
+
+  checkpoint->read(this->valid, nb_words * sizeof(uint64_t));
+
+  // Page summaries are rebuilt from the restored bitmap
+  memset(this->full_pages, 0, (nb_pages + 63) / 64 * sizeof(uint64_t));
+  memset(this->page_count, 0, nb_pages * sizeof(uint32_t));
+
+  for (uint64_t word = 0; word < nb_words; word++)
+  {
+    if (this->valid[word])
+      this->set_page((word * 64) >> MEM_CHECK_PAGE_BITS, __builtin_popcountll(this->valid[word]));
+  }
+}
+
+inline uint64_t memory_check::word_mask(uint64_t word, uint64_t start, uint64_t end)
+{
+  // Returns the bits of the word which are inside the range [start, end[
+  uint64_t word_start = word * 64;
+  uint64_t mask = ~0ULL;
+
+  if (start > word_start)
+    mask &= ~0ULL << (start - word_start);
+
+  if (end < word_start + 64)
+    mask &= ~0ULL >> (word_start + 64 - end);
+
+  return mask;
+}
+
+inline void memory_check::set_page(uint64_t page, int nb_bytes)
+{
+  this->page_count[page] += nb_bytes;
+
+  uint64_t page_size = MEM_CHECK_PAGE_SIZE;
+  if (((page + 1) << MEM_CHECK_PAGE_BITS) > this->size)
+    page_size = this->size - (page << MEM_CHECK_PAGE_BITS);
+
+  if (this->page_count[page] == page_size)
+    this->full_pages[page / 64] |= 1ULL << (page % 64);
+}
+
+inline void memory_check::set(uint64_t offset, uint64_t size)
+{
+  uint64_t end = offset + size;
+  uint64_t first_page = offset >> MEM_CHECK_PAGE_BITS;
+  uint64_t last_page = (end - 1) >> MEM_CHECK_PAGE_BITS;
+
+  for (uint64_t page = first_page; page <= last_page; page++)
+  {
+    if ((this->full_pages[page / 64] >> (page % 64)) & 1)
+      continue;
+
+    uint64_t page_start = MAX(offset, page << MEM_CHECK_PAGE_BITS);
+    uint64_t page_end = MIN(end, (page + 1) << MEM_CHECK_PAGE_BITS);
+    int nb_bytes = 0;
+
+    for (uint64_t word = page_start / 64; word <= (page_end - 1) / 64; word++)
+    {
+      uint64_t mask = this->word_mask(word, page_start, page_end);
+      nb_bytes += __builtin_popcountll(mask & ~this->valid[word]);
+      this->valid[word] |= mask;
+    }
+
+    this->set_page(page, nb_bytes);
+  }
+}
+
+inline bool memory_check::check(uint64_t offset, uint64_t size)
+{
+  uint64_t end = offset + size;
+  uint64_t first_page = offset >> MEM_CHECK_PAGE_BITS;
+  uint64_t last_page = (end - 1) >> MEM_CHECK_PAGE_BITS;
+
+  for (uint64_t page = first_page; page <= last_page; page++)
+  {
+    if ((this->full_pages[page / 64] >> (page % 64)) & 1)
+      continue;
+
+    uint64_t page_start = MAX(offset, page << MEM_CHECK_PAGE_BITS);
+    uint64_t page_end = MIN(end, (page + 1) << MEM_CHECK_PAGE_BITS);
+
+    for (uint64_t word = page_start / 64; word <= (page_end - 1) / 64; word++)
+    {
+      uint64_t mask = this->word_mask(word, page_start, page_end);
+      if ((this->valid[word] & mask) != mask)
+        return false;
+    }
+  }
+
+  return true;
+}
+
 memory::memory(const char *config)
 : vp::component(config)
 {
@@ -95,7 +263,6 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
 
   // Impact the memory bandwith on the packet
   if (_this->width_bits != 0) {
-#define MAX(a,b) (((a)>(b))?(a):(b))
     int duration = MAX(size >> _this->width_bits, 1);
     req->set_duration(duration);
     int64_t cycles = _this->get_cycles();
@@ -103,6 +270,7 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
     if (diff > 0) {
       _this->trace.msg("Delayed packet (latency: %ld)\n", diff);
       req->inc_latency(diff);
+      _this->stall_cycles.inc(diff);
     }
     _this->next_packet_start = MAX(_this->next_packet_start, cycles) + duration;
   }
@@ -112,6 +280,19 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
     return vp::IO_REQ_INVALID;
   }
 
+  if (req->get_is_write())
+  {
+    _this->nb_write.inc();
+    _this->write_bytes.inc(size);
+  }
+  else
+  {
+    _this->nb_read.inc();
+    _this->read_bytes.inc(size);
+  }
+  _this->bandwidth.inc(size);
+  _this->access_size.add(size);
+
   if (_this->power_trace.get_active())
   {
     _this->last_access_timestamp = _this->get_time();
@@ -158,20 +339,19 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
 
 
   if (req->get_is_write()) {
-    if (_this->check_mem) {
-      for (unsigned int i=0; i<size; i++) {
-        _this->check_mem[(offset + i) / 8] |= 1 << ((offset + i) % 8);
-      }
+    if (_this->check_mem && size) {
+      _this->check_mem->set(offset, size);
+    }
+    if (_this->checkpoint_enabled && size) {
+      vp::checkpoint::mark_pages(_this->touched_pages, offset, size);
+      vp::checkpoint::mark_pages(_this->dirty_pages, offset, size);
     }
     memcpy((void *)&_this->mem_data[offset], (void *)data, size);
   } else {
-    if (_this->check_mem) {
-      for (unsigned int i=0; i<size; i++) {
-        int access = (_this->check_mem[(offset + i) / 8] >> ((offset + i) % 8)) & 1;
-        if (!access) {
-          //trace.msg("Unitialized access (offset: 0x%x, size: 0x%x, isRead: %d)\n", offset, size, isRead);
-          return vp::IO_REQ_INVALID;
-        }
+    if (_this->check_mem && size) {
+      if (!_this->check_mem->check(offset, size)) {
+        //trace.msg("Unitialized access (offset: 0x%x, size: 0x%x, isRead: %d)\n", offset, size, isRead);
+        return vp::IO_REQ_INVALID;
       }
     }
     memcpy((void *)data, (void *)&_this->mem_data[offset], size);
@@ -180,6 +360,45 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
   return vp::IO_REQ_OK;
 }
 
+uint8_t *memory::backdoor(void *__this, uint64_t offset, uint64_t size, bool is_write)
+{
+  memory *_this = (memory *)__this;
+
+  if (offset + size > _this->size) return NULL;
+
+  _this->trace.msg("Backdoor access (offset: 0x%x, size: 0x%x, is_write: %d)\n", offset, size, is_write);
+
+  // The area is considered written as soon as it is given, as the caller
+  // writes it directly
+  if (is_write && size)
+  {
+    if (_this->check_mem)
+      _this->check_mem->set(offset, size);
+    if (_this->checkpoint_enabled)
+    {
+      vp::checkpoint::mark_pages(_this->touched_pages, offset, size);
+      vp::checkpoint::mark_pages(_this->dirty_pages, offset, size);
+    }
+  }
+
+  return &_this->mem_data[offset];
+}
+
+// Same as a normal access, without timing, statistics, power nor
+// uninitialized access checks
+vp::io_req_status_e memory::debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data)
+{
+  uint8_t *storage = memory::backdoor(__this, offset, size, is_write);
+  if (storage == NULL) return vp::IO_REQ_INVALID;
+
+  if (is_write)
+    memcpy((void *)storage, (void *)data, size);
+  else
+    memcpy((void *)data, (void *)storage, size);
+
+  return vp::IO_REQ_OK;
+}
+
 void memory::reset(bool active)
 {
   if (active)
@@ -192,6 +411,8 @@ int memory::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
   in.set_req_meth(&memory::req);
+  in.set_backdoor_meth(&memory::backdoor);
+  in.set_debug_meth(&memory::debug);
   new_slave_port("input", &in);
 
   js::config *config = get_js_config()->get("power_trigger");
@@ -199,17 +420,26 @@ int memory::build()
 
   if (power.new_trace("power_trace", &power_trace)) return -1;
 
-  power.new_leakage_event("leakage", &leakage_power, this->get_js_config()->get("**/leakage"), &power_trace);
-  power.new_event("idle", &idle_power, this->get_js_config()->get("**/idle"), &power_trace);
-  power.new_event("read_8", &read_8_power, this->get_js_config()->get("**/read_8"), &power_trace);
-  power.new_event("read_16", &read_16_power, this->get_js_config()->get("**/read_16"), &power_trace);
-  power.new_event("read_32", &read_32_power, this->get_js_config()->get("**/read_32"), &power_trace);
-  power.new_event("write_8", &write_8_power, this->get_js_config()->get("**/write_8"), &power_trace);
-  power.new_event("write_16", &write_16_power, this->get_js_config()->get("**/write_16"), &power_trace);
-  power.new_event("write_32", &write_32_power, this->get_js_config()->get("**/write_32"), &power_trace);
+  power.new_leakage_event("leakage", &leakage_power, this->get_js_config("**/leakage"), &power_trace);
+  power.new_event("idle", &idle_power, this->get_js_config("**/idle"), &power_trace);
+  power.new_event("read_8", &read_8_power, this->get_js_config("**/read_8"), &power_trace);
+  power.new_event("read_16", &read_16_power, this->get_js_config("**/read_16"), &power_trace);
+  power.new_event("read_32", &read_32_power, this->get_js_config("**/read_32"), &power_trace);
+  power.new_event("write_8", &write_8_power, this->get_js_config("**/write_8"), &power_trace);
+  power.new_event("write_16", &write_16_power, this->get_js_config("**/write_16"), &power_trace);
+  power.new_event("write_32", &write_32_power, this->get_js_config("**/write_32"), &power_trace);
 
   power_event = this->event_new(memory::power_callback);
 
+  stats.new_stat("nb_read", &nb_read);
+  stats.new_stat("nb_write", &nb_write);
+  stats.new_stat("read_bytes", &read_bytes);
+  stats.new_stat("write_bytes", &write_bytes);
+  stats.new_stat("stall_cycles", &stall_cycles);
+  stats.new_stat("bandwidth", &bandwidth);
+  // Power-of-2 buckets, from 0 to 64 bytes and more
+  stats.new_stat("access_size", &access_size, 8);
+
   return 0;
 }
 
@@ -222,12 +452,17 @@ void memory::start()
   trace.msg("Building memory (size: 0x%x, check: %d)\n", size, check);
 
   mem_data = new uint8_t[size];
+  touched_pages = vp::checkpoint::new_pages(size);
+  dirty_pages = vp::checkpoint::new_pages(size);
+  // Written pages are only tracked if a checkpoint is to be saved. An
+  // unclocked memory cannot know it and always tracks them.
+  checkpoint_enabled = this->get_clock() == NULL || this->get_engine()->is_checkpoint_enabled();
 
 
   // Special option to check for uninitialized accesses
   if (check)
   {
-    check_mem = new uint8_t[(size + 7)/8];
+    check_mem = new memory_check(size);
   }
   else
   {
@@ -265,6 +500,41 @@ void memory::start()
   this->last_access_timestamp = -1;
 }
 
+void memory::save(vp::checkpoint *checkpoint)
+{
+  checkpoint->write<int64_t>(this->next_packet_start);
+  checkpoint->write<int64_t>(this->last_access_timestamp);
+
+  // Untouched pages still have their initial content, which is the same
+  // when the checkpoint is restored
+  checkpoint->write_pages(this->mem_data, this->size,
+    checkpoint->is_incremental() ? this->dirty_pages : this->touched_pages);
+  vp::checkpoint::clear_pages(this->dirty_pages, this->size);
+
+  checkpoint->write<uint8_t>(this->check_mem != NULL);
+  if (this->check_mem)
+    this->check_mem->save(checkpoint);
+}
+
+void memory::restore(vp::checkpoint *checkpoint)
+{
+  this->next_packet_start = checkpoint->read<int64_t>();
+  this->last_access_timestamp = checkpoint->read<int64_t>();
+
+  checkpoint->read_pages(this->mem_data, this->size, this->touched_pages);
+  vp::checkpoint::clear_pages(this->dirty_pages, this->size);
+
+  if (checkpoint->read<uint8_t>())
+  {
+    if (this->check_mem == NULL)
+    {
+      checkpoint->set_error("memory check state saved while check is disabled in " + this->get_path());
+      return;
+    }
+    this->check_mem->restore(checkpoint);
+  }
+}
+
 extern "C" void *vp_constructor(const char *config)
 {
   return (void *)new memory(config);
@@ -34,6 +34,7 @@ public:
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
   static vp::io_req_status_e req_ts(void *__this, vp::io_req *req);
+  static vp::io_req_status_e debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data);
 
 
 private:
@@ -75,6 +76,33 @@ vp::io_req_status_e interleaver::req(void *__this, vp::io_req *req)
   return _this->out[bank_id]->req_forward(req);
 }
 
+// Debug accesses can cover several banks and are split into 32 bits words,
+// the interleaving granularity
+vp::io_req_status_e interleaver::debug(void *__this, uint64_t offset, uint64_t size, bool is_write, uint8_t *data)
+{
+  interleaver *_this = (interleaver *)__this;
+
+  _this->trace.msg("Debug access (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, is_write);
+
+  while (size)
+  {
+    uint64_t loop_size = 4 - (offset & 0x3);
+    if (loop_size > size) loop_size = size;
+
+    int bank_id = (offset >> 2) & _this->bank_mask;
+    uint64_t bank_offset = ((offset >> (_this->stage_bits + 2)) << 2) + (offset & 0x3);
+
+    vp::io_req_status_e err = _this->out[bank_id]->debug(bank_offset, loop_size, is_write, data);
+    if (err != vp::IO_REQ_OK) return err;
+
+    size -= loop_size;
+    offset += loop_size;
+    data += loop_size;
+  }
+
+  return vp::IO_REQ_OK;
+}
+
 vp::io_req_status_e interleaver::req_ts(void *__this, vp::io_req *req)
 {
   interleaver *_this = (interleaver *)__this;
@@ -114,11 +142,15 @@ int interleaver::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&interleaver::req);
+  in.set_debug_meth(&interleaver::debug);
   new_slave_port("in", &in);
 
   nb_slaves = get_config_int("nb_slaves");
   nb_masters = get_config_int("nb_masters");
   stage_bits = get_config_int("stage_bits");
+  // Also done by the python class, but not when launched natively
+  if (stage_bits == 0)
+    stage_bits = ceil(log2(nb_slaves));
 
   bank_mask = (1<<stage_bits) - 1;
 
@@ -135,6 +167,7 @@ int interleaver::build()
   {
     masters_in[i] = new vp::io_slave();
     masters_in[i]->set_req_meth(&interleaver::req);
+    masters_in[i]->set_debug_meth(&interleaver::debug);
     new_slave_port("in_" + std::to_string(i), masters_in[i]);
 
     masters_ts_in[i] = new vp::io_slave();
@@ -194,6 +194,9 @@ void Udma_channel::enqueue_transfer()
   req->channel = this;
   pending_reqs->push(req);
 
+  top->nb_transfers.inc();
+  top->transfer_size.add(size);
+
   check_state();
 }
 
@@ -435,6 +438,7 @@ void udma::event_handler(void *__this, vp::clock_event *event)
   {
     vp::io_req *req = _this->l2_write_reqs->pop();
     _this->trace.msg("Sending write request to L2 (value: 0x%x, addr: 0x%x, size: 0x%x)\n", *(uint32_t *)req->get_data(), req->get_addr(), req->get_size());
+    _this->l2_write_bytes.inc(req->get_size());
     int err = _this->l2_itf.req(req);
     if (err == vp::IO_REQ_OK)
     {
@@ -456,6 +460,7 @@ void udma::event_handler(void *__this, vp::clock_event *event)
     }
 
     _this->trace.msg("Sending read request to L2 (addr: 0x%x, size: 0x%x)\n", req->get_addr(), req->get_size());
+    _this->l2_read_bytes.inc(req->get_size());
     int err = _this->l2_itf.req(req);
     if (err == vp::IO_REQ_OK)
     {
@@ -604,6 +609,11 @@ int udma::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
   traces.new_trace("warning", &warning, vp::WARNING);
 
+  stats.new_stat("nb_transfers", &nb_transfers);
+  stats.new_stat("transfer_size", &transfer_size, 16);
+  stats.new_stat("l2_read_bytes", &l2_read_bytes);
+  stats.new_stat("l2_write_bytes", &l2_write_bytes);
+
   in.set_req_meth(&udma::req);
   new_slave_port("input", &in);
 
@@ -620,6 +620,12 @@ public:
   vp::trace *get_trace() { return &this->trace; }
   vp::clock_engine *get_periph_clock() { return this->periph_clock; }
 
+  // Transfers enqueued by all channels, and bytes exchanged with L2
+  vp::stat_scalar nb_transfers;
+  vp::stat_histogram transfer_size;
+  vp::stat_scalar l2_read_bytes;
+  vp::stat_scalar l2_write_bytes;
+
 protected:
   vp::io_master l2_itf;
   void push_l2_write_req(vp::io_req *req);
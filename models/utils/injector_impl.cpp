@@ -23,9 +23,23 @@
 #include <vp/itf/io.hpp>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <mutex>
+#include <vector>
+#include <list>
+
+// Request of the platform split into several slots, which gets its response
+// once all of them are done. The slots are sent as they become free, so that
+// requests can wait for slots and be bigger than the pool.
+typedef struct {
+  vp::io_req *req;
+  int remaining;
+  uint64_t nb_chunks;
+  uint64_t chunk;
+} injector_split_t;
 
 class injector : public vp::component {
 
@@ -48,8 +62,25 @@ private:
   FILE *snd_file;
   FILE *rcv_file;
 
+  // Shared-memory transport, see launcher_internal.hpp
+  gv_shm_header_t *shm;
+  // Serializes the producers of the ring to the launcher, which are the
+  // requests of the platform and the responses to the launcher requests
+  std::mutex shm_lock;
+  // Free slots of the injector pool
+  std::mutex slots_lock;
+  std::vector<uint32_t> free_slots;
+  // Requests of the platform waiting for free slots, only accessed by the
+  // engine thread or with the engine locked
+  std::list<injector_split_t *> waiting_reqs;
+
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
+  vp::io_req_status_e req_shm(vp::io_req *req);
+  bool shm_send_chunk(vp::io_req *req, injector_split_t *split, uint64_t offset, uint64_t size);
+  void shm_send_waiting();
   void binding_routine();
+  void binding_routine_shm();
+  int shm_init(int fd);
 
 };
 
@@ -70,6 +101,9 @@ vp::io_req_status_e injector::req(void *__this, vp::io_req *req)
 
   _this->trace.msg("IO access (offset: 0x%lx, size: 0x%lx, is_write: %d)\n", offset, size, req->get_is_write());
 
+  if (_this->shm)
+    return _this->req_shm(req);
+
   if (_this->snd_file == NULL)
   {
     _this->trace.force_warning("Accessing injector while it is not connected\n");
@@ -88,6 +122,229 @@ vp::io_req_status_e injector::req(void *__this, vp::io_req *req)
   return vp::IO_REQ_PENDING;
 }
 
+// Pushes a slot of the request, returns false if no slot is free. The engine
+// must not wait for slots, as the binding thread may be waiting for the
+// engine lock before it can release them.
+bool injector::shm_send_chunk(vp::io_req *req, injector_split_t *split, uint64_t offset, uint64_t size)
+{
+  uint32_t index;
+  {
+    std::lock_guard<std::mutex> lock(this->slots_lock);
+    if (this->free_slots.empty()) return false;
+    index = this->free_slots.back();
+    this->free_slots.pop_back();
+  }
+
+  gv_ioreq_desc_t *desc = gv_shm_slot(this->shm, index);
+  desc->type = GV_IOREQ_DESC_TYPE_REQUEST;
+  desc->addr = req->get_addr() + offset;
+  desc->size = size;
+  desc->is_write = req->get_is_write();
+  desc->timestamp = this->get_time();
+  desc->response_cb = NULL;
+  desc->response_context = (void *)split;
+  desc->binding = this->binding_context;
+  desc->req = (void *)req;
+  desc->data = req->get_data() + offset;
+
+  if (desc->is_write) memcpy(gv_shm_slot_data(desc), desc->data, size);
+
+  std::lock_guard<std::mutex> lock(this->shm_lock);
+  gv_shm_ring_push(this->shm, GV_SHM_TO_HOST, index);
+
+  return true;
+}
+
+// Sends the slots of the waiting requests, in order, until no slot is free
+void injector::shm_send_waiting()
+{
+  bool sent = false;
+
+  while (!this->waiting_reqs.empty())
+  {
+    injector_split_t *split = this->waiting_reqs.front();
+    uint64_t size = split->req->get_size();
+
+    for (; split->chunk<split->nb_chunks; split->chunk++)
+    {
+      uint64_t offset = split->chunk * this->shm->slot_size;
+      uint64_t chunk_size = size - offset < this->shm->slot_size ? size - offset : this->shm->slot_size;
+
+      if (!this->shm_send_chunk(split->req, split, offset, chunk_size))
+        goto end;
+
+      sent = true;
+    }
+
+    this->waiting_reqs.pop_front();
+  }
+
+end:
+  if (sent)
+    gv_shm_ring_notify(this->shm, GV_SHM_TO_HOST);
+}
+
+vp::io_req_status_e injector::req_shm(vp::io_req *req)
+{
+  uint64_t size = req->get_size();
+  uint64_t nb_chunks = size == 0 ? 1 : (size + this->shm->slot_size - 1) / this->shm->slot_size;
+
+  // Fast path for requests fitting a slot
+  if (nb_chunks == 1 && this->waiting_reqs.empty() && this->shm_send_chunk(req, NULL, 0, size))
+  {
+    gv_shm_ring_notify(this->shm, GV_SHM_TO_HOST);
+    return vp::IO_REQ_PENDING;
+  }
+
+  // Otherwise the request is sent as slots get free, and gets its response
+  // once all its slots are done
+  injector_split_t *split = new injector_split_t;
+  split->req = req;
+  split->remaining = nb_chunks;
+  split->nb_chunks = nb_chunks;
+  split->chunk = 0;
+
+  if (!this->waiting_reqs.empty())
+    this->trace.msg("Waiting for free slots (pending: %ld)\n", (long)this->waiting_reqs.size());
+
+  this->waiting_reqs.push_back(split);
+  this->shm_send_waiting();
+
+  return vp::IO_REQ_PENDING;
+}
+
+void injector::binding_routine_shm()
+{
+  this->get_clock()->get_engine()->wait_running();
+
+  std::vector<uint32_t> indexes(this->shm->ring_size);
+  std::vector<uint32_t> requests;
+  std::vector<std::pair<vp::io_req *, injector_split_t *>> responses;
+
+  while(1)
+  {
+    int count = gv_shm_ring_pop(this->shm, GV_SHM_TO_FABRIC, indexes.data(), indexes.size());
+    if (count == 0)
+    {
+      gv_shm_ring_wait(this->shm, GV_SHM_TO_FABRIC);
+      continue;
+    }
+
+    // Responses to the platform requests release their slots before the
+    // engine lock is taken, as the engine may be waiting for them
+    for (int i=0; i<count; i++)
+    {
+      uint32_t index = indexes[i];
+      if (!(index & GV_SHM_SLOT_FABRIC))
+      {
+        requests.push_back(index);
+        continue;
+      }
+
+      gv_ioreq_desc_t *desc = gv_shm_slot(this->shm, index);
+      vp::io_req *ioreq = (vp::io_req *)desc->req;
+      injector_split_t *split = (injector_split_t *)desc->response_context;
+
+      if (!desc->is_write) memcpy(desc->data, gv_shm_slot_data(desc), desc->size);
+
+      {
+        std::lock_guard<std::mutex> lock(this->slots_lock);
+        this->free_slots.push_back(index & ~GV_SHM_SLOT_FABRIC);
+      }
+
+      // The split is only updated with the engine locked, as the engine
+      // thread may still be sending its slots
+      responses.push_back(std::make_pair(ioreq, split));
+    }
+
+    // All the requests and responses of the batch are handled under a single
+    // engine lock
+    this->get_clock()->get_engine()->lock();
+
+    // Released slots first go to the platform requests waiting for them
+    this->shm_send_waiting();
+
+    for (auto index: requests)
+    {
+      gv_ioreq_desc_t *req = gv_shm_slot(this->shm, index);
+
+      this->trace.msg("Received IO req from external binding (addr: 0x%llx, size: 0x%llx, is_write: %d)\n", req->addr, req->size, req->is_write);
+
+      // The payload is accessed in place
+      vp::io_req *io_req = &ext_req;
+      io_req->init();
+      io_req->set_addr(req->addr);
+      io_req->set_size(req->size);
+      io_req->set_is_write(req->is_write);
+      io_req->set_data(gv_shm_slot_data(req));
+
+      this->get_clock()->sync();
+
+      int err = this->out.req(io_req);
+
+      req->user_req.state = err != vp::IO_REQ_OK ? GV_IOREQ_DONE_ERROR : GV_IOREQ_DONE;
+      req->user_req.latency = this->get_time() + io_req->get_latency() + io_req->get_duration();
+      req->type = GV_IOREQ_DESC_TYPE_RESPONSE;
+    }
+
+    for (auto response: responses)
+    {
+      vp::io_req *ioreq = response.first;
+      injector_split_t *split = response.second;
+
+      if (split != NULL)
+      {
+        if (--split->remaining != 0)
+          continue;
+        delete split;
+      }
+
+      ioreq->set_latency(0);
+      ioreq->get_resp_port()->resp(ioreq);
+    }
+
+    this->get_clock()->get_engine()->unlock();
+
+    if (requests.size())
+    {
+      std::lock_guard<std::mutex> lock(this->shm_lock);
+      for (auto index: requests)
+      {
+        gv_shm_ring_push(this->shm, GV_SHM_TO_HOST, index);
+      }
+    }
+
+    gv_shm_ring_notify(this->shm, GV_SHM_TO_HOST);
+
+    requests.clear();
+    responses.clear();
+  }
+}
+
+int injector::shm_init(int fd)
+{
+  struct stat st;
+  if (fstat(fd, &st) == -1)
+  {
+    snprintf(vp_error, VP_ERROR_SIZE, "Failed to get shared memory size: %s",  strerror(errno));
+    return -1;
+  }
+
+  this->shm = (gv_shm_header_t *)mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (this->shm == MAP_FAILED || __atomic_load_n(&this->shm->magic, __ATOMIC_ACQUIRE) != GV_SHM_MAGIC)
+  {
+    snprintf(vp_error, VP_ERROR_SIZE, "Failed to map shared memory: %s",  strerror(errno));
+    return -1;
+  }
+
+  for (uint32_t i=0; i<this->shm->nb_slots; i++)
+  {
+    this->free_slots.push_back(i | GV_SHM_SLOT_FABRIC);
+  }
+
+  return 0;
+}
+
 void injector::binding_routine()
 {
   this->get_clock()->get_engine()->wait_running();
@@ -164,6 +421,16 @@ int injector::build()
 
   this->binding_context = (void *)(long)this->get_config_int("context");
 
+  // The launcher gives a shared memory instead of pipes when it uses the
+  // shared-memory transport
+  this->shm = NULL;
+  js::config *shm_fd = this->get_js_config()->get("shm_fd");
+  if (shm_fd && shm_fd->get_int() != -1)
+  {
+    if (this->shm_init(shm_fd->get_int()))
+      return -1;
+  }
+
   if (snd_fd != -1)
   {
     snd_file = fdopen(snd_fd, "w");
@@ -197,7 +464,12 @@ int injector::build()
 
 void injector::start()
 {
-  if (rcv_file)
+  if (this->shm)
+  {
+    this->get_clock()->retain();
+    new std::thread(&injector::binding_routine_shm, this);
+  }
+  else if (rcv_file)
   {
     this->get_clock()->retain();
     new std::thread(&injector::binding_routine, this);
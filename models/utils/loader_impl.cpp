@@ -44,7 +44,7 @@ public:
 
 private:
 
-  void do_io_req(uint64_t addr, uint64_t size, bool is_write, uint8_t *data);
+  void do_io_req(uint64_t addr, uint64_t size, bool is_write, uint8_t *req_data);
   std::list<vp::io_req *> pending_reqs;
   vp::trace     trace;
   vp::io_master out;
@@ -75,7 +75,7 @@ void loader::response(void *__this, vp::io_req *req)
 {
   loader *_this = (loader *)__this;
   _this->pending_reqs.pop_front();
-  delete req->get_data();
+  delete[] req->get_data();
   _this->out.req_del(req);
 
   while(1)
@@ -103,13 +103,10 @@ void loader::start()
 {
 }
 
-void loader::do_io_req(uint64_t addr, uint64_t size, bool is_write, uint8_t *data)
+// The request takes ownership of req_data, which is freed with the request
+void loader::do_io_req(uint64_t addr, uint64_t size, bool is_write, uint8_t *req_data)
 {
-
-  void *req_data = new uint8_t[size];
-  memcpy(req_data, data, size);
-
-  vp::io_req *req = out.req_new(addr, (uint8_t *)req_data, size, is_write);
+  vp::io_req *req = out.req_new(addr, req_data, size, is_write);
 
   if (!this->pending_reqs.empty())
   {
@@ -128,17 +125,54 @@ void loader::io_req(uint64_t addr, uint64_t size, bool is_write, uint8_t *data)
 {
   trace.msg("Loading section (base: 0x%x, size: 0x%x, is_write: %d)\n", addr, size, is_write);
 
-  this->do_io_req(addr, size, is_write, data);
+  // Sections are directly copied to the target storage when the target gives
+  // access to it, then written with debug accesses, which can go through
+  // interleaved memories, and are otherwise sent through io requests.
+  // Once some io requests are pending, all sections go through io requests
+  // so that they are written in order, as they may overlap.
+  if (is_write && this->pending_reqs.empty())
+  {
+    uint8_t *target = this->out.backdoor(addr, size, true);
+    if (target)
+    {
+      ::memcpy(target, data, size);
+      return;
+    }
+
+    if (this->out.debug_write(addr, size, data) == vp::IO_REQ_OK)
+      return;
+  }
+
+  uint8_t *req_data = new uint8_t[size];
+  ::memcpy(req_data, data, size);
+  this->do_io_req(addr, size, is_write, req_data);
 }
 
 void loader::memset(uint64_t addr, uint64_t size, uint8_t value)
 {
   trace.msg("Padding section (base: 0x%x, size: 0x%x, value: %d)\n", addr, size, value);
 
-  uint8_t data[size];
-  ::memset((void *)data, value, size);
+  // Same ordering constraint as for sections
+  if (this->pending_reqs.empty())
+  {
+    uint8_t *target = this->out.backdoor(addr, size, true);
+    if (target)
+    {
+      ::memset(target, value, size);
+      return;
+    }
+  }
+
+  uint8_t *req_data = new uint8_t[size];
+  ::memset(req_data, value, size);
+
+  if (this->pending_reqs.empty() && this->out.debug_write(addr, size, req_data) == vp::IO_REQ_OK)
+  {
+    delete[] req_data;
+    return;
+  }
 
-  this->do_io_req(addr, size, true, data);
+  this->do_io_req(addr, size, true, req_data);
 }
 
 extern "C" void loader_io_req(void *__this, uint64_t addr, uint64_t size, bool is_write, uint8_t *data)
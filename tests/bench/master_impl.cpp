@@ -25,6 +25,8 @@
 
 #define ENQUEUE_ITER 100000000
 #define CALL_ITER 100000000
+#define MEM_ITER 100000000
+#define MEM_SIZE (1<<20)
 
 class master : public vp::component
 {
@@ -45,6 +47,8 @@ public:
   static void test_enqueue_var(void *_this, vp::clock_event *event);
   static void test_call(void *_this, vp::clock_event *event);
   static void test_call_sync(void *_this, vp::clock_event *event);
+  static void test_mem(void *_this, vp::clock_event *event);
+  static void test_mem_check(void *_this, vp::clock_event *event);
 
   static void test(void *_this, vp::clock_event *event);
 
@@ -56,6 +60,8 @@ private:
 
   vp::trace trace;
   vp::io_master out;
+  vp::io_master mem;
+  vp::io_master mem_check;
   int step;
   int delay;
 };
@@ -262,6 +268,48 @@ void master::test_call_sync(void *__this, vp::clock_event *event)
   _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
 }
 
+static void bench_mem(vp::io_master *itf)
+{
+  uint32_t value = 0;
+  vp::io_req *req = itf->req_new(0, (uint8_t *)&value, 4, true);
+
+  // Initialize the whole memory first so that reads are valid
+  for (int i=0; i<MEM_SIZE; i+=4)
+  {
+    req->set_addr(i);
+    itf->req(req);
+  }
+
+  clock_t start = ::clock();
+
+  for (int i=0; i<MEM_ITER; i++)
+  {
+    req->set_addr((i*4) & (MEM_SIZE - 1));
+    req->set_is_write(i & 1);
+    itf->req(req);
+  }
+
+  clock_t end = ::clock();
+  double time_elapsed_in_seconds = (end - start)/(double)CLOCKS_PER_SEC;
+  printf("%f\n", MEM_ITER / time_elapsed_in_seconds / 1000000);
+
+  itf->req_del(req);
+}
+
+void master::test_mem(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+  bench_mem(&_this->mem);
+  _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
+}
+
+void master::test_mem_check(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+  bench_mem(&_this->mem_check);
+  _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
+}
+
 void master::test(void *__this, vp::clock_event *event)
 {
   master *_this = (master *)__this;
@@ -313,6 +361,16 @@ void master::test(void *__this, vp::clock_event *event)
       _this->event = _this->event_new(master::test_call_sync);
       _this->event_enqueue(_this->event, 1);
       break;
+    case 8:
+      printf("Benchmarking memory accesses without uninitialized access check\n");
+      _this->event = _this->event_new(master::test_mem);
+      _this->event_enqueue(_this->event, 1);
+      break;
+    case 9:
+      printf("Benchmarking memory accesses with uninitialized access check\n");
+      _this->event = _this->event_new(master::test_mem_check);
+      _this->event_enqueue(_this->event, 1);
+      break;
     default:
       exit(0);
   }
@@ -333,6 +391,12 @@ int master::build()
 
   new_master_port("out", &out);
 
+  mem.set_resp_meth(&master::resp);
+  new_master_port("mem", &mem);
+
+  mem_check.set_resp_meth(&master::resp);
+  new_master_port("mem_check", &mem_check);
+
   return 0;
 }
 
@@ -28,6 +28,18 @@ class component(vp.component):
 
         slave = self.new('slave', component='slave', config=self.get_config())
 
+        mem = self.new('mem', component='memory/memory', config=self.get_config().get_config('mem'))
+
+        mem_check = self.new('mem_check', component='memory/memory', config=self.get_config().get_config('mem_check'))
+
         master.get_port('out').bind_to(slave.get_port('in'))
 
+        master.get_port('mem').bind_to(mem.get_port('input'))
+
+        master.get_port('mem_check').bind_to(mem_check.get_port('input'))
+
         clock.get_port('out').bind_to(master.get_port('clock'))
+
+        clock.get_port('out').bind_to(mem.get_port('clock'))
+
+        clock.get_port('out').bind_to(mem_check.get_port('clock'))
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <stdio.h>
+#include <time.h>
+
+#define WORK_ITER 200
+
+// Emulates a boot phase initializing the memory, followed by a short
+// workload reading it back. The checksum printed at the end must be the same
+// for a full run and for a run restored from a checkpoint taken at the end
+// of the boot phase.
+
+class master : public vp::component
+{
+
+public:
+
+  master(const char *config);
+
+  int build();
+
+  void start();
+
+  void save(vp::checkpoint *checkpoint);
+
+  void restore(vp::checkpoint *checkpoint);
+
+  static void exec(void *_this, vp::clock_event *event);
+
+private:
+
+  vp::trace trace;
+  vp::io_master out;
+  vp::clock_event *event;
+
+  vp::io_req *req;
+  uint32_t data;
+
+  int64_t boot_cycles;
+  int64_t work_cycles;
+  int64_t cycle;
+  uint64_t value;
+  uint64_t checksum;
+  struct timespec start_time;
+};
+
+void master::exec(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  for (int i=0; i<WORK_ITER; i++)
+  {
+    _this->value = _this->value * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+
+  bool is_boot = _this->cycle < _this->boot_cycles;
+
+  _this->data = _this->value;
+  _this->req->init();
+  _this->req->set_addr((_this->value >> 32) & 0xffffc);
+  _this->req->set_size(4);
+  _this->req->set_data((uint8_t *)&_this->data);
+  _this->req->set_is_write(is_boot);
+  _this->out.req(_this->req);
+
+  if (!is_boot)
+    _this->checksum += _this->data;
+
+  _this->cycle++;
+
+  if (_this->cycle == _this->boot_cycles + _this->work_cycles)
+  {
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double time_elapsed_in_seconds = (end_time.tv_sec - _this->start_time.tv_sec) +
+      (end_time.tv_nsec - _this->start_time.tv_nsec) / 1e9;
+    printf("%s: %f s (checksum: 0x%lx)\n", _this->get_path().c_str(),
+      time_elapsed_in_seconds, _this->checksum);
+  }
+  else
+  {
+    _this->event_enqueue(_this->event, 1);
+  }
+}
+
+void master::save(vp::checkpoint *checkpoint)
+{
+  checkpoint->write<int64_t>(this->cycle);
+  checkpoint->write<uint64_t>(this->value);
+  checkpoint->write<uint64_t>(this->checksum);
+}
+
+void master::restore(vp::checkpoint *checkpoint)
+{
+  this->cycle = checkpoint->read<int64_t>();
+  this->value = checkpoint->read<uint64_t>();
+  this->checksum = checkpoint->read<uint64_t>();
+}
+
+int master::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  new_master_port("out", &out);
+
+  event = event_new(master::exec);
+
+  return 0;
+}
+
+void master::start()
+{
+  boot_cycles = get_config_int("boot_cycles");
+  work_cycles = get_config_int("work_cycles");
+  cycle = 0;
+  value = 1;
+  checksum = 0;
+  req = out.req_new(0, NULL, 0, false);
+
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  event_enqueue(event, 1);
+}
+
+
+master::master(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new master(config);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <stdio.h>
+#include <time.h>
+
+// Does the configuration accesses of a typical model during its build, to
+// measure their cost on platforms with many components.
+// The component configuration is accessed with exact and glob paths through
+// the memoized accessor used by the models, and a binding-like configuration
+// is parsed and accessed the same way as the router does for its mappings.
+
+class reader : public vp::component
+{
+
+public:
+
+  reader(const char *config);
+
+  int build();
+
+private:
+  static int nb_built;
+  static double total_time;
+};
+
+int reader::nb_built = 0;
+double reader::total_time = 0;
+
+int reader::build()
+{
+  struct timespec start_time, end_time;
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  int nb_lookups = get_config_int("nb_lookups");
+  int64_t value = 0;
+
+  for (int i=0; i<nb_lookups; i++)
+  {
+    value += this->get_js_config("timing/latency")->get_int();
+    value += this->get_js_config("**/stall/period")->get_int();
+    value += this->get_js_config("**/cycles")->get_int();
+    value += this->get_js_config("power/*/unit") != NULL;
+  }
+
+  vp::config *mapping = this->import_config(get_config_str("mapping").c_str());
+  for (int i=0; i<nb_lookups; i++)
+  {
+    value += mapping->get("base")->get_int();
+    value += mapping->get("size")->get_int();
+    value += mapping->get("**/latency")->get_int();
+    value += mapping->get("add_offset") != NULL;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+  total_time += (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+  nb_built++;
+
+  if (nb_built == get_config_int("nb_readers"))
+  {
+    printf("%d components: config accesses in %f s\n", nb_built, total_time);
+  }
+
+  if (value == 0)
+    return -1;
+
+  return 0;
+}
+
+reader::reader(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new reader(config);
+}
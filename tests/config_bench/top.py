@@ -0,0 +1,30 @@
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ 
+import vp_core as vp
+
+class component(vp.component):
+
+    def build(self):
+
+        config_path = self.get_config_path()
+        if config_path is not None:
+            config_path = 'reader' if config_path == '' else config_path + '/reader'
+
+        for i in range(0, self.get_json().get('reader').get_child_int('nb_readers')):
+            self.new('reader_%d' % i, component='reader', config=self.get_json().get('reader'), config_path=config_path)
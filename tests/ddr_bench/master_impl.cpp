@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <stdio.h>
+#include <time.h>
+
+#define NB_REQS 10000000
+#define REQ_SIZE 64
+#define NB_OUTSTANDING 32
+
+// Traffic generator for the ddr model.
+// The first step sends isolated requests, a row miss, a row hit and a row
+// conflict, and checks their latency against the ddr timings.
+// Each of the next steps sends NB_REQS requests with a different address
+// pattern, keeping NB_OUTSTANDING requests in flight, which is more than the
+// ddr queue so that requests get denied and granted. It reports the simulated
+// bandwidth against the peak bus bandwidth and the host throughput, and
+// checks the bandwidth against the bounds given by the ddr timings.
+// The simulation exits with an error if any check fails.
+
+class master : public vp::component
+{
+
+public:
+
+  master(const char *config);
+
+  int build();
+
+  void start();
+
+  static void test(void *_this, vp::clock_event *event);
+
+  static void resp(void *_this, vp::io_req *req);
+  static void grant(void *_this, vp::io_req *req);
+
+private:
+
+  void fill();
+  uint64_t get_addr();
+  void send_latency_req();
+  void check_latency(vp::io_req *req);
+  void check_bandwidth(double efficiency);
+
+  vp::trace trace;
+  vp::io_master out;
+  vp::clock_event *event;
+  int step;
+
+  vp::io_req reqs[NB_OUTSTANDING];
+  uint8_t data[NB_OUTSTANDING][REQ_SIZE];
+  vp::io_req *free_reqs[NB_OUTSTANDING];
+  int nb_free_reqs;
+
+  bool stalled;
+  int nb_sent;
+  int nb_done;
+  uint64_t size;
+  int bus_width;
+  int queue_size;
+  int t_rcd;
+  int t_rp;
+  int t_cas;
+  int t_ras;
+  int t_refi;
+  int t_rfc;
+  uint64_t current_addr;
+  uint64_t seed;
+  int64_t start_cycle;
+  clock_t start_time;
+
+  int nb_denied;
+  double seq_efficiency;
+  int errors = 0;
+
+  // Isolated requests of the latency step, with their expected latency
+  int latency_index;
+  int64_t latency_req_cycle;
+  uint64_t latency_addr[3];
+  int64_t latency_expected[3];
+};
+
+void master::send_latency_req()
+{
+  vp::io_req *req = this->free_reqs[--this->nb_free_reqs];
+
+  req->init();
+  req->set_addr(this->latency_addr[this->latency_index]);
+  req->set_is_write(false);
+  this->latency_req_cycle = this->get_cycles();
+
+  vp::io_req_status_e status = this->out.req(req);
+  if (status != vp::IO_REQ_PENDING)
+  {
+    this->trace.fatal("Unexpected status for isolated request (status: %d)\n", status);
+    return;
+  }
+}
+
+void master::check_latency(vp::io_req *req)
+{
+  static const char *names[] = { "row miss", "row hit", "row conflict" };
+  int64_t latency = this->get_cycles() - this->latency_req_cycle;
+  int64_t expected = this->latency_expected[this->latency_index];
+
+  printf("Latency of %s: %ld cycles (expected: %ld)\n", names[this->latency_index], latency, expected);
+
+  if (latency != expected)
+    this->errors++;
+
+  this->free_reqs[this->nb_free_reqs++] = req;
+  this->latency_index++;
+
+  if (this->latency_index < 3)
+    this->send_latency_req();
+  else
+    this->event_enqueue(this->event, 1);
+}
+
+// The bounds only depend on the ddr timings. Every tREFI cycles, the bus is
+// blocked by a refresh during tRFC, which can be partly hidden by the
+// requests issued in advance, and the rows are closed, so the first
+// request after it pays the activation. With sequential accesses, the row
+// changes are hidden by the scheduler. With random accesses, in the worst
+// case each request conflicts with the previous one on the same bank.
+void master::check_bandwidth(double efficiency)
+{
+  int burst = REQ_SIZE / this->bus_width;
+  int lookahead = this->t_rp + this->t_rcd + this->t_cas;
+  double refresh_min = (double)(this->t_rfc - lookahead) / this->t_refi;
+  double refresh_max = (double)(this->t_rfc + this->t_rcd + this->t_cas + burst) / this->t_refi;
+  double min, max;
+
+  if (this->step == 2)
+  {
+    min = 1 - refresh_max;
+    max = 1 - refresh_min;
+    this->seq_efficiency = efficiency;
+  }
+  else
+  {
+    int period = this->t_ras + this->t_rp;
+    if (period < lookahead + burst)
+      period = lookahead + burst;
+    min = (double)burst / period * (1 - refresh_max);
+    max = this->seq_efficiency;
+  }
+
+  printf("Expected bus efficiency: [%f, %f]\n", min, max);
+  printf("Denied requests: %d\n", this->nb_denied);
+
+  // Small margin for the first requests, which fill the pipeline
+  if (efficiency < min - 0.001 || efficiency > max)
+  {
+    printf("Bus efficiency is out of bounds\n");
+    this->errors++;
+  }
+
+  if (this->nb_denied == 0)
+  {
+    printf("No request was denied, the queue was never full\n");
+    this->errors++;
+  }
+}
+
+uint64_t master::get_addr()
+{
+  if (this->step == 2)
+  {
+    uint64_t addr = this->current_addr;
+    this->current_addr = (this->current_addr + REQ_SIZE) % this->size;
+    return addr;
+  }
+  else
+  {
+    this->seed = this->seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return ((this->seed >> 16) % (this->size / REQ_SIZE)) * REQ_SIZE;
+  }
+}
+
+void master::fill()
+{
+  while (this->nb_free_reqs && !this->stalled && this->nb_sent < NB_REQS)
+  {
+    vp::io_req *req = this->free_reqs[--this->nb_free_reqs];
+
+    req->init();
+    req->set_addr(this->get_addr());
+    req->set_is_write(this->nb_sent & 1);
+    this->nb_sent++;
+
+    vp::io_req_status_e status = this->out.req(req);
+
+    if (status == vp::IO_REQ_OK)
+    {
+      this->nb_done++;
+      this->free_reqs[this->nb_free_reqs++] = req;
+    }
+    else if (status == vp::IO_REQ_DENIED)
+    {
+      this->nb_denied++;
+      this->stalled = true;
+    }
+    else if (status == vp::IO_REQ_INVALID)
+    {
+      this->trace.fatal("Received invalid response\n");
+      return;
+    }
+  }
+
+  if (this->nb_done == NB_REQS)
+  {
+    clock_t end = ::clock();
+    double time_elapsed_in_seconds = (end - this->start_time)/(double)CLOCKS_PER_SEC;
+    int64_t cycles = this->get_cycles() - this->start_cycle;
+    double bandwidth = (double)NB_REQS * REQ_SIZE / cycles;
+
+    printf("Simulated cycles per request: %f\n", (double)cycles / NB_REQS);
+    printf("Bus efficiency: %f\n", bandwidth / this->bus_width);
+    printf("Host throughput (Mreq/s): %f\n", NB_REQS / time_elapsed_in_seconds / 1000000);
+
+    this->check_bandwidth(bandwidth / this->bus_width);
+
+    this->event_enqueue(this->event, 1);
+  }
+}
+
+void master::test(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  _this->step++;
+
+  switch (_this->step)
+  {
+    case 1:
+      printf("Checking ddr latency with %d bytes accesses\n", REQ_SIZE);
+      _this->latency_index = 0;
+      _this->send_latency_req();
+      return;
+    case 2:
+      printf("Benchmarking ddr with sequential %d bytes accesses\n", REQ_SIZE);
+      break;
+    case 3:
+      printf("Benchmarking ddr with random %d bytes accesses\n", REQ_SIZE);
+      break;
+    default:
+      if (_this->errors)
+        printf("Found %d errors\n", _this->errors);
+      exit(_this->errors ? 1 : 0);
+  }
+
+  _this->nb_sent = 0;
+  _this->nb_denied = 0;
+  _this->nb_done = 0;
+  _this->stalled = false;
+  _this->current_addr = 0;
+  _this->seed = 1;
+  _this->start_cycle = _this->get_cycles();
+  _this->start_time = ::clock();
+
+  _this->fill();
+}
+
+void master::resp(void *__this, vp::io_req *req)
+{
+  master *_this = (master *)__this;
+
+  if (_this->step == 1)
+  {
+    _this->check_latency(req);
+    return;
+  }
+
+  _this->nb_done++;
+  _this->free_reqs[_this->nb_free_reqs++] = req;
+  _this->fill();
+}
+
+void master::grant(void *__this, vp::io_req *req)
+{
+  master *_this = (master *)__this;
+  _this->stalled = false;
+  _this->fill();
+}
+
+int master::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  out.set_resp_meth(&master::resp);
+  out.set_grant_meth(&master::grant);
+  new_master_port("out", &out);
+
+  event = event_new(master::test);
+
+  return 0;
+}
+
+void master::start()
+{
+  size = get_config_int("size");
+  bus_width = get_config_int("bus_width");
+  queue_size = get_config_int("queue_size");
+
+  // The master gets the ddr configuration, to know the expected timings
+  js::config *timing = get_js_config()->get("timing");
+  t_rcd = timing->get_child_int("tRCD");
+  t_rp = timing->get_child_int("tRP");
+  t_cas = timing->get_child_int("tCAS");
+  t_ras = timing->get_child_int("tRAS");
+  t_refi = timing->get_child_int("tREFI");
+  t_rfc = timing->get_child_int("tRFC");
+
+  if (NB_OUTSTANDING <= queue_size)
+    this->trace.fatal("The number of outstanding requests must be above the ddr queue size to test denials\n");
+
+  // The ddr accepts a request in the cycle after it is received. A row miss
+  // opens the row, a row hit only reads it, and a row conflict on the same
+  // bank first closes the open row, whose activation is old enough for
+  // tRAS. The data transfer then takes one burst.
+  int nb_banks = get_config_int("nb_banks");
+  int row_size = get_config_int("row_size");
+  int burst = REQ_SIZE / bus_width;
+  latency_addr[0] = 0;
+  latency_expected[0] = 1 + t_rcd + t_cas + burst;
+  latency_addr[1] = REQ_SIZE;
+  latency_expected[1] = 1 + t_cas + burst;
+  latency_addr[2] = (uint64_t)row_size * nb_banks;
+  latency_expected[2] = 1 + t_rp + t_rcd + t_cas + burst;
+
+  for (int i=0; i<NB_OUTSTANDING; i++)
+  {
+    reqs[i].set_data(data[i]);
+    reqs[i].set_size(REQ_SIZE);
+    free_reqs[i] = &reqs[i];
+  }
+  nb_free_reqs = NB_OUTSTANDING;
+
+  step = 0;
+  event_enqueue(event, 1);
+}
+
+
+master::master(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new master(config);
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/launcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+
+// External testbench streaming memory requests to the platform through the
+// injector, to measure the throughput of the launcher transport.
+// Requests are sent with a window of outstanding requests, alternating
+// writes and reads over the memory, either one by one with callbacks (cb),
+// in batches of vectored requests (async), or as bulk loads and dumps of the
+// whole window (bulk).
+//
+// Usage: host <config> <pipe|shm> <cb|async|bulk> <nb_reqs> <size> <window>
+
+static volatile int nb_pending = 0;
+static volatile int nb_errors = 0;
+
+static void response(void *context, gv_ioreq_t *req)
+{
+  if (req->state != GV_IOREQ_DONE)
+    __atomic_add_fetch(&nb_errors, 1, __ATOMIC_SEQ_CST);
+  __atomic_sub_fetch(&nb_pending, 1, __ATOMIC_SEQ_CST);
+}
+
+static int run_cb(void *binding, uint8_t *buffers, long nb_reqs, int size, int window, int mem_size)
+{
+  for (long i=0; i<nb_reqs; i++)
+  {
+    while (__atomic_load_n(&nb_pending, __ATOMIC_SEQ_CST) >= window)
+      sched_yield();
+
+    __atomic_add_fetch(&nb_pending, 1, __ATOMIC_SEQ_CST);
+
+    uint64_t addr = (i * size) % (mem_size - size);
+    if (gv_ioreq(binding, 0, buffers + (i % window) * size, (void *)addr, size, i & 1, response, NULL))
+      return -1;
+  }
+
+  while (__atomic_load_n(&nb_pending, __ATOMIC_SEQ_CST) != 0)
+    sched_yield();
+
+  return 0;
+}
+
+static int run_async(void *binding, uint8_t *buffers, long nb_reqs, int size, int window, int mem_size)
+{
+  gv_iovec_t *iov = (gv_iovec_t *)malloc(sizeof(gv_iovec_t) * window);
+  gv_ioreq_vec_t *reqs = (gv_ioreq_vec_t *)malloc(sizeof(gv_ioreq_vec_t) * window);
+  gv_ioreq_completion_t *completions = (gv_ioreq_completion_t *)malloc(sizeof(gv_ioreq_completion_t) * window);
+  if (iov == NULL || reqs == NULL || completions == NULL) return -1;
+
+  long i = 0;
+  while (i < nb_reqs)
+  {
+    int nb = nb_reqs - i < window ? nb_reqs - i : window;
+
+    for (int j=0; j<nb; j++, i++)
+    {
+      iov[j].data = buffers + j * size;
+      iov[j].size = size;
+      reqs[j].addr = (i * size) % (mem_size - size);
+      reqs[j].iov = &iov[j];
+      reqs[j].iovcnt = 1;
+      reqs[j].is_write = i & 1;
+      reqs[j].timestamp = 0;
+      reqs[j].tag = i;
+    }
+
+    if (gv_ioreq_submit(binding, reqs, nb) != nb) return -1;
+
+    int done = 0;
+    while (done < nb)
+    {
+      int count = gv_ioreq_wait(binding, completions, 1, window);
+      for (int j=0; j<count; j++)
+      {
+        if (completions[j].state != GV_IOREQ_DONE)
+          nb_errors++;
+      }
+      done += count;
+    }
+  }
+
+  free(completions);
+  free(reqs);
+  free(iov);
+
+  return 0;
+}
+
+static int run_bulk(void *binding, uint8_t *buffers, long nb_reqs, int size, int window, int mem_size)
+{
+  size_t bulk_size = (size_t)size * window;
+
+  for (long i=0; i<nb_reqs; i+=window)
+  {
+    uint64_t addr = (i * size) % (mem_size - bulk_size);
+    int err = (i / window) & 1 ?
+      gv_ioreq_load(binding, (void *)addr, buffers, bulk_size) :
+      gv_ioreq_dump(binding, (void *)addr, buffers, bulk_size);
+    if (err)
+      nb_errors++;
+  }
+
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 7)
+  {
+    fprintf(stderr, "Usage: %s <config> <pipe|shm> <cb|async|bulk> <nb_reqs> <size> <window>\n", argv[0]);
+    return -1;
+  }
+
+  char *config = argv[1];
+  bool shm = strcmp(argv[2], "shm") == 0;
+  char *mode = argv[3];
+  long nb_reqs = atol(argv[4]);
+  int size = atoi(argv[5]);
+  int window = atoi(argv[6]);
+  int mem_size = 1<<20;
+
+  gv_conf_t conf;
+  gv_init(&conf);
+  conf.transport = shm ? GV_CONF_TRANSPORT_SHM : GV_CONF_TRANSPORT_PIPE;
+
+  void *gv = gv_create(&conf, config);
+  if (gv == NULL) return -1;
+
+  void *binding = gv_ioreq_binding(gv, (char *)"injector", NULL, mem_size, NULL, NULL);
+  if (binding == NULL) return -1;
+
+  if (gv_launch(gv)) return -1;
+
+  uint8_t *buffers = (uint8_t *)malloc((size_t)size * window);
+  if (buffers == NULL) return -1;
+  memset(buffers, 0x5a, (size_t)size * window);
+
+  struct timespec start_time;
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  int err;
+  if (strcmp(mode, "async") == 0)
+    err = run_async(binding, buffers, nb_reqs, size, window, mem_size);
+  else if (strcmp(mode, "bulk") == 0)
+    err = run_bulk(binding, buffers, nb_reqs, size, window, mem_size);
+  else
+    err = run_cb(binding, buffers, nb_reqs, size, window, mem_size);
+  if (err) return -1;
+
+  struct timespec end_time;
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+  double time_elapsed_in_seconds = (end_time.tv_sec - start_time.tv_sec) +
+    (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+
+  printf("%s %s: %ld requests of %d bytes in %f s (%f Kreq/s, %f MB/s, errors: %d)\n", argv[2], mode, nb_reqs, size,
+    time_elapsed_in_seconds, nb_reqs / time_elapsed_in_seconds / 1e3,
+    nb_reqs * (double)size / time_elapsed_in_seconds / 1e6, nb_errors);
+
+  gv_destroy(gv);
+
+  return nb_errors != 0;
+}
@@ -0,0 +1,35 @@
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ 
+import vp_core as vp
+
+class component(vp.component):
+
+    def build(self):
+
+        clock = self.new('clock', component='vp/clock_domain', config=self.get_config().get_config('clock_domain'))
+
+        injector = self.new('injector', component='utils/injector', config=self.get_config().get_config('injector'))
+
+        mem = self.new('mem', component='memory/memory', config=self.get_config().get_config('mem'))
+
+        injector.get_port('output').bind_to(mem.get_port('input'))
+
+        clock.get_port('out').bind_to(injector.get_port('clock'))
+
+        clock.get_port('out').bind_to(mem.get_port('clock'))
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <stdio.h>
+#include <time.h>
+
+#define WORK_ITER 200
+
+// Emulates a cluster executing instructions on its own clock domain, with
+// some work done at each cycle and periodic accesses to a shared memory in
+// the soc clock domain.
+
+class cluster : public vp::component
+{
+
+public:
+
+  cluster(const char *config);
+
+  int build();
+
+  void start();
+
+  static void exec(void *_this, vp::clock_event *event);
+
+  static void resp(void *_this, vp::io_req *req);
+
+private:
+
+  vp::trace trace;
+  vp::io_master out;
+  vp::clock_event *event;
+
+  vp::io_req *req;
+  uint32_t data;
+  bool pending;
+
+  int64_t nb_cycles;
+  int64_t access_period;
+  int64_t cycle;
+  uint64_t value;
+  struct timespec start_time;
+};
+
+void cluster::exec(void *__this, vp::clock_event *event)
+{
+  cluster *_this = (cluster *)__this;
+
+  for (int i=0; i<WORK_ITER; i++)
+  {
+    _this->value = _this->value * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+
+  if (_this->cycle % _this->access_period == 0 && !_this->pending)
+  {
+    _this->data = _this->value;
+    _this->req->init();
+    _this->req->set_addr((_this->value >> 32) & 0xfffc);
+    _this->req->set_size(4);
+    _this->req->set_data((uint8_t *)&_this->data);
+    _this->req->set_is_write(true);
+
+    if (_this->out.req(_this->req) == vp::IO_REQ_PENDING)
+      _this->pending = true;
+  }
+
+  _this->cycle++;
+
+  if (_this->cycle == _this->nb_cycles)
+  {
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double time_elapsed_in_seconds = (end_time.tv_sec - _this->start_time.tv_sec) +
+      (end_time.tv_nsec - _this->start_time.tv_nsec) / 1e9;
+    printf("%s: %f MCycles/s (value: 0x%lx)\n", _this->get_path().c_str(),
+      _this->nb_cycles / time_elapsed_in_seconds / 1000000, _this->value);
+  }
+  else
+  {
+    _this->event_enqueue(_this->event, 1);
+  }
+}
+
+void cluster::resp(void *__this, vp::io_req *req)
+{
+  cluster *_this = (cluster *)__this;
+  _this->pending = false;
+}
+
+int cluster::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  out.set_resp_meth(&cluster::resp);
+  new_master_port("out", &out);
+
+  event = event_new(cluster::exec);
+
+  return 0;
+}
+
+void cluster::start()
+{
+  nb_cycles = get_config_int("nb_cycles");
+  access_period = get_config_int("access_period");
+  cycle = 0;
+  value = 1;
+  pending = false;
+  req = out.req_new(0, NULL, 0, false);
+
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  event_enqueue(event, 1);
+}
+
+
+cluster::cluster(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new cluster(config);
+}
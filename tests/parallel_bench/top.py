@@ -0,0 +1,41 @@
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ 
+import vp_core as vp
+
+class component(vp.component):
+
+    def build(self):
+
+        soc_clock = self.new('soc_clock', component='vp/clock_domain', config=self.get_config().get_config('soc_clock'))
+
+        mem = self.new('mem', component='memory/memory', config=self.get_config().get_config('mem'))
+
+        soc_clock.get_port('out').bind_to(mem.get_port('clock'))
+
+        # Each cluster has its own clock domain so that it can be executed
+        # by its own thread in parallel mode
+        for i in range(0, self.get_config().get_child_int('nb_cluster')):
+
+            clock = self.new('cluster_clock_%d' % i, component='vp/clock_domain', config=self.get_config().get_config('cluster_clock'))
+
+            cluster = self.new('cluster_%d' % i, component='cluster', config=self.get_config().get_config('cluster'))
+
+            cluster.get_port('out').bind_to(mem.get_port('input'))
+
+            clock.get_port('out').bind_to(cluster.get_port('clock'))
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Small ISS workload for the profile-guided build, mixing the instruction
+// classes of typical applications: multiplications and loads in a matrix
+// multiplication, shifts and data-dependent branches in a CRC, and loads,
+// stores and compares in a sort.
+
+#define MAT_SIZE  24
+#define CRC_SIZE  4096
+#define SORT_SIZE 256
+#define NB_ITER   8
+
+static int32_t mat_a[MAT_SIZE][MAT_SIZE];
+static int32_t mat_b[MAT_SIZE][MAT_SIZE];
+static int32_t mat_c[MAT_SIZE][MAT_SIZE];
+static uint8_t crc_data[CRC_SIZE];
+static int32_t sort_data[SORT_SIZE];
+
+static uint32_t seed = 1;
+
+static uint32_t rand_next()
+{
+  seed = seed * 1664525 + 1013904223;
+  return seed;
+}
+
+static int32_t matmul()
+{
+  for (int i=0; i<MAT_SIZE; i++)
+  {
+    for (int j=0; j<MAT_SIZE; j++)
+    {
+      int32_t sum = 0;
+      for (int k=0; k<MAT_SIZE; k++)
+      {
+        sum += mat_a[i][k] * mat_b[k][j];
+      }
+      mat_c[i][j] = sum;
+    }
+  }
+
+  int32_t result = 0;
+  for (int i=0; i<MAT_SIZE; i++)
+  {
+    result += mat_c[i][i];
+  }
+  return result;
+}
+
+static uint32_t crc32()
+{
+  uint32_t crc = 0xffffffff;
+  for (int i=0; i<CRC_SIZE; i++)
+  {
+    crc ^= crc_data[i];
+    for (int j=0; j<8; j++)
+    {
+      if (crc & 1)
+        crc = (crc >> 1) ^ 0xedb88320;
+      else
+        crc = crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+static int sort()
+{
+  for (int i=1; i<SORT_SIZE; i++)
+  {
+    int32_t value = sort_data[i];
+    int j = i - 1;
+    while (j >= 0 && sort_data[j] > value)
+    {
+      sort_data[j + 1] = sort_data[j];
+      j--;
+    }
+    sort_data[j + 1] = value;
+  }
+
+  for (int i=1; i<SORT_SIZE; i++)
+  {
+    if (sort_data[i - 1] > sort_data[i])
+      return -1;
+  }
+  return 0;
+}
+
+int main()
+{
+  int errors = 0;
+  int32_t mat_result = 0;
+  uint32_t crc_result = 0;
+
+  for (int iter=0; iter<NB_ITER; iter++)
+  {
+    seed = 1;
+
+    for (int i=0; i<MAT_SIZE; i++)
+    {
+      for (int j=0; j<MAT_SIZE; j++)
+      {
+        mat_a[i][j] = (int16_t)rand_next();
+        mat_b[i][j] = (int16_t)rand_next();
+      }
+    }
+
+    for (int i=0; i<CRC_SIZE; i++)
+    {
+      crc_data[i] = rand_next() >> 24;
+    }
+
+    for (int i=0; i<SORT_SIZE; i++)
+    {
+      sort_data[i] = rand_next();
+    }
+
+    int32_t mat = matmul();
+    uint32_t crc = crc32();
+
+    // All iterations work on the same data
+    if (iter == 0)
+    {
+      mat_result = mat;
+      crc_result = crc;
+    }
+    else if (mat != mat_result || crc != crc_result)
+    {
+      errors++;
+    }
+
+    if (sort())
+      errors++;
+  }
+
+  printf("matmul: %ld, crc: 0x%lx, errors: %d\n", (long)mat_result, (unsigned long)crc_result, errors);
+
+  return errors;
+}
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Runs the training workloads of the profile-guided build and measures their
+# execution time, keeping the best of several runs.
+# The times can be saved as a reference, and the speedup of a build is then
+# reported against it.
+
+import argparse
+import json
+import subprocess
+import sys
+import time
+
+parser = argparse.ArgumentParser(description='Run the training workloads')
+parser.add_argument("--workload", dest="workloads", action="append", default=[], help="Specify a workload as name=command")
+parser.add_argument("--repeat", dest="repeat", type=int, default=1, help="Specify how many times each workload is run")
+parser.add_argument("--output", dest="output", default=None, help="Save the execution times to the specified file")
+parser.add_argument("--reference", dest="reference", default=None, help="Report the speedup against the execution times of the specified file")
+args = parser.parse_args()
+
+times = {}
+
+for workload in args.workloads:
+    name, cmd = workload.split('=', 1)
+
+    best = None
+    for i in range(0, args.repeat):
+        start = time.time()
+        if subprocess.run(cmd, shell=True, stdout=subprocess.DEVNULL).returncode != 0:
+            print('%s: failed (command: %s)' % (name, cmd), file=sys.stderr)
+            sys.exit(-1)
+        elapsed = time.time() - start
+        if best is None or elapsed < best:
+            best = elapsed
+
+    times[name] = best
+    print('%s: %f s' % (name, best))
+
+if args.output is not None:
+    with open(args.output, 'w') as file:
+        json.dump(times, file, indent=2)
+
+if args.reference is not None:
+    with open(args.reference) as file:
+        reference = json.load(file)
+
+    total = 0
+    total_reference = 0
+    for name, elapsed in times.items():
+        if name not in reference:
+            print('%s: missing in reference' % name)
+            continue
+        print('%s: %f s -> %f s (speedup: %.2fx)' % (name, reference[name], elapsed, reference[name] / elapsed))
+        total += elapsed
+        total_reference += reference[name]
+
+    if total != 0:
+        print('total: %f s -> %f s (speedup: %.2fx)' % (total_reference, total, total_reference / total))
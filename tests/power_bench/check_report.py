@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Computes the power report of the consumer the way the original power
+# engine does, i.e. with the energy of each event added to the totals as it
+# is accounted, and with the energy of the current cycle kept when the
+# capture starts. The report of a run is then checked against it.
+
+import argparse
+import json
+import re
+import sys
+
+parser = argparse.ArgumentParser(description='Check a power report against the reference accounting')
+parser.add_argument('--config', required=True, help='Bench configuration')
+parser.add_argument('--report', required=True, help='Power report to be checked')
+parser.add_argument('--units', type=int, default=None, help='Number of units')
+parser.add_argument('--cycles', type=int, default=None, help='Number of cycles')
+parser.add_argument('--tolerance', type=float, default=0, help='Tolerated difference, in units of the last printed digit')
+args = parser.parse_args()
+
+
+# Same interpolation as vp::Linear_table, with a single temperature
+def get_quantum(values, temp, volt):
+    table = values[str(temp)]
+    volts = sorted(table.keys(), key=float)
+    low = high = None
+    for v in volts:
+        if float(v) == volt:
+            low = high = v
+            break
+        if float(v) > volt:
+            high = v
+            break
+        low = v
+    if high is None:
+        high = low
+    if low is None:
+        low = high
+
+    if low == high:
+        return float(table[low]['any'])
+
+    low_value = float(table[low]['any'])
+    high_value = float(table[high]['any'])
+    ratio = (volt - float(low)) / (float(high) - float(low))
+    return (high_value - low_value) * ratio + low_value
+
+
+with open(args.config) as file:
+    config = json.load(file)
+
+consumer = config['consumer']
+nb_units = args.units if args.units is not None else consumer['nb_units']
+nb_cycles = args.cycles if args.cycles is not None else consumer['nb_cycles']
+start_cycle = consumer['start_cycle']
+dvfs_cycle = consumer['dvfs_cycle']
+period = 1000000000000 // config['clock']['frequency']
+
+# Default operating point, see vp/power/power.hpp
+temp = 25
+volt = 1.2
+dvfs_volt = float(consumer['dvfs_volt'])
+
+quantum = get_quantum(consumer['event']['values'], temp, volt)
+new_quantum = get_quantum(consumer['event']['values'], temp, dvfs_volt)
+leakage = get_quantum(consumer['leakage']['values'], temp, volt)
+new_leakage = get_quantum(consumer['leakage']['values'], temp, dvfs_volt)
+
+unit_totals = [0.0] * nb_units
+unit_leakages = [0.0] * nb_units
+total = 0.0
+total_leakage = 0.0
+
+value = 1
+for cycle in range(0, nb_cycles):
+    if cycle == start_cycle:
+        # The totals only keep the value of this cycle
+        top_value = 0.0
+        unit_values = [0.0] * nb_units
+
+    for i in range(0, nb_units):
+        value = (value * 1664525 + 1013904223) & 0xffffffff
+        nb_events = ((value >> 28) & 3) + ((value >> 30) & 3)
+        for j in range(0, nb_events):
+            if cycle > start_cycle:
+                unit_totals[i] += quantum
+                total += quantum
+            elif cycle == start_cycle:
+                unit_values[i] += quantum
+                top_value += quantum
+
+    if cycle == start_cycle:
+        unit_totals = unit_values
+        total = top_value
+
+    if cycle == dvfs_cycle:
+        # Leakage is accounted at the previous power when it changes
+        current_leakage = 0.0 + leakage
+        for i in range(0, nb_units):
+            energy = current_leakage * ((dvfs_cycle - start_cycle) * period)
+            total_leakage += energy
+            unit_leakages[i] += energy
+        quantum = new_quantum
+
+current_leakage = 0.0 + leakage
+if dvfs_cycle < nb_cycles:
+    current_leakage += new_leakage - leakage
+    last_leakage_cycle = dvfs_cycle
+else:
+    last_leakage_cycle = start_cycle
+
+# The report is dumped by the last cycle
+duration = (nb_cycles - 1 - start_cycle) * period
+for i in range(0, nb_units):
+    energy = current_leakage * ((nb_cycles - 1 - last_leakage_cycle) * period)
+    total_leakage += energy
+    unit_leakages[i] += energy
+
+expected = {}
+top_power = total / duration + total_leakage / duration
+expected['power_trace'] = (total / duration, total_leakage / duration, top_power, 1.0)
+for i in range(0, nb_units):
+    dynamic = unit_totals[i] / duration
+    leakage_power = unit_leakages[i] / duration
+    expected['unit%d/power_trace' % i] = (dynamic, leakage_power, dynamic + leakage_power, (dynamic + leakage_power) / top_power)
+
+
+reported = {}
+with open(args.report) as file:
+    for line in file:
+        result = re.match(r'(\S+); ([\d.e+-]+); ([\d.e+-]+); ([\d.e+-]+); ([\d.e+-]+)$', line.strip())
+        if result is not None:
+            reported[result.group(1)] = [float(result.group(i)) for i in range(2, 6)]
+
+errors = 0
+for name, values in expected.items():
+    path = None
+    for trace in reported.keys():
+        if (trace == name or trace.endswith('/' + name)) and (name != 'power_trace' or 'unit' not in trace):
+            path = trace
+            break
+
+    if path is None:
+        print('%s: missing in report' % name)
+        errors += 1
+        continue
+
+    for index, (digits, expected_value) in enumerate(zip([12, 12, 12, 6], values)):
+        printed = float('%.*f' % (digits, expected_value))
+        if abs(reported[path][index] - printed) > args.tolerance * 10**-digits + 10**-(digits + 3):
+            print('%s: column %d differs (reported: %.*f, expected: %.*f)' % (path, index, digits, reported[path][index], digits, printed))
+            errors += 1
+
+if errors != 0:
+    print('Power report does not match the reference (errors: %d)' % errors)
+    sys.exit(1)
+
+print('Power report matches the reference (traces: %d)' % len(expected))
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+// Accounts power events on several units, like the memories do on each
+// access, to measure the cost of the power accounting and to compare the
+// power reports of the default and batched modes.
+// Each unit has its own power trace, with a read and a write event and a
+// leakage source, and a random number of events every cycle. All the unit
+// traces are collected by a top trace. The operating point is changed in the
+// middle of the capture so that folding at voltage changes is covered.
+
+class consumer : public vp::component
+{
+
+public:
+
+  consumer(const char *config);
+
+  int build();
+
+  void start();
+
+  static void exec(void *_this, vp::clock_event *event);
+
+private:
+
+  vp::clock_event *event;
+  vp::power_trace power_trace;
+  std::vector<vp::power_trace *> unit_traces;
+  std::vector<vp::power_source *> read_power;
+  std::vector<vp::power_source *> write_power;
+  std::vector<vp::power_source *> leakage_power;
+
+  int64_t nb_cycles;
+  int64_t start_cycle;
+  int64_t dvfs_cycle;
+  double dvfs_volt;
+  int64_t cycle;
+  uint32_t value;
+  struct timespec start_time;
+};
+
+void consumer::exec(void *__this, vp::clock_event *event)
+{
+  consumer *_this = (consumer *)__this;
+
+  for (unsigned int i=0; i<_this->unit_traces.size(); i++)
+  {
+    _this->value = _this->value * 1664525 + 1013904223;
+
+    for (unsigned int j=0; j<((_this->value >> 28) & 3); j++)
+    {
+      _this->read_power[i]->account_event();
+    }
+
+    for (unsigned int j=0; j<((_this->value >> 30) & 3); j++)
+    {
+      _this->write_power[i]->account_event();
+    }
+  }
+
+  if (_this->cycle == _this->start_cycle)
+  {
+    _this->power.get_engine()->start_capture();
+  }
+
+  if (_this->cycle == _this->dvfs_cycle)
+  {
+    _this->power.set_operating_point(VP_POWER_DEFAULT_TEMP, _this->dvfs_volt, VP_POWER_DEFAULT_FREQ);
+  }
+
+  _this->cycle++;
+
+  if (_this->cycle == _this->nb_cycles)
+  {
+    _this->power.get_engine()->stop_capture();
+
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double time_elapsed_in_seconds = (end_time.tv_sec - _this->start_time.tv_sec) +
+      (end_time.tv_nsec - _this->start_time.tv_nsec) / 1e9;
+    printf("%s: %ld cycles in %f s (%f Mcycles/s)\n", _this->get_path().c_str(),
+      _this->nb_cycles, time_elapsed_in_seconds, _this->nb_cycles / time_elapsed_in_seconds / 1e6);
+  }
+  else
+  {
+    _this->event_enqueue(_this->event, 1);
+  }
+}
+
+int consumer::build()
+{
+  if (power.new_trace("power_trace", &power_trace)) return -1;
+
+  int nb_units = get_config_int("nb_units");
+  for (int i=0; i<nb_units; i++)
+  {
+    std::string name = "unit" + std::to_string(i);
+    vp::power_trace *trace = new vp::power_trace();
+    vp::power_source *read = new vp::power_source();
+    vp::power_source *write = new vp::power_source();
+    vp::power_source *leakage = new vp::power_source();
+
+    if (power.new_trace(name + "/power_trace", trace)) return -1;
+    power.new_event(name + "/read", read, this->get_js_config()->get("event"), trace);
+    power.new_event(name + "/write", write, this->get_js_config()->get("event"), trace);
+    power.new_leakage_event(name + "/leakage", leakage, this->get_js_config()->get("leakage"), trace);
+
+    this->unit_traces.push_back(trace);
+    this->read_power.push_back(read);
+    this->write_power.push_back(write);
+    this->leakage_power.push_back(leakage);
+  }
+
+  event = event_new(consumer::exec);
+
+  return 0;
+}
+
+void consumer::start()
+{
+  nb_cycles = get_config_int("nb_cycles");
+  start_cycle = get_config_int("start_cycle");
+  dvfs_cycle = get_config_int("dvfs_cycle");
+  dvfs_volt = std::stod(this->get_js_config()->get("dvfs_volt")->get_str());
+  cycle = 0;
+  value = 1;
+
+  this->power_trace.collect();
+
+  for (auto leakage: this->leakage_power)
+  {
+    leakage->power_on();
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  event_enqueue(event, 1);
+}
+
+
+consumer::consumer(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new consumer(config);
+}
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import re
+import sys
+
+# Extract the sampling summary printed by each core at the end of the
+# simulation
+def get_cycles(path):
+    cores = {}
+    with open(path) as file:
+        for line in file:
+            result = re.search(r'(\S+): sampling \(instructions: (\d+), windows: (\d+), projected cycles: (\d+)\)', line)
+            if result is not None:
+                cores[result.group(1)] = (int(result.group(2)), int(result.group(4)))
+    return cores
+
+full = get_cycles(sys.argv[1])
+sampled = get_cycles(sys.argv[2])
+
+for core, (insns, cycles) in full.items():
+    if core not in sampled:
+        print('%s: missing in sampled run' % core)
+        continue
+
+    sampled_insns, sampled_cycles = sampled[core]
+    error = (sampled_cycles - cycles) * 100.0 / cycles if cycles != 0 else 0
+
+    print('%s: instructions: %d/%d, cycles: %d, projected: %d, error: %.2f%%' % (core, insns, sampled_insns, cycles, sampled_cycles, error))
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <stdio.h>
+#include <time.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+// Dumps one register event per register and per cycle, to measure the
+// throughput of the trace rings and of the event dumper thread.
+// Pulse traces can also be added, each one getting a new pulse of a
+// different duration on every cycle, to measure the queue of pending pulse
+// ends.
+// Text messages can be dumped as well, to compare the synchronous printf path
+// with the asynchronous text sink.
+
+class dumper : public vp::component
+{
+
+public:
+
+  dumper(const char *config);
+
+  int build();
+
+  void start();
+
+  static void exec(void *_this, vp::clock_event *event);
+
+private:
+
+  vp::clock_event *event;
+  std::vector<vp::reg_32 *> regs;
+  std::vector<vp::trace *> pulses;
+  vp::trace trace;
+  int nb_msgs;
+
+  int64_t nb_cycles;
+  int64_t cycle;
+  uint32_t value;
+  struct timespec start_time;
+};
+
+void dumper::exec(void *__this, vp::clock_event *event)
+{
+  dumper *_this = (dumper *)__this;
+
+  for (auto reg: _this->regs)
+  {
+    _this->value = _this->value * 1664525 + 1013904223;
+    reg->set(_this->value);
+  }
+
+  for (auto pulse: _this->pulses)
+  {
+    uint32_t zero = 0;
+    _this->value = _this->value * 1664525 + 1013904223;
+    int64_t duration = ((_this->value >> 24) + 1) * _this->get_period();
+    pulse->event_pulse(duration, (uint8_t *)&_this->value, (uint8_t *)&zero);
+  }
+
+  for (int i=0; i<_this->nb_msgs; i++)
+  {
+    _this->trace.msg("Message %d at cycle %ld (value: 0x%8.8x)\n", i, _this->cycle, _this->value);
+  }
+
+  _this->cycle++;
+
+  if (_this->cycle == _this->nb_cycles)
+  {
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double time_elapsed_in_seconds = (end_time.tv_sec - _this->start_time.tv_sec) +
+      (end_time.tv_nsec - _this->start_time.tv_nsec) / 1e9;
+    int64_t nb_events = _this->nb_cycles * (_this->regs.size() + _this->pulses.size() + _this->nb_msgs);
+    printf("%s: %ld events in %f s (%f Mevents/s)\n", _this->get_path().c_str(),
+      nb_events, time_elapsed_in_seconds, nb_events / time_elapsed_in_seconds / 1e6);
+  }
+  else
+  {
+    _this->event_enqueue(_this->event, 1);
+  }
+}
+
+int dumper::build()
+{
+  int nb_regs = get_config_int("nb_regs");
+  for (int i=0; i<nb_regs; i++)
+  {
+    vp::reg_32 *reg = new vp::reg_32();
+    this->new_reg("reg" + std::to_string(i), reg, 0);
+    this->regs.push_back(reg);
+  }
+
+  int nb_pulses = get_config_int("nb_pulses");
+  for (int i=0; i<nb_pulses; i++)
+  {
+    vp::trace *trace = new vp::trace();
+    traces.new_trace_event("pulse" + std::to_string(i), trace, 32);
+    this->pulses.push_back(trace);
+  }
+
+  this->nb_msgs = get_config_int("nb_msgs");
+  traces.new_trace("trace", &this->trace, vp::DEBUG);
+
+  event = event_new(dumper::exec);
+
+  return 0;
+}
+
+void dumper::start()
+{
+  nb_cycles = get_config_int("nb_cycles");
+  cycle = 0;
+  value = 1;
+
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  event_enqueue(event, 1);
+}
+
+
+dumper::dumper(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new dumper(config);
+}
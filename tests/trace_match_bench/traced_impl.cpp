@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <stdio.h>
+#include <time.h>
+
+// Declares many traces so that the startup time is dominated by matching
+// them against the --trace patterns. The last component to start reports
+// the time since the first one was constructed.
+
+class traced : public vp::component
+{
+
+public:
+
+  traced(const char *config);
+
+  int build();
+
+  void start();
+
+private:
+
+  std::vector<vp::trace *> comp_traces;
+};
+
+static struct timespec first_time;
+static int nb_constructed = 0;
+static int nb_started = 0;
+
+int traced::build()
+{
+  int nb_traces = get_config_int("nb_traces");
+  for (int i=0; i<nb_traces; i++)
+  {
+    vp::trace *trace = new vp::trace();
+    traces.new_trace("trace" + std::to_string(i), trace, vp::DEBUG);
+    this->comp_traces.push_back(trace);
+  }
+
+  return 0;
+}
+
+void traced::start()
+{
+  nb_started++;
+
+  if (nb_started == get_config_int("nb_comps"))
+  {
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double time_elapsed_in_seconds = (end_time.tv_sec - first_time.tv_sec) +
+      (end_time.tv_nsec - first_time.tv_nsec) / 1e9;
+    printf("Startup: %f s for %d components\n", time_elapsed_in_seconds, nb_constructed);
+  }
+}
+
+
+traced::traced(const char *config)
+: vp::component(config)
+{
+  if (nb_constructed++ == 0)
+    clock_gettime(CLOCK_MONOTONIC, &first_time);
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new traced(config);
+}
@@ -19,6 +19,29 @@ VP_COMP_DBG_LDFLAGS=-lpulpvp-debug
 VP_COMP_CFLAGS += -Werror -Wfatal-errors
 VP_COMP_LDFLAGS += -Werror -Wfatal-errors
 
+# Profile-guided optimization. The simulator is first built with
+# VP_PGO=generate and run on the training workloads of tests/pgo, which
+# dumps the profiles into VP_PGO_DIR, and is then rebuilt with VP_PGO=use.
+# The root makefile does it all with make pgo.
+VP_PGO_DIR ?= $(INSTALL_DIR)/pgo
+
+ifeq '$(VP_PGO)' 'generate'
+VP_PGO_CFLAGS = -fprofile-generate=$(VP_PGO_DIR) -fprofile-update=atomic
+endif
+ifeq '$(VP_PGO)' 'use'
+VP_PGO_CFLAGS = -fprofile-use=$(VP_PGO_DIR) -fprofile-partial-training -Wno-missing-profile
+endif
+
+VP_COMP_CFLAGS += $(VP_PGO_CFLAGS)
+VP_COMP_LDFLAGS += $(VP_PGO_CFLAGS)
+
+# With VP_TRACE_RUNTIME, traces are compiled in the default implementations
+# and enabled at runtime, instead of being compiled only in the debug
+# implementations, which are then not built
+ifdef VP_TRACE_RUNTIME
+VP_COMP_CFLAGS += -DVP_TRACE_ACTIVE=1 -DVP_TRACE_RUNTIME=1
+endif
+
 ifdef VP_USE_SYSTEMC
 VP_COMP_CFLAGS += -D__VP_USE_SYSTEMC -I$(SYSTEMC_HOME)/include
 ifdef VP_USE_SYSTEMC_DRAMSYS
@@ -104,6 +127,46 @@ endef
 
 
 
+# Static launchers link the implementations of a platform with the engine
+# into a single executable. The implementations listed in
+# VP_STATIC_IMPLEMENTATIONS are compiled with LTO, and each one is linked
+# into a relocatable object whose symbols are isolated by gvsoc-static.
+
+VP_STATIC_INSTALL_PATH ?= $(INSTALL_DIR)/lib/static
+
+VP_STATIC_CFLAGS = -flto
+
+define declare_static_implementation
+
+$(eval $(1)_STATIC_OBJS = $(patsubst %.c, $(VP_BUILD_DIR)/$(1)/static/%.o, $(patsubst %.cpp, $(VP_BUILD_DIR)/$(1)/static/%.o, $($(1)_SRCS))))
+
+-include $($(1)_STATIC_OBJS:.o=.d)
+
+$(VP_BUILD_DIR)/$(1)/static/%.o: %.cpp $($(1)_DEPS)
+	@mkdir -p `dirname $$@`
+	$(CPP) -c $$< -o $$@ $($(1)_CFLAGS) $(VP_COMP_CFLAGS) $($(1)_CPPFLAGS) $(VP_COMP_CPPFLAGS) $(VP_STATIC_CFLAGS)
+
+$(VP_BUILD_DIR)/$(1)/static/%.o: %.c $($(1)_DEPS)
+	@mkdir -p `dirname $$@`
+	$(CC) -c $$< -o $$@ $($(1)_CFLAGS) $(VP_COMP_CFLAGS) $(VP_STATIC_CFLAGS)
+
+$(VP_BUILD_DIR)/static/$(1).o: $($(1)_STATIC_OBJS) $($(1)_DEPS)
+	@mkdir -p `dirname $$@`
+	$(CPP) -r -flinker-output=nolto-rel $($(1)_STATIC_OBJS) -o $$@.rel $($(1)_CFLAGS) $(VP_COMP_CFLAGS) $(VP_STATIC_CFLAGS)
+	gvsoc-static module --name=$(1) --input=$$@.rel --output=$$@
+	echo "$($(1)_LDFLAGS)" > $$@.ldflags
+
+$(VP_STATIC_INSTALL_PATH)/$(1).o: $(VP_BUILD_DIR)/static/$(1).o
+	install -D $$^ $$@
+	install -D $$^.sym $$@.sym
+	install -D $$^.ldflags $$@.ldflags
+
+VP_STATIC_TARGETS += $(VP_STATIC_INSTALL_PATH)/$(1).o
+
+endef
+
+
+
 define declare_component
 
 $(VP_PY_INSTALL_PATH)/$(1).py: $(1).py
@@ -116,13 +179,19 @@ endef
 
 $(foreach implementation, $(IMPLEMENTATIONS), $(eval $(call declare_implementation,$(implementation))))
 
+ifndef VP_TRACE_RUNTIME
 $(foreach implementation, $(IMPLEMENTATIONS), $(eval $(call declare_debug_implementation,$(implementation))))
+endif
 
 $(foreach component, $(COMPONENTS), $(eval $(call declare_component,$(component))))
 
+$(foreach implementation, $(filter $(VP_STATIC_IMPLEMENTATIONS), $(IMPLEMENTATIONS)), $(eval $(call declare_static_implementation,$(implementation))))
+
 
 vp_build: $(VP_INSTALL_TARGETS)
 	find $(VP_PY_INSTALL_PATH) -type d -exec touch {}/__init__.py \;
 
+vp_static: $(VP_STATIC_TARGETS)
+
 vp_clean:
 	rm -rf $(VP_BUILD_DIR)